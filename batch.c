@@ -0,0 +1,478 @@
+#include "batch.h"
+
+typedef struct {
+	char output[BATCH_MAX_PATH];
+	Render_View view;
+	Uint32 width;
+	Uint32 height;
+	double cost;	// Estimated relative time to render
+} Batch_Job;
+
+typedef struct {
+	char path[BATCH_MAX_PATH];
+} Batch_Done;
+
+// An image in flight, from being computed until it's saved
+typedef struct {
+	const Batch_Job *job;	// Latest job queued in the slot, or NULL if it hasn't been used yet
+	Uint8 *pixels;
+	Uint32 capacity;		// Bytes allocated for the pixels
+	const Batch_Job *encoding_job;	// Job whose pixels the encoder is saving, since the slot moves on to the next
+	bool encoding;			// Owned by the encoder thread until it's saved
+
+	// GL backend
+	gl_frametex ftex;
+	bool have_ftex;
+	GLuint pbo;				// Read back into asynchronously, then copied to the pixels
+	Uint32 pbo_size;
+	GLsync fence;			// Signalled once the image is in the PBO
+} Batch_Slot;
+
+typedef struct {
+	Batch_Slot slots[BATCH_DEPTH];
+
+	// Slots waiting for the encoder thread, oldest first
+	SDL_mutex *lock;
+	SDL_cond *changed;		// Signalled whenever a slot is handed over in either direction
+	int queue[BATCH_DEPTH];
+	Uint32 queue_head;
+	Uint32 queue_count;
+	bool quit;
+
+	// Written by the encoder thread; the counts are under the lock
+	Pool *encode_pool;		// Each image's bands of rows are encoded on these
+	FILE *journal;
+	Uint32 saved;
+	Uint32 failed;
+	double encode_ms;
+	Uint64 encode_bytes;	// RGBA bytes encoded
+} Batch_Pipeline;
+
+
+static int __parse_colour(const char *name, Colour_Mode *mode) {
+	for (int i=0; i<COLOUR_COUNT; i++) {
+		if (SDL_strcmp(colour_mode_name(i), name) != 0) continue;
+		*mode = i;
+		return 0;
+	}
+	return 1;
+}
+
+// Reads every job in a manifest, returning NULL if any line is invalid
+static Batch_Job *__read_manifest(const char *filename, Uint32 *count) {
+	FILE *f = fopen(filename, "r");
+	if (f == NULL) {
+		printf("[ERROR] Could not open manifest '%s'\n", filename);
+		return NULL;
+	}
+
+	Batch_Job *jobs = NULL;
+	Uint32 capacity = 0;
+	*count = 0;
+
+	char line[1024];
+	int line_num = 0;
+	bool failed = false;
+	while (!failed && fgets(line, sizeof(line), f) != NULL) {
+		line_num++;
+		char *start = line;
+		while (*start == ' ' || *start == '\t') start++;
+		if (*start == '#' || *start == '\n' || *start == '\r' || *start == '\0') continue;
+
+		Batch_Job job = { 0 };
+		char kernel_name[32] = "auto";
+		char colour_name[32] = "linear";
+		double span = 0.0;
+		int matched = sscanf(start, "%255s %lf %lf %lf %u %u %u %31s %31s",
+			job.output, &job.view.screen_x, &job.view.screen_y, &span,
+			&job.width, &job.height, &job.view.iterations, kernel_name, colour_name
+		);
+
+		job.view.kernel = kernel_from_name(kernel_name);
+		if (matched < 7 || span <= 0.0 || job.width == 0 || job.height == 0 || job.width > BATCH_MAX_SIZE || job.height > BATCH_MAX_SIZE) {
+			printf("[ERROR] %s:%i: Expected 'OUTPUT X Y SPAN WIDTH HEIGHT ITERATIONS [KERNEL [COLOURING]]'\n", filename, line_num);
+			failed = true;
+		} else if (job.view.kernel == KERNEL_COUNT) {
+			printf("[ERROR] %s:%i: Unknown kernel '%s'\n", filename, line_num, kernel_name);
+			failed = true;
+		} else if (__parse_colour(colour_name, &job.view.colour) != 0) {
+			printf("[ERROR] %s:%i: Unknown colouring '%s'\n", filename, line_num, colour_name);
+			failed = true;
+		}
+		if (failed) break;
+		job.view.zoom = job.width / span;
+
+		if (*count == capacity) {
+			capacity = (capacity == 0) ? 64 : capacity * 2;
+			jobs = SDL_realloc(jobs, capacity * sizeof(Batch_Job));
+		}
+		jobs[(*count)++] = job;
+	}
+
+	fclose(f);
+	if (failed) {
+		SDL_free(jobs);
+		return NULL;
+	}
+	return jobs;
+}
+
+static int __compare_done(const void *a, const void *b) {
+	return SDL_strcmp(((const Batch_Done *) a)->path, ((const Batch_Done *) b)->path);
+}
+
+// Reads the outputs already saved by earlier runs, sorted for `__is_done()`
+static Batch_Done *__read_journal(const char *filename, Uint32 *count) {
+	*count = 0;
+	FILE *f = fopen(filename, "r");
+	if (f == NULL) return NULL;
+
+	Batch_Done *done = NULL;
+	Uint32 capacity = 0;
+	char line[BATCH_MAX_PATH + 2];
+	while (fgets(line, sizeof(line), f) != NULL) {
+		// Only whole lines count, in case the last run died mid-write
+		size_t len = SDL_strlen(line);
+		if (len == 0 || line[len - 1] != '\n') continue;
+		line[len - 1] = '\0';
+
+		if (*count == capacity) {
+			capacity = (capacity == 0) ? 64 : capacity * 2;
+			done = SDL_realloc(done, capacity * sizeof(Batch_Done));
+		}
+		SDL_strlcpy(done[(*count)++].path, line, BATCH_MAX_PATH);
+	}
+	fclose(f);
+
+	if (done != NULL) SDL_qsort(done, *count, sizeof(Batch_Done), __compare_done);
+	return done;
+}
+
+static bool __is_done(const Batch_Done *done, Uint32 count, const char *path) {
+	Uint32 lo = 0;
+	Uint32 hi = count;
+	while (lo < hi) {
+		Uint32 mid = lo + (hi - lo) / 2;
+		int cmp = SDL_strcmp(done[mid].path, path);
+		if (cmp == 0) return true;
+		if (cmp < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return false;
+}
+
+// Estimates the time a job will take from the mean iterations over a sparse grid of its pixels
+static double __estimate_cost(const Batch_Job *job, Render_Backend backend) {
+	const Render_View *v = &job->view;
+	Uint64 iters = 0;
+	for (int j=0; j<BATCH_PROBE_SIZE; j++) {
+		for (int i=0; i<BATCH_PROBE_SIZE; i++) {
+			double px = (i + 0.5) * job->width / BATCH_PROBE_SIZE;
+			double py = (j + 0.5) * job->height / BATCH_PROBE_SIZE;
+			double cx = v->screen_x + (px - job->width / 2.0) / v->zoom;
+			double cy = v->screen_y - (py - job->height / 2.0) / v->zoom;
+
+			Uint32 escape = cpu_iterate(cx, cy, v->iterations);
+			iters += (escape == RENDER_INTERIOR) ? v->iterations : escape;
+		}
+	}
+	double mean_iters = (double) iters / (BATCH_PROBE_SIZE * BATCH_PROBE_SIZE);
+
+	// The CPU does everything in doubles, so only the GL kernels differ in cost
+	double kernel_factor = 1.0;
+	if (backend != RENDER_BACKEND_CPU) {
+		Kernel_Id kernel = v->kernel;
+		if (kernel == KERNEL_AUTO) kernel = kernel_choose(v->screen_x, v->screen_y, v->zoom, job->width, job->height);
+		kernel_factor = kernel_cost(kernel);
+	}
+	return (double) job->width * job->height * (mean_iters + 1.0) * kernel_factor;
+}
+
+// Most expensive first
+static int __compare_cost(const void *a, const void *b) {
+	double ca = ((const Batch_Job *) a)->cost;
+	double cb = ((const Batch_Job *) b)->cost;
+	if (ca != cb) return (ca > cb) ? -1 : 1;
+	return 0;
+}
+
+// Saves images as they're handed over, until told to quit
+static int __encoder(void *data) {
+	Batch_Pipeline *p = data;
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+
+	SDL_LockMutex(p->lock);
+	while (true) {
+		while (p->queue_count == 0 && !p->quit) SDL_CondWait(p->changed, p->lock);
+		if (p->queue_count == 0) break;
+		Batch_Slot *s = &p->slots[p->queue[p->queue_head]];
+		p->queue_head = (p->queue_head + 1) % BATCH_DEPTH;
+		p->queue_count--;
+		SDL_UnlockMutex(p->lock);
+
+		const Batch_Job *job = s->encoding_job;
+		Uint64 start = SDL_GetPerformanceCounter();
+		int err = image_save(job->output, image_format_from_filename(job->output), s->pixels, job->width, job->height, job->width * 4, p->encode_pool);
+		p->encode_ms += (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+		p->encode_bytes += (Uint64) job->width * job->height * 4;
+
+		if (err == 0 && p->journal != NULL) {
+			fprintf(p->journal, "%s\n", job->output);
+			fflush(p->journal);
+		}
+
+		SDL_LockMutex(p->lock);
+		if (err == 0) p->saved++;
+		else {
+			printf("[ERROR] Failed to save '%s'\n", job->output);
+			p->failed++;
+		}
+		s->encoding = false;
+		SDL_CondBroadcast(p->changed);
+	}
+	SDL_UnlockMutex(p->lock);
+	return 0;
+}
+
+// Waits for the encoder to finish with a slot and makes sure it can hold a job's pixels
+static void __claim_slot(Batch_Pipeline *p, Batch_Slot *s, const Batch_Job *job) {
+	SDL_LockMutex(p->lock);
+	while (s->encoding) SDL_CondWait(p->changed, p->lock);
+	SDL_UnlockMutex(p->lock);
+
+	Uint32 size = job->width * job->height * 4;
+	if (s->capacity < size) {
+		SDL_free(s->pixels);
+		s->pixels = SDL_malloc(size);
+		s->capacity = size;
+	}
+}
+
+static void __hand_to_encoder(Batch_Pipeline *p, Batch_Slot *s) {
+	SDL_LockMutex(p->lock);
+	s->encoding = true;
+	s->encoding_job = s->job;
+	p->queue[(p->queue_head + p->queue_count) % BATCH_DEPTH] = (int) (s - p->slots);
+	p->queue_count++;
+	SDL_CondBroadcast(p->changed);
+	SDL_UnlockMutex(p->lock);
+}
+
+// Queues the compute and readback of a job, without waiting for either
+static void __gl_queue(Batch_Slot *s, const Batch_Job *job) {
+	if (!s->have_ftex || s->ftex.w != job->width || s->ftex.h != job->height) {
+		if (s->have_ftex) gl_destroy_frametex(s->ftex);
+		s->ftex = gl_create_frametex(job->width, job->height);
+		s->have_ftex = true;
+	}
+	Uint32 size = job->width * job->height * 4;
+	if (s->pbo_size < size) {
+		if (s->pbo != 0) glDeleteBuffers(1, &s->pbo);
+		glCreateBuffers(1, &s->pbo);
+		glNamedBufferStorage(s->pbo, size, NULL, 0);
+		s->pbo_size = size;
+	}
+
+	const Render_View *v = &job->view;
+	kernel_dispatch(v->kernel, s->ftex, v->screen_x, v->screen_y, v->zoom, v->iterations);
+	colour_apply(v->colour, s->ftex, v->iterations);
+
+	glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, s->pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glGetTextureImage(s->ftex.tex, 0, GL_RGBA, GL_UNSIGNED_BYTE, size, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	s->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	gl_check_err("Failed to queue batch job");
+
+	s->job = job;
+}
+
+// Waits for a queued job's readback and hands it to the encoder
+static void __gl_collect(Batch_Pipeline *p, Batch_Slot *s) {
+	glClientWaitSync(s->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(s->fence);
+	s->fence = NULL;
+
+	__claim_slot(p, s, s->job);
+	glGetNamedBufferSubData(s->pbo, 0, s->job->width * s->job->height * 4, s->pixels);
+	gl_check_err("Failed to read back batch job");
+	__hand_to_encoder(p, s);
+}
+
+static void __cpu_render(Batch_Pipeline *p, Batch_Slot *s, const Batch_Job *job, Render_Handle *h) {
+	__claim_slot(p, s, job);
+	s->job = job;
+	Render_Target target = { s->pixels, job->width, job->height, job->width * 4, RENDER_FORMAT_RGBA8 };
+	render_frame(h, &job->view, &target);
+	__hand_to_encoder(p, s);
+}
+
+static void __print_progress(Batch_Pipeline *p, Uint32 total, Uint64 start) {
+	SDL_LockMutex(p->lock);
+	Uint32 saved = p->saved;
+	SDL_UnlockMutex(p->lock);
+
+	double s = (double) (SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+	printf("---> %u/%u images saved (%.2lf images/s)\n", saved, total, (s > 0.0) ? saved / s : 0.0);
+	fflush(stdout);
+}
+
+
+int batch_main(int argc, char *argv[]) {
+	const char *manifest = NULL;
+	Render_Backend backend = RENDER_BACKEND_GL;
+	int threads = 0;
+	int encode_threads = 0;
+	bool restart = false;
+
+	// Parse options
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--backend") == 0 && has_val) {
+			const char *name = argv[++i];
+			backend = RENDER_BACKEND_COUNT;
+			for (int b=0; b<RENDER_BACKEND_COUNT; b++) {
+				if (SDL_strcmp(render_backend_name(b), name) == 0) backend = b;
+			}
+			if (backend == RENDER_BACKEND_COUNT) {
+				printf("[ERROR] Unknown backend '%s'\n", name);
+				return 1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--threads") == 0 && has_val) threads = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--encode-threads") == 0 && has_val) encode_threads = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--restart") == 0) restart = true;
+		else if (manifest == NULL && argv[i][0] != '-') manifest = argv[i];
+		else {
+			printf("[ERROR] Unknown batch option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (manifest == NULL) {
+		puts("[ERROR] No manifest given");
+		return 1;
+	}
+
+	Uint32 job_count = 0;
+	Batch_Job *jobs = __read_manifest(manifest, &job_count);
+	if (jobs == NULL) return 1;
+	if (SDL_Init(0) < 0) {
+		SDL_free(jobs);
+		return 1;
+	}
+
+	Render_Handle *h = render_create(backend);
+	if (h == NULL) {
+		printf("[ERROR] Failed to create the %s renderer\n", render_backend_name(backend));
+		SDL_free(jobs);
+		SDL_Quit();
+		return 1;
+	}
+	render_set_threads(h, threads);
+
+	// Skip what earlier runs already saved
+	char journal_filename[BATCH_MAX_PATH + sizeof(BATCH_JOURNAL_SUFFIX)];
+	SDL_snprintf(journal_filename, sizeof(journal_filename), "%s%s", manifest, BATCH_JOURNAL_SUFFIX);
+	Uint32 done_count = 0;
+	Batch_Done *done = restart ? NULL : __read_journal(journal_filename, &done_count);
+
+	Uint32 pending = 0;
+	Uint32 skipped = 0;
+	Uint32 unavailable = 0;
+	for (Uint32 i=0; i<job_count; i++) {
+		Batch_Job *job = &jobs[i];
+		if (__is_done(done, done_count, job->output)) {
+			skipped++;
+			continue;
+		}
+		if (backend != RENDER_BACKEND_CPU && job->view.kernel != KERNEL_AUTO && !kernel_available(job->view.kernel)) {
+			printf("[ERROR] The %s kernel isn't available, so '%s' can't be rendered\n", kernel_name(job->view.kernel), job->output);
+			unavailable++;
+			continue;
+		}
+		job->cost = __estimate_cost(job, backend);
+		jobs[pending++] = *job;
+	}
+	SDL_free(done);
+	SDL_qsort(jobs, pending, sizeof(Batch_Job), __compare_cost);
+
+	printf("---> Rendering %u of %u images in '%s' with the %s renderer (%u already done)\n",
+		pending, job_count, manifest, render_backend_name(backend), skipped
+	);
+	fflush(stdout);
+
+	// Start the pipeline
+	Batch_Pipeline *p = SDL_calloc(1, sizeof(Batch_Pipeline));
+	p->lock = SDL_CreateMutex();
+	p->changed = SDL_CreateCond();
+	p->journal = fopen(journal_filename, restart ? "w" : "a");
+	if (p->journal == NULL) printf("[WARN ] Couldn't open '%s', so this run can't be resumed\n", journal_filename);
+	p->encode_pool = pool_create(encode_threads);
+	SDL_Thread *encoder = SDL_CreateThread(__encoder, "batch_encoder", p);
+
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint64 last_progress = start;
+	Uint64 pixels = 0;
+	for (Uint32 i=0; i<pending; i++) {
+		Batch_Slot *s = &p->slots[i % BATCH_DEPTH];
+		if (backend == RENDER_BACKEND_GL) {
+			// The slot's last job was queued BATCH_DEPTH jobs ago, so it's probably done by now
+			if (s->job != NULL) __gl_collect(p, s);
+			__gl_queue(s, &jobs[i]);
+		} else {
+			__cpu_render(p, s, &jobs[i], h);
+		}
+		pixels += (Uint64) jobs[i].width * jobs[i].height;
+
+		if ((SDL_GetPerformanceCounter() - last_progress) / ticks_per_ms >= BATCH_PROGRESS_MS) {
+			__print_progress(p, pending, start);
+			last_progress = SDL_GetPerformanceCounter();
+		}
+	}
+
+	// Drain the pipeline, oldest first
+	if (backend == RENDER_BACKEND_GL) {
+		for (Uint32 i=0; i<BATCH_DEPTH; i++) {
+			Batch_Slot *s = &p->slots[(pending + i) % BATCH_DEPTH];
+			if (s->fence != NULL) __gl_collect(p, s);
+		}
+	}
+	SDL_LockMutex(p->lock);
+	p->quit = true;
+	SDL_CondBroadcast(p->changed);
+	SDL_UnlockMutex(p->lock);
+	SDL_WaitThread(encoder, NULL);
+	double total_ms = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+
+	double s = total_ms / 1000.0;
+	printf("---> Saved %u images in %.2lf s: %.2lf images/s, %.1lf Mpixel/s\n",
+		p->saved, s, (s > 0.0) ? p->saved / s : 0.0, (s > 0.0) ? pixels / s / 1.0e6 : 0.0
+	);
+	double encode_mb_per_s = (p->encode_ms > 0.0) ? p->encode_bytes / 1.0e3 / p->encode_ms : 0.0;
+	printf("      Encoding took %.1lf ms on %i threads, overlapped with rendering: %.1lf MB/s, %.1lf MB/s per thread\n",
+		p->encode_ms, pool_threads(p->encode_pool), encode_mb_per_s, encode_mb_per_s / pool_threads(p->encode_pool)
+	);
+	if (p->failed + unavailable > 0) printf("[WARN ] %u images failed\n", p->failed + unavailable);
+	fflush(stdout);
+	int result = (p->failed + unavailable > 0) ? 1 : 0;
+
+	// Clean up
+	if (p->journal != NULL) fclose(p->journal);
+	pool_destroy(p->encode_pool);
+	for (int i=0; i<BATCH_DEPTH; i++) {
+		Batch_Slot *slot = &p->slots[i];
+		SDL_free(slot->pixels);
+		if (slot->have_ftex) gl_destroy_frametex(slot->ftex);
+		if (slot->pbo != 0) glDeleteBuffers(1, &slot->pbo);
+	}
+	SDL_DestroyCond(p->changed);
+	SDL_DestroyMutex(p->lock);
+	SDL_free(p);
+	SDL_free(jobs);
+	render_destroy(h);
+	SDL_Quit();
+	return result;
+}
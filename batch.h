@@ -0,0 +1,58 @@
+//	
+//	Batch rendering of many images from a manifest
+//	
+//	Every job in the manifest is rendered with the same renderer, so
+//	the GL context (or thread pool) and compiled kernels stay warm
+//	from one image to the next. Up to BATCH_DEPTH images are in flight
+//	at once: while one is being saved on the encoder thread, the
+//	next is being read back and the ones after it are being computed.
+//	
+//	Jobs are run most expensive first, with the cost estimated from
+//	a sparse grid of sample points, so the pipeline drains on small
+//	images rather than waiting on one big one at the end. Each saved
+//	image is recorded in a journal next to the manifest, so a batch
+//	that was interrupted carries on where it left off when rerun.
+//	
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "kernel.h"
+#include "colour.h"
+#include "render.h"
+#include "cpu.h"
+#include "image.h"
+
+#define BATCH_DEPTH 3				// Images in flight at once
+#define BATCH_MAX_PATH 256
+#define BATCH_MAX_SIZE 16384		// Largest width or height of an image
+#define BATCH_PROBE_SIZE 8			// Cost is estimated from a grid of this many points squared
+#define BATCH_JOURNAL_SUFFIX ".done"
+#define BATCH_PROGRESS_MS 1000		// Time between progress reports
+
+
+//	Renders every job in a manifest (`mandelbrot.exe --batch MANIFEST ...`)
+//	
+//	`argv[0]` is expected to be the "--batch" switch itself.
+//	The manifest has one job per line, with blank lines and lines
+//	starting with '#' ignored:
+//		OUTPUT X Y SPAN WIDTH HEIGHT ITERATIONS [KERNEL [COLOURING]]
+//	where X/Y is the centre of the view and SPAN is its width on the
+//	complex plane. KERNEL and COLOURING are names as printed by the
+//	app (e.g. "dfloat", "histogram") and default to "auto" and
+//	"linear". Images are saved as PNG or QOI if OUTPUT ends with
+//	".png" or ".qoi", and as .bmp otherwise.
+//	Options:
+//		--backend gl|cpu|hybrid  Renderer to use (default gl)
+//		--threads N       Threads for the CPU renderer (default one per core)
+//		--encode-threads N  Threads PNGs and QOIs are encoded on (default one per core)
+//		--restart         Ignores the journal and renders every job again
+//	Returns the exit code for the program.
+int batch_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,481 @@
+#include "bench.h"
+
+#define MAX_RESULTS (64 * (KERNEL_COUNT + BENCH_CPU_RUNS) + RENDER_BACKEND_COUNT + BENCH_ENCODE_RUNS)
+
+typedef struct {
+	const Bench_Scene *scene;
+	double zoom;
+	Kernel_Id kernel;		// GL kernel to run, if `cpu` is NULL
+	gl_frametex ftex;
+	Render_Handle *cpu;		// CPU renderer to run instead of a kernel
+	Kernel_Id cpu_kernel;	// Number format for the CPU renderer
+	Render_Target target;	// Buffer for the CPU renderer
+} Bench_Run;
+
+#define MANDELBROT(n) { KERNEL_MANDELBROT, n, 0.0, 0.0 }
+#define JULIA(n, x, y) { KERNEL_JULIA, n, x, y }
+
+// Every power of both fractals has a scene, so each kernel variant gets timed
+static const Bench_Scene __scenes[] = {
+	{ "full_exterior",   1.0,                  1.0,          1.0,     1000, MANDELBROT(2) },
+	{ "seahorse_200",   -0.7436,               0.1318,       0.01,    200,  MANDELBROT(2) },
+	{ "seahorse_1000",  -0.7436,               0.1318,       0.01,    1000, MANDELBROT(2) },
+	{ "seahorse_10000", -0.7436,               0.1318,       0.01,    10000, MANDELBROT(2) },
+	{ "mostly_interior", -0.2,                 0.0,          0.4,     1000, MANDELBROT(2) },
+	{ "minibrot_1e12",  -1.9999964703350086,   0.0,          4.0e-12, 2000, MANDELBROT(2) },
+	{ "multibrot_3",     0.0,                  0.0,          3.0,     1000, MANDELBROT(3) },
+	{ "multibrot_4",     0.0,                  0.0,          3.0,     1000, MANDELBROT(4) },
+	{ "multibrot_5",     0.0,                  0.0,          3.0,     1000, MANDELBROT(5) },
+	{ "multibrot_6",     0.0,                  0.0,          3.0,     1000, MANDELBROT(6) },
+	{ "multibrot_7",     0.0,                  0.0,          3.0,     1000, MANDELBROT(7) },
+	{ "multibrot_8",     0.0,                  0.0,          3.0,     1000, MANDELBROT(8) },
+	{ "julia_2",         0.0,                  0.0,          3.0,     1000, JULIA(2, -0.8, 0.156) },
+	{ "julia_3",         0.0,                  0.0,          3.0,     1000, JULIA(3, -0.1, 0.65) },
+	{ "julia_4",         0.0,                  0.0,          3.0,     1000, JULIA(4, 0.45, 0.25) },
+	{ "julia_5",         0.0,                  0.0,          3.0,     1000, JULIA(5, 0.6, 0.2) },
+	{ "julia_6",         0.0,                  0.0,          3.0,     1000, JULIA(6, -0.7, 0.2) },
+	{ "julia_7",         0.0,                  0.0,          3.0,     1000, JULIA(7, 0.65, 0.3) },
+	{ "julia_8",         0.0,                  0.0,          3.0,     1000, JULIA(8, -0.6, 0.4) },
+};
+#define NUM_SCENES (int)(sizeof(__scenes) / sizeof(__scenes[0]))
+
+// Names the CPU renderer is reported under, in doubles then double-floats
+static const char *__cpu_names[BENCH_CPU_RUNS] = { BENCH_CPU_NAME, BENCH_CPU_NAME "_dfloat" };
+
+static int __cmp_double(const void *a, const void *b) {
+	double da = *(const double *) a;
+	double db = *(const double *) b;
+	return (da > db) - (da < db);
+}
+
+// Renders one frame of a scene and waits for it, returning its pixel-iterations
+static Uint64 __render_once(Bench_Run *run) {
+	const Bench_Scene *scene = run->scene;
+
+	if (run->cpu != NULL) {
+		Render_View view = { scene->screen_x, scene->screen_y, run->zoom, scene->iterations, run->cpu_kernel, COLOUR_LINEAR };
+		render_frame(run->cpu, &view, &run->target);
+		return render_last_iterations(run->cpu);
+	}
+
+	kernel_dispatch(run->kernel, run->ftex, scene->screen_x, scene->screen_y, run->zoom, scene->iterations);
+	return kernel_read_iterations();
+}
+
+// Times one scene with one kernel (or the CPU renderer)
+static void __run_scene(Bench_Run *run, int runs, Bench_Result *result) {
+	double *times = SDL_malloc(sizeof(double) * runs);
+
+	// Warm up once so shader compilation and clocks don't skew the first run,
+	// and count how much work a frame of this scene takes with this kernel
+	kernel_read_iterations();
+	double pixel_iters = (double) __render_once(run);
+
+	// Wall-clock time until the frame is done, since timer queries aren't reliable on every driver
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+	for (int r=0; r<runs; r++) {
+		Uint64 start = SDL_GetPerformanceCounter();
+		__render_once(run);
+		times[r] = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+	}
+	gl_check_err("Failed to time benchmark scene");
+
+	SDL_qsort(times, runs, sizeof(double), __cmp_double);
+	int p95_index = (int) SDL_ceil(0.95 * runs) - 1;
+	if (p95_index < 0) p95_index = 0;
+
+	SDL_strlcpy(result->scene, run->scene->name, BENCH_MAX_NAME);
+	SDL_strlcpy(result->kernel, (run->cpu != NULL) ? __cpu_names[run->cpu_kernel == KERNEL_DFLOAT] : kernel_name(run->kernel), BENCH_MAX_NAME);
+	result->median_ms = times[runs / 2];
+	result->p95_ms = times[p95_index];
+	result->giters_per_s = 0.0;
+	if (result->median_ms > 0.0) result->giters_per_s = pixel_iters / (result->median_ms / 1000.0) / 1.0e9;
+
+	SDL_free(times);
+}
+
+// Times the histogram colouring pass on its own, on the GPU and the CPU
+static int __run_histogram(gl_frametex ftex, Render_Target target, int runs, const char *only_kernel, Bench_Result *results) {
+	const Bench_Scene *scene = &__scenes[BENCH_HISTOGRAM_SCENE];
+	double zoom = ftex.w / scene->width;
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+	double *times = SDL_malloc(sizeof(double) * runs);
+	int count = 0;
+
+	// Something to colour
+	kernel_set_formula(scene->formula);
+	kernel_dispatch(KERNEL_FLOAT, ftex, scene->screen_x, scene->screen_y, zoom, scene->iterations);
+	kernel_read_iterations();
+	Uint32 *escapes = SDL_malloc((size_t) ftex.w * ftex.h * sizeof(Uint32));
+	glGetTextureImage(ftex.escape, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, ftex.w * ftex.h * sizeof(Uint32), escapes);
+	Render_Target escape = { escapes, ftex.w, ftex.h, ftex.w * 4, RENDER_FORMAT_ESCAPE };
+	Pool *pool = pool_create(0);
+
+	for (int b=0; b<RENDER_BACKEND_COUNT; b++) {
+		const char *name = render_backend_name(b);
+		if (only_kernel != NULL && SDL_strcmp(only_kernel, name) != 0) continue;
+		if (b == RENDER_BACKEND_HYBRID) continue;	// Colours on the GPU, the same as GL
+
+		for (int r=-1; r<runs; r++) {
+			Uint64 start = SDL_GetPerformanceCounter();
+			if (b == RENDER_BACKEND_GL) {
+				colour_apply(COLOUR_HISTOGRAM, ftex, scene->iterations);
+				glFinish();
+			} else {
+				cpu_colour_histogram(pool, &escape, &target, scene->iterations);
+			}
+			if (r >= 0) times[r] = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;	// Run -1 warms up
+		}
+
+		SDL_qsort(times, runs, sizeof(double), __cmp_double);
+		int p95_index = SDL_max((int) SDL_ceil(0.95 * runs) - 1, 0);
+		Bench_Result *result = &results[count++];
+		SDL_strlcpy(result->scene, BENCH_HISTOGRAM_NAME, BENCH_MAX_NAME);
+		SDL_strlcpy(result->kernel, name, BENCH_MAX_NAME);
+		result->median_ms = times[runs / 2];
+		result->p95_ms = times[p95_index];
+		result->giters_per_s = 0.0;
+	}
+	gl_check_err("Failed to time histogram colouring");
+
+	pool_destroy(pool);
+	SDL_free(escapes);
+	SDL_free(times);
+	return count;
+}
+
+// Times encoding a rendered frame to every format but BMP, on one thread and then on every core
+static int __run_encode(Render_Handle *cpu, Render_Target target, int runs, const char *only_kernel, Bench_Result *results, size_t *encoded) {
+	const Bench_Scene *scene = &__scenes[BENCH_HISTOGRAM_SCENE];
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+	double *times = SDL_malloc(sizeof(double) * runs);
+	int count = 0;
+
+	// Something to encode
+	kernel_set_formula(scene->formula);
+	Render_View view = { scene->screen_x, scene->screen_y, target.width / scene->width, scene->iterations, KERNEL_DOUBLE, COLOUR_LINEAR };
+	render_frame(cpu, &view, &target);
+	Pool *single = pool_create(1);
+	Pool *all = pool_create(0);
+
+	for (int f=IMAGE_BMP + 1; f<IMAGE_FORMAT_COUNT; f++) {
+		for (int p=0; p<2; p++) {
+			Pool *pool = (p == 0) ? single : all;
+			char name[BENCH_MAX_NAME];
+			SDL_snprintf(name, sizeof(name), (p == 0) ? "%s_1t" : "%s", image_format_name(f));
+			if (only_kernel != NULL && SDL_strcmp(only_kernel, name) != 0) continue;
+
+			size_t size = 0;
+			for (int r=-1; r<runs; r++) {
+				Uint64 start = SDL_GetPerformanceCounter();
+				Uint8 *file = image_encode(f, target.pixels, target.width, target.height, target.stride, false, pool, &size);
+				if (r >= 0) times[r] = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;	// Run -1 warms up
+				SDL_free(file);
+			}
+
+			SDL_qsort(times, runs, sizeof(double), __cmp_double);
+			int p95_index = SDL_max((int) SDL_ceil(0.95 * runs) - 1, 0);
+			encoded[count] = size;
+			Bench_Result *result = &results[count++];
+			SDL_strlcpy(result->scene, BENCH_ENCODE_NAME, BENCH_MAX_NAME);
+			SDL_strlcpy(result->kernel, name, BENCH_MAX_NAME);
+			result->median_ms = times[runs / 2];
+			result->p95_ms = times[p95_index];
+			result->giters_per_s = 0.0;
+		}
+	}
+
+	pool_destroy(single);
+	pool_destroy(all);
+	SDL_free(times);
+	return count;
+}
+
+// Prints the throughput and compression of each encoder
+static void __report_encode(Bench_Result *results, int count, const size_t *encoded, Render_Target target) {
+	if (count == 0) return;
+	double mb = (double) target.width * target.height * 4 / 1.0e6;
+	int cores = SDL_GetCPUCount();
+
+	printf("---> Encoding a %ux%u frame (%.1lf MB), %i core(s):\n", target.width, target.height, mb, cores);
+	printf("      %-16s %10s %10s %10s\n", "Encoder", "MB/s", "MB/s/core", "Size");
+	for (int i=0; i<count; i++) {
+		Bench_Result *r = &results[i];
+		if (r->median_ms <= 0.0) continue;
+		int threads = SDL_strstr(r->kernel, "_1t") != NULL ? 1 : cores;
+		double rate = mb / (r->median_ms / 1000.0);
+		printf("      %-16s %10.1lf %10.1lf %9.1lf%%\n", r->kernel, rate, rate / threads, encoded[i] / (mb * 1.0e6) * 100.0);
+	}
+	fflush(stdout);
+}
+
+// Finds the result for a scene and kernel, or NULL if it wasn't run
+static Bench_Result *__find_result(Bench_Result *results, int count, const char *scene, const char *kernel) {
+	for (int i=0; i<count; i++) {
+		if (SDL_strcmp(results[i].scene, scene) == 0 && SDL_strcmp(results[i].kernel, kernel) == 0) return &results[i];
+	}
+	return NULL;
+}
+
+// Compares the frame times of the persistent kernel against launching a workgroup per pixel
+static void __compare_tail(Bench_Result *results, int count) {
+	const char *plain = kernel_name(KERNEL_FLOAT);
+	const char *persistent = kernel_name(KERNEL_PERSISTENT);
+	bool header = false;
+
+	for (int s=0; s<NUM_SCENES; s++) {
+		Bench_Result *a = __find_result(results, count, __scenes[s].name, plain);
+		Bench_Result *b = __find_result(results, count, __scenes[s].name, persistent);
+		if (a == NULL || b == NULL || a->median_ms <= 0.0 || b->median_ms <= 0.0 || a->p95_ms <= 0.0) continue;
+
+		if (!header) {
+			printf("---> Tail latency of %s against %s (p95 / median):\n", persistent, plain);
+			printf("      %-16s %10s %10s %10s %10s\n", "Scene", "Median", "p95", "Tail", "Tail");
+			printf("      %-16s %10s %10s %10s %10s\n", "", "change", "change", plain, persistent);
+			header = true;
+		}
+		printf("      %-16s %+9.1lf%% %+9.1lf%% %10.3lf %10.3lf\n", __scenes[s].name,
+			(b->median_ms / a->median_ms - 1.0) * 100.0, (b->p95_ms / a->p95_ms - 1.0) * 100.0,
+			a->p95_ms / a->median_ms, b->p95_ms / b->median_ms
+		);
+	}
+}
+
+// Compares results to a baseline and returns the number of regressions
+static int __compare_baseline(Bench_Result *results, int count, Bench_Result *baseline, int base_count, double threshold) {
+	int regressions = 0;
+
+	puts("---> Comparison against baseline:");
+	for (int i=0; i<count; i++) {
+		Bench_Result *r = &results[i];
+		Bench_Result *b = NULL;
+		for (int j=0; j<base_count; j++) {
+			if (SDL_strcmp(baseline[j].scene, r->scene) != 0) continue;
+			if (SDL_strcmp(baseline[j].kernel, r->kernel) != 0) continue;
+			b = &baseline[j];
+			break;
+		}
+
+		if (b == NULL || b->median_ms <= 0.0) {
+			printf("      %-16s %-10s      (no baseline)\n", r->scene, r->kernel);
+			continue;
+		}
+
+		double change = (r->median_ms / b->median_ms - 1.0) * 100.0;
+		bool regressed = change > threshold;
+		if (regressed) regressions++;
+		printf("      %-16s %-10s %+8.2lf%%%s\n", r->scene, r->kernel, change, regressed ? "  <-- REGRESSION" : "");
+	}
+
+	return regressions;
+}
+
+
+int bench_main(int argc, char *argv[]) {
+	int size = BENCH_DEFAULT_SIZE;
+	int runs = BENCH_DEFAULT_RUNS;
+	double threshold = BENCH_DEFAULT_THRESHOLD;
+	const char *only_kernel = NULL;
+	const char *only_scene = NULL;
+	const char *out_filename = BENCH_RESULTS_FILENAME;
+	const char *baseline_filename = BENCH_BASELINE_FILENAME;
+	bool save_baseline = false;
+	int tile_size = KERNEL_TILE_SIZE;
+	Kernel_Tile_Order order = KERNEL_ORDER_ROWS;
+	int groups = KERNEL_PERSISTENT_GROUPS;
+
+	// Parse options
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--size") == 0 && has_val) size = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--runs") == 0 && has_val) runs = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--kernel") == 0 && has_val) only_kernel = argv[++i];
+		else if (SDL_strcmp(argv[i], "--scene") == 0 && has_val) only_scene = argv[++i];
+		else if (SDL_strcmp(argv[i], "--out") == 0 && has_val) out_filename = argv[++i];
+		else if (SDL_strcmp(argv[i], "--baseline") == 0 && has_val) baseline_filename = argv[++i];
+		else if (SDL_strcmp(argv[i], "--threshold") == 0 && has_val) threshold = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--save-baseline") == 0) save_baseline = true;
+		else if (SDL_strcmp(argv[i], "--tile") == 0 && has_val) tile_size = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--order") == 0 && has_val) order = kernel_order_from_name(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--groups") == 0 && has_val) groups = SDL_atoi(argv[++i]);
+		else {
+			printf("[ERROR] Unknown benchmark option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (size <= 0 || runs <= 0) {
+		puts("[ERROR] Benchmark size and runs must be positive");
+		return 1;
+	}
+	if (tile_size <= 0 || groups <= 0 || order == KERNEL_ORDER_COUNT) {
+		puts("[ERROR] Tile size and groups must be positive, and the order one of rows, morton or centre");
+		return 1;
+	}
+
+	// Set up a hidden window just to get a GL context
+	if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+		printf("[ERROR] Failed to initialise SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_Window *window = SDL_CreateWindow(
+		"Mandelbrot Benchmark",
+		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+		size, size,
+		SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+	);
+	if (window == NULL) {
+		printf("[ERROR] Failed to create Window: %s\n", SDL_GetError());
+		return 1;
+	}
+	gl_init(4, 5, window);
+	gl_frametex ftex = gl_create_frametex(size, size);
+	kernel_set_tiling(tile_size, order, groups);
+
+	// The CPU renderer writes into a plain buffer
+	Render_Handle *cpu = render_create(RENDER_BACKEND_CPU);
+	Render_Target target = { SDL_malloc((size_t) size * size * 4), size, size, size * 4, RENDER_FORMAT_RGBA8 };
+
+	// Run every scene against every kernel
+	Bench_Result *results = SDL_malloc(sizeof(Bench_Result) * MAX_RESULTS);
+	int count = 0;
+	printf("---> Benchmarking at %ix%i, %i runs each\n", size, size, runs);
+	printf("---> Persistent kernel: %i workgroups, %ix%i tiles in %s order\n", groups, tile_size, tile_size, kernel_order_name(order));
+	printf("      %-16s %-10s %10s %10s %10s\n", "Scene", "Kernel", "Median ms", "p95 ms", "Giter/s");
+
+	for (int s=0; s<NUM_SCENES; s++) {
+		const Bench_Scene *scene = &__scenes[s];
+		if (only_scene != NULL && SDL_strcmp(only_scene, scene->name) != 0) continue;
+		kernel_set_formula(scene->formula);
+
+		// Every GL kernel, then the CPU renderer in doubles and double-floats
+		for (int k=0; k<KERNEL_COUNT + BENCH_CPU_RUNS && count<MAX_RESULTS; k++) {
+			bool is_cpu = (k >= KERNEL_COUNT);
+			const char *name = is_cpu ? __cpu_names[k - KERNEL_COUNT] : kernel_name(k);
+			if (only_kernel != NULL && SDL_strcmp(only_kernel, name) != 0) continue;
+			if (!is_cpu && !kernel_available(k)) continue;
+
+			Bench_Run run = {
+				.scene = scene,
+				.zoom = size / scene->width,
+				.kernel = k,
+				.ftex = ftex,
+				.cpu = is_cpu ? cpu : NULL,
+				.cpu_kernel = (k == KERNEL_COUNT + 1) ? KERNEL_DFLOAT : KERNEL_DOUBLE,
+				.target = target,
+			};
+			Bench_Result *r = &results[count++];
+			__run_scene(&run, runs, r);
+
+			printf("      %-16s %-10s %10.3lf %10.3lf %10.3lf\n", r->scene, r->kernel, r->median_ms, r->p95_ms, r->giters_per_s);
+			fflush(stdout);
+		}
+	}
+
+	if (only_scene == NULL || SDL_strcmp(only_scene, BENCH_HISTOGRAM_NAME) == 0) {
+		int added = __run_histogram(ftex, target, runs, only_kernel, &results[count]);
+		for (int i=count; i<count + added; i++) {
+			Bench_Result *r = &results[i];
+			printf("      %-16s %-10s %10.3lf %10.3lf %10s\n", r->scene, r->kernel, r->median_ms, r->p95_ms, "-");
+		}
+		count += added;
+		fflush(stdout);
+	}
+
+	if (only_scene == NULL || SDL_strcmp(only_scene, BENCH_ENCODE_NAME) == 0) {
+		size_t encoded[BENCH_ENCODE_RUNS];
+		int added = __run_encode(cpu, target, runs, only_kernel, &results[count], encoded);
+		for (int i=count; i<count + added; i++) {
+			Bench_Result *r = &results[i];
+			printf("      %-16s %-10s %10.3lf %10.3lf %10s\n", r->scene, r->kernel, r->median_ms, r->p95_ms, "-");
+		}
+		__report_encode(&results[count], added, encoded, target);
+		count += added;
+	}
+
+	__compare_tail(results, count);
+
+	// Store and compare results
+	if (bench_write_results(out_filename, results, count, size) != 0) {
+		printf("---> Failed to write results to '%s'\n", out_filename);
+	} else {
+		printf("---> Wrote results to '%s'\n", out_filename);
+	}
+
+	int regressions = 0;
+	Bench_Result *baseline = SDL_malloc(sizeof(Bench_Result) * MAX_RESULTS);
+	int base_size = 0;
+	int base_count = bench_read_results(baseline_filename, baseline, MAX_RESULTS, &base_size);
+	if (base_count < 0) {
+		printf("---> No baseline found at '%s'\n", baseline_filename);
+	} else if (base_size != size) {
+		// Frame times scale with the pixel count, so every kernel would look regressed or improved
+		printf("[WARN ] Baseline '%s' was taken at %ix%i, not %ix%i; skipping the comparison\n", baseline_filename, base_size, base_size, size, size);
+	} else {
+		regressions = __compare_baseline(results, count, baseline, base_count, threshold);
+		printf("---> %i regression(s) beyond %.1lf%%\n", regressions, threshold);
+	}
+	SDL_free(baseline);
+
+	if (save_baseline) {
+		if (bench_write_results(baseline_filename, results, count, size) == 0) {
+			printf("---> Saved results as the new baseline '%s'\n", baseline_filename);
+		}
+	}
+	fflush(stdout);
+
+	// Clean up
+	SDL_free(results);
+	SDL_free(target.pixels);
+	render_destroy(cpu);
+	gl_destroy_frametex(ftex);
+	kernel_term();
+	gl_term();
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return regressions > 0 ? 1 : 0;
+}
+
+int bench_write_results(const char *filename, Bench_Result *results, int count, int size) {
+	if (filename == NULL) return 1;
+
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) return 1;
+
+	// One result per line, so it can be read back without a JSON parser
+	fprintf(f, "{\n\t\"size\": %i,\n\t\"results\": [\n", size);
+	for (int i=0; i<count; i++) {
+		Bench_Result *r = &results[i];
+		fprintf(f, "\t\t{\"scene\": \"%s\", \"kernel\": \"%s\", \"median_ms\": %.6lf, \"p95_ms\": %.6lf, \"giters_per_s\": %.6lf}%s\n",
+			r->scene, r->kernel, r->median_ms, r->p95_ms, r->giters_per_s,
+			(i < count - 1) ? "," : ""
+		);
+	}
+	fprintf(f, "\t]\n}\n");
+
+	fclose(f);
+	return 0;
+}
+
+int bench_read_results(const char *filename, Bench_Result *results, int max, int *size) {
+	*size = 0;
+	if (filename == NULL) return -1;
+
+	FILE *f = fopen(filename, "r");
+	if (f == NULL) return -1;
+
+	int count = 0;
+	char line[512];
+	while (count < max && fgets(line, sizeof(line), f) != NULL) {
+		if (sscanf(line, " \"size\": %i", size) == 1) continue;
+
+		Bench_Result r;
+		int matched = sscanf(line,
+			" {\"scene\": \"%31[^\"]\", \"kernel\": \"%31[^\"]\", \"median_ms\": %lf, \"p95_ms\": %lf, \"giters_per_s\": %lf",
+			r.scene, r.kernel, &r.median_ms, &r.p95_ms, &r.giters_per_s
+		);
+		if (matched == 5) results[count++] = r;
+	}
+
+	fclose(f);
+	return count;
+}
@@ -0,0 +1,93 @@
+//	
+//	Standard scene benchmark suite
+//	
+//	Renders a fixed set of scenes with every available kernel
+//	and the CPU renderer, times the histogram colouring pass and
+//	the PNG and QOI encoders, reports the median/p95 frame time
+//	and iteration throughput, and compares the results against a
+//	stored baseline so that performance regressions can be caught
+//	automatically.
+//	
+//	The tail latency of the persistent kernel is also compared
+//	against launching a workgroup per pixel with the float kernel.
+//	
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "kernel.h"
+#include "render.h"
+#include "colour.h"
+#include "cpu.h"
+#include "image.h"
+
+#define BENCH_DEFAULT_SIZE 1024
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_DEFAULT_THRESHOLD 10.0	// Allowed slowdown over the baseline in percent
+#define BENCH_RESULTS_FILENAME "bench_results.json"
+#define BENCH_BASELINE_FILENAME "bench_baseline.json"
+#define BENCH_MAX_NAME 32
+#define BENCH_CPU_NAME "cpu"	// Kernel name the CPU renderer is reported under
+#define BENCH_CPU_RUNS 2		// CPU renderer runs per scene (doubles, then double-floats)
+#define BENCH_HISTOGRAM_NAME "histogram_colour"	// Scene name the histogram colouring pass is reported under
+#define BENCH_HISTOGRAM_SCENE 2	// Scene whose frame is coloured for it (seahorse_1000)
+#define BENCH_ENCODE_NAME "encode"	// Scene name the image encoders are reported under, on the histogram scene's frame
+#define BENCH_ENCODE_RUNS (2 * (IMAGE_FORMAT_COUNT - 1))	// Every format but BMP, on one thread and on all of them
+
+
+typedef struct {
+	const char *name;
+	double screen_x;
+	double screen_y;
+	double width;		// Width of the view on the complex plane
+	Uint32 iterations;
+	Kernel_Formula formula;
+} Bench_Scene;
+
+typedef struct {
+	char scene[BENCH_MAX_NAME];
+	char kernel[BENCH_MAX_NAME];
+	double median_ms;
+	double p95_ms;
+	double giters_per_s;	// Giga-iterations per second at the median time
+} Bench_Result;
+
+
+//	Runs the benchmark suite from the command line
+//	
+//	`argv[0]` is expected to be the "--bench" switch itself.
+//	Options:
+//		--size N          Renders N x N frames
+//		--runs N          Timed runs per scene and kernel
+//		--kernel NAME     Only benchmarks the named kernel
+//		--scene NAME      Only benchmarks the named scene
+//		--out FILE        Where to write the results
+//		--baseline FILE   Baseline to compare against
+//		--threshold PCT   Allowed slowdown over the baseline
+//		--save-baseline   Also writes the results as the new baseline
+//		--tile N          Tile size of the persistent kernel
+//		--order NAME      Tile order of the persistent kernel (rows, morton or centre)
+//		--groups N        Workgroups launched by the persistent kernel
+//	
+//	Returns 0 if no kernel regressed past the threshold, 1 otherwise.
+int bench_main(int argc, char *argv[]);
+
+//	Writes benchmark results to a JSON file
+//	
+//	Returns 0 on success, 1 otherwise.
+int bench_write_results(const char *filename, Bench_Result *results, int count, int size);
+
+//	Reads benchmark results back from a JSON file written by `bench_write_results()`
+//	
+//	The frame size the results were taken at is written to `size`,
+//	or 0 if the file doesn't say.
+//	Returns the number of results read (at most `max`), or -1 if the file can't be opened.
+int bench_read_results(const char *filename, Bench_Result *results, int max, int *size);
+
+#endif
@@ -0,0 +1,461 @@
+#include "buddha.h"
+
+#define BUDDHA_MERGE_ROWS 16	// Rows per job when merging the per-thread counts
+
+typedef struct {
+	double screen_x;	// Centre of the view
+	double screen_y;
+	double zoom;		// Pixels per unit on the complex plane
+	Uint32 width;
+	Uint32 height;
+	Uint32 iterations;
+	Uint32 min_iterations;
+	bool anti;
+	bool metropolis;
+	double mutation_size;
+} Buddha_Params;
+
+typedef struct {
+	double cx;
+	double cy;
+	double contribution;	// Orbit points of the chain's point in the view, or 0 before it has started
+} Buddha_Chain;
+
+// The state shared by a round of CPU sampling
+typedef struct {
+	const Buddha_Params *params;
+	Uint32 **accum;			// One private count image per thread
+	Uint32 *hits;			// Where they're all merged
+	Buddha_Chain *chains;	// One per job
+	Uint32 samples;			// Per job
+	Uint32 seed;
+	int threads;
+	Uint64 contributing[POOL_MAX_THREADS];
+	Uint64 accepted[POOL_MAX_THREADS];
+} Buddha_Round;
+
+typedef struct {
+	GLuint program;
+	gl_frametex ftex;	// Hit counts go in its escape image
+	GLuint chains;
+	GLuint stats;
+} Buddha_Gpu;
+
+
+// Same PCG generator as the shader
+static inline Uint32 __rand_next(Uint32 *state) {
+	*state = *state * 747796405u + 2891336453u;
+	Uint32 word = ((*state >> ((*state >> 28u) + 4u)) ^ *state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+static inline double __rand_double(Uint32 *state) {
+	return (__rand_next(state) >> 8) * (1.0 / 16777216.0);
+}
+
+// Finds the pixel nearest a point of the complex plane, returning false if it's outside the view
+static inline bool __to_pixel(const Buddha_Params *b, double zx, double zy, Uint32 *index) {
+	double px = SDL_floor((zx - b->screen_x) * b->zoom + b->width / 2.0 + 0.5);
+	double py = SDL_floor((b->screen_y - zy) * b->zoom + b->height / 2.0 + 0.5);	// Rows go from the top down
+	if (px < 0.0 || py < 0.0 || px >= b->width || py >= b->height) return false;
+	*index = (Uint32) py * b->width + (Uint32) px;
+	return true;
+}
+
+// Counts the orbit points in the view if the orbit is one this mode draws, otherwise 0
+static Uint32 __trace(const Buddha_Params *b, double cx, double cy) {
+	double zx = cx;
+	double zy = cy;
+	Uint32 in_view = 0;
+	Uint32 i;
+	for (i=0; i<b->iterations; i++) {
+		Uint32 index;
+		if (__to_pixel(b, zx, zy, &index)) in_view++;
+
+		double x = zx * zx - zy * zy + cx;
+		zy = 2.0 * zx * zy + cy;
+		zx = x;
+		if (zx * zx + zy * zy > 4.0) break;
+	}
+
+	bool escaped = i < b->iterations;
+	if (b->anti ? escaped : (!escaped || i + 1 < b->min_iterations)) return 0;
+	return in_view;
+}
+
+// Adds `weight` hits on average (rounded randomly) for each orbit point in the view
+static void __splat(const Buddha_Params *b, double cx, double cy, double weight, Uint32 *state, Uint32 *accum) {
+	Uint32 whole = (Uint32) weight;
+	double part = weight - whole;
+
+	double zx = cx;
+	double zy = cy;
+	for (Uint32 i=0; i<b->iterations; i++) {
+		Uint32 index;
+		if (__to_pixel(b, zx, zy, &index)) {
+			Uint32 add = whole;
+			if (part > 0.0 && __rand_double(state) < part) add++;
+			accum[index] += add;
+		}
+
+		double x = zx * zx - zy * zy + cx;
+		zy = 2.0 * zx * zy + cy;
+		zx = x;
+		if (zx * zx + zy * zy > 4.0) break;
+	}
+}
+
+// Takes one job's share of a round's samples, counting into the thread's own image
+static void __cpu_sample(void *ctx, Uint32 index, int thread) {
+	Buddha_Round *r = ctx;
+	const Buddha_Params *b = r->params;
+	Uint32 *accum = r->accum[thread];
+	Uint32 state = (index * 1973u) ^ (r->seed * 9277u) ^ 26699u;
+	__rand_next(&state);
+
+	Uint64 found = 0;
+	Uint64 taken = 0;
+	if (!b->metropolis) {
+		for (Uint32 s=0; s<r->samples; s++) {
+			double cx = __rand_double(&state) * 4.0 - 2.0;
+			double cy = __rand_double(&state) * 4.0 - 2.0;
+			if (__trace(b, cx, cy) == 0) continue;
+			__splat(b, cx, cy, 1.0, &state, accum);
+			found++;
+		}
+	} else {
+		Buddha_Chain *chain = &r->chains[index];
+		for (Uint32 s=0; s<r->samples; s++) {
+			// Mostly small steps around the current point, with the odd jump anywhere
+			double cx = __rand_double(&state) * 4.0 - 2.0;
+			double cy = __rand_double(&state) * 4.0 - 2.0;
+			if (chain->contribution > 0.0 && __rand_double(&state) >= BUDDHA_MH_LARGE_STEP) {
+				double radius = b->mutation_size * SDL_exp(-6.0 * __rand_double(&state));
+				double angle = 2.0 * M_PI * __rand_double(&state);
+				cx = chain->cx + radius * SDL_cos(angle);
+				cy = chain->cy + radius * SDL_sin(angle);
+			}
+
+			// Both kinds of step are symmetric, so the acceptance ratio is just the contributions'
+			double contribution = __trace(b, cx, cy);
+			if (contribution > 0.0 && (chain->contribution == 0.0 || __rand_double(&state) * chain->contribution < contribution)) {
+				*chain = (Buddha_Chain){ cx, cy, contribution };
+				taken++;
+			}
+
+			// Weighted by the inverse of how likely the point was to be drawn
+			if (chain->contribution > 0.0) {
+				__splat(b, chain->cx, chain->cy, BUDDHA_MH_WEIGHT / chain->contribution, &state, accum);
+				found++;
+			}
+		}
+	}
+	r->contributing[thread] += found;
+	r->accepted[thread] += taken;
+}
+
+// Adds a band of rows of every thread's counts into the merged image, clearing them for the next round
+static void __cpu_merge(void *ctx, Uint32 index, int thread) {
+	Buddha_Round *r = ctx;
+	const Buddha_Params *b = r->params;
+	Uint32 start = index * BUDDHA_MERGE_ROWS * b->width;
+	Uint32 end = SDL_min(start + BUDDHA_MERGE_ROWS * b->width, b->width * b->height);
+
+	for (int t=0; t<r->threads; t++) {
+		Uint32 *accum = r->accum[t];
+		for (Uint32 i=start; i<end; i++) {
+			r->hits[i] += accum[i];
+			accum[i] = 0;
+		}
+	}
+}
+
+static int __gpu_setup(Buddha_Gpu *g, const Buddha_Params *b) {
+	g->program = glCreateProgram();
+	GLuint comp_shader = gl_load_shader(GL_COMPUTE_SHADER, "shaders/buddhabrot.comp");
+	glAttachShader(g->program, comp_shader);
+	gl_link_program(g->program);
+	glDeleteShader(comp_shader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(g->program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE) return 1;
+
+	g->ftex = gl_create_frametex(b->width, b->height);
+	glClearTexImage(g->ftex.escape, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+	// Four floats per chain, matching the shader's Chain
+	GLuint invocations = BUDDHA_GPU_GROUPS * BUDDHA_GROUP_SIZE;
+	glCreateBuffers(1, &g->chains);
+	glNamedBufferStorage(g->chains, invocations * 4 * sizeof(GLfloat), NULL, GL_DYNAMIC_STORAGE_BIT);
+	glClearNamedBufferData(g->chains, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glCreateBuffers(1, &g->stats);
+	glNamedBufferStorage(g->stats, 2 * sizeof(GLuint), NULL, GL_DYNAMIC_STORAGE_BIT);
+	gl_check_err("Failed to set up Buddhabrot buffers");
+	return 0;
+}
+
+static void __gpu_term(Buddha_Gpu *g) {
+	if (g->program != NULL_PROGRAM) glDeleteProgram(g->program);
+	if (g->chains != 0) {
+		gl_destroy_frametex(g->ftex);
+		glDeleteBuffers(1, &g->chains);
+		glDeleteBuffers(1, &g->stats);
+	}
+}
+
+// Takes a round of samples on the GPU and reads back the counts so far, returning the samples taken
+static Uint64 __gpu_round(Buddha_Gpu *g, const Buddha_Params *b, Uint64 samples, Uint32 seed, Uint32 *hits, Uint64 *contributing, Uint64 *accepted) {
+	// Keep each dispatch short, so it doesn't trip any driver watchdog
+	GLuint invocations = BUDDHA_GPU_GROUPS * BUDDHA_GROUP_SIZE;
+	GLuint per_dispatch = SDL_max(BUDDHA_GPU_DISPATCH_WORK / SDL_max(b->iterations, 1), 1);
+	per_dispatch = (GLuint) SDL_min(per_dispatch, (samples + invocations - 1) / invocations);
+	Uint64 dispatches = (samples + (Uint64) invocations * per_dispatch - 1) / ((Uint64) invocations * per_dispatch);
+
+	glClearNamedBufferData(g->stats, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glUseProgram(g->program);
+	glBindImageTexture(1, g->ftex.escape, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, g->chains);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, g->stats);
+	glUniform3f(0, (GLfloat) b->screen_x, (GLfloat) b->screen_y, (GLfloat) b->zoom);
+	glUniform1ui(1, b->iterations);
+	glUniform1ui(2, b->min_iterations);
+	glUniform1i(3, b->anti);
+	glUniform1ui(4, per_dispatch);
+	glUniform1i(6, b->metropolis);
+	glUniform1f(7, (GLfloat) b->mutation_size);
+
+	for (Uint64 d=0; d<dispatches; d++) {
+		glUniform1ui(5, seed + (GLuint) d * 7919u);
+		glDispatchCompute(BUDDHA_GPU_GROUPS, 1, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+	glMemoryBarrier(GL_ALL_BARRIER_BITS);
+
+	GLuint stats[2];
+	glGetNamedBufferSubData(g->stats, 0, sizeof(stats), stats);
+	*contributing = stats[0];
+	*accepted = stats[1];
+	glGetTextureImage(g->ftex.escape, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, b->width * b->height * sizeof(Uint32), hits);
+	gl_check_err("Failed to sample Buddhabrot");
+	return dispatches * invocations * per_dispatch;
+}
+
+// Works out how much the normalised image changed since the last round (0 to 2), keeping this one for the next
+static double __convergence(const Uint32 *hits, double *last, Uint32 pixels) {
+	Uint64 total = 0;
+	for (Uint32 i=0; i<pixels; i++) total += hits[i];
+	if (total == 0) return 2.0;
+
+	double change = 0.0;
+	for (Uint32 i=0; i<pixels; i++) {
+		double density = (double) hits[i] / total;
+		change += SDL_fabs(density - last[i]);
+		last[i] = density;
+	}
+	return change;
+}
+
+// Maps hit counts to greyscale, with a square root so faint orbits still show
+static void __tone_map(const Uint32 *hits, Uint8 *pixels, Uint32 count) {
+	Uint32 max = 1;
+	for (Uint32 i=0; i<count; i++) max = SDL_max(max, hits[i]);
+
+	for (Uint32 i=0; i<count; i++) {
+		Uint8 v = (Uint8) (255.0 * SDL_sqrt((double) hits[i] / max) + 0.5);
+		pixels[i * 4 + 0] = v;
+		pixels[i * 4 + 1] = v;
+		pixels[i * 4 + 2] = v;
+		pixels[i * 4 + 3] = 255;
+	}
+}
+
+
+int buddha_main(int argc, char *argv[]) {
+	double centre_x = -0.4;
+	double centre_y = 0.0;
+	double span = 3.5;
+	int size = BUDDHA_DEFAULT_SIZE;
+	int iterations = 1000;
+	int min_iterations = 0;
+	double samples = BUDDHA_DEFAULT_SAMPLES;
+	int rounds = BUDDHA_DEFAULT_ROUNDS;
+	bool anti = false;
+	bool metropolis = false;
+	Render_Backend backend = RENDER_BACKEND_GL;
+	int threads = 0;
+	Uint32 seed = 1;
+	const char *out_filename = "buddha.bmp";
+
+	// Parse options
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--x") == 0 && has_val) centre_x = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--y") == 0 && has_val) centre_y = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--span") == 0 && has_val) span = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--size") == 0 && has_val) size = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--iters") == 0 && has_val) iterations = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--min-iters") == 0 && has_val) min_iterations = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--samples") == 0 && has_val) samples = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--rounds") == 0 && has_val) rounds = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--anti") == 0) anti = true;
+		else if (SDL_strcmp(argv[i], "--mh") == 0) metropolis = true;
+		else if (SDL_strcmp(argv[i], "--backend") == 0 && has_val) {
+			const char *name = argv[++i];
+			backend = RENDER_BACKEND_COUNT;
+			for (int b=0; b<RENDER_BACKEND_COUNT; b++) {
+				if (SDL_strcmp(render_backend_name(b), name) == 0) backend = b;
+			}
+			if (backend != RENDER_BACKEND_GL && backend != RENDER_BACKEND_CPU) {
+				printf("[ERROR] Unknown backend '%s'\n", name);
+				return 1;
+			}
+		}
+		else if (SDL_strcmp(argv[i], "--threads") == 0 && has_val) threads = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--seed") == 0 && has_val) seed = (Uint32) SDL_strtoul(argv[++i], NULL, 10);
+		else if (SDL_strcmp(argv[i], "--out") == 0 && has_val) out_filename = argv[++i];
+		else {
+			printf("[ERROR] Unknown buddha option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (span <= 0.0 || size <= 0 || iterations <= 0 || min_iterations < 0 || samples < 1.0 || rounds <= 0) {
+		puts("[ERROR] Invalid buddha options");
+		return 1;
+	}
+
+	Buddha_Params params = {
+		.screen_x = centre_x,
+		.screen_y = centre_y,
+		.zoom = size / span,
+		.width = size,
+		.height = size,
+		.iterations = iterations,
+		.min_iterations = min_iterations,
+		.anti = anti,
+		.metropolis = metropolis,
+		.mutation_size = span * BUDDHA_MH_MUTATION,
+	};
+	Uint32 pixels = params.width * params.height;
+	Uint32 *hits = SDL_calloc(pixels, sizeof(Uint32));
+	double *last = SDL_calloc(pixels, sizeof(double));
+
+	// Set up whichever backend is sampling
+	SDL_Window *window = NULL;
+	Buddha_Gpu gpu = { .program = NULL_PROGRAM };
+	Pool *pool = NULL;
+	Buddha_Round round = { .params = &params };
+	if (backend == RENDER_BACKEND_GL) {
+		if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+			printf("[ERROR] Failed to initialise SDL: %s\n", SDL_GetError());
+			return 1;
+		}
+		window = SDL_CreateWindow(
+			"Mandelbrot Buddhabrot",
+			SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+			1, 1,
+			SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+		);
+		if (window == NULL) {
+			printf("[ERROR] Failed to create Window: %s\n", SDL_GetError());
+			return 1;
+		}
+		gl_init(4, 5, window);
+		if (__gpu_setup(&gpu, &params) != 0) {
+			puts("[ERROR] Failed to build the Buddhabrot shader");
+			__gpu_term(&gpu);
+			gl_term();
+			SDL_DestroyWindow(window);
+			SDL_Quit();
+			return 1;
+		}
+	} else {
+		if (SDL_Init(0) < 0) return 1;
+		pool = pool_create(threads);
+		round.threads = pool_threads(pool);
+		round.hits = hits;
+		round.accum = SDL_malloc(round.threads * sizeof(Uint32 *));
+		for (int t=0; t<round.threads; t++) round.accum[t] = SDL_calloc(pixels, sizeof(Uint32));
+		round.chains = SDL_calloc(BUDDHA_CPU_JOBS, sizeof(Buddha_Chain));
+	}
+
+	printf("---> Sampling a %sBuddhabrot at %ix%i (%i iterations) with the %s renderer%s\n",
+		anti ? "Anti-" : "", size, size, iterations, render_backend_name(backend),
+		metropolis ? ", by importance" : ""
+	);
+	fflush(stdout);
+
+	// Sample in rounds, watching how much the image is still changing
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+	Uint64 round_samples = (Uint64) SDL_ceil(samples / rounds);
+	Uint64 total_samples = 0;
+	double total_ms = 0.0;
+	double change = 2.0;
+	for (int r=0; r<rounds; r++) {
+		Uint32 round_seed = seed * 1000003u + r * 104729u;
+		Uint64 taken = 0;
+		Uint64 contributing = 0;
+		Uint64 accepted = 0;
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		if (backend == RENDER_BACKEND_GL) {
+			taken = __gpu_round(&gpu, &params, round_samples, round_seed, hits, &contributing, &accepted);
+		} else {
+			round.samples = (Uint32) ((round_samples + BUDDHA_CPU_JOBS - 1) / BUDDHA_CPU_JOBS);
+			round.seed = round_seed;
+			SDL_memset(round.contributing, 0, sizeof(round.contributing));
+			SDL_memset(round.accepted, 0, sizeof(round.accepted));
+			pool_run(pool, BUDDHA_CPU_JOBS, __cpu_sample, &round);
+			pool_run(pool, (params.height + BUDDHA_MERGE_ROWS - 1) / BUDDHA_MERGE_ROWS, __cpu_merge, &round);
+
+			taken = (Uint64) round.samples * BUDDHA_CPU_JOBS;
+			for (int t=0; t<round.threads; t++) {
+				contributing += round.contributing[t];
+				accepted += round.accepted[t];
+			}
+		}
+		double ms = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+		total_samples += taken;
+		total_ms += ms;
+
+		change = __convergence(hits, last, pixels);
+		printf("---> Round %i/%i: %llu samples in %.1lf ms (%.2lf Msamples/s), %.1lf%% contributing",
+			r + 1, rounds, (unsigned long long) taken, ms, (ms > 0.0) ? taken / ms / 1000.0 : 0.0,
+			100.0 * contributing / taken
+		);
+		if (metropolis) printf(", %.1lf%% accepted", 100.0 * accepted / taken);
+		if (r > 0) printf(", change %.5lf", change);
+		printf("\n");
+		fflush(stdout);
+	}
+
+	printf("---> Took %llu samples in %.1lf ms (%.2lf Msamples/s), last round changed the image by %.5lf\n",
+		(unsigned long long) total_samples, total_ms, (total_ms > 0.0) ? total_samples / total_ms / 1000.0 : 0.0,
+		(rounds > 1) ? change : 2.0
+	);
+
+	// Save the image
+	Uint8 *image = SDL_malloc(pixels * 4);
+	__tone_map(hits, image, pixels);
+	int result = image_save(out_filename, image_format_from_filename(out_filename), image, params.width, params.height, params.width * 4, pool);
+	if (result == 0) printf("---> Wrote '%s'\n", out_filename);
+	else printf("[ERROR] Failed to write '%s'\n", out_filename);
+	fflush(stdout);
+
+	// Clean up
+	SDL_free(image);
+	if (backend == RENDER_BACKEND_GL) {
+		__gpu_term(&gpu);
+		gl_term();
+		SDL_DestroyWindow(window);
+	} else {
+		for (int t=0; t<round.threads; t++) SDL_free(round.accum[t]);
+		SDL_free(round.accum);
+		SDL_free(round.chains);
+		pool_destroy(pool);
+	}
+	SDL_free(last);
+	SDL_free(hits);
+	SDL_Quit();
+	return result;
+}
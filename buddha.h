@@ -0,0 +1,71 @@
+//	
+//	Buddhabrot and Anti-Buddhabrot rendering
+//	
+//	Rather than colouring each pixel by how quickly its own point
+//	escapes, random points are drawn from the whole set and every
+//	point of their orbits is counted into a hit count per pixel. The
+//	Buddhabrot counts the orbits that escape; the Anti-Buddhabrot the
+//	ones that don't.
+//	
+//	On the GPU, every invocation adds its hits to a shared 32-bit
+//	counter image with atomics. On the CPU, each thread counts into
+//	its own private image, and these are merged after every round.
+//	
+//	Uniform sampling wastes most orbits once the view is zoomed in,
+//	since few of them ever pass through it. With --mh, each
+//	invocation (or CPU job) instead runs a Metropolis-Hastings chain
+//	that favours points whose orbits land in the view, and weights
+//	each orbit's hits by the inverse of that so the image stays
+//	unbiased.
+//	
+//	Samples are taken in rounds, and the change in the normalised
+//	image from one round to the next is reported as a measure of how
+//	far it is from converging.
+//	
+
+#ifndef BUDDHA_H
+#define BUDDHA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "pool.h"
+#include "render.h"
+#include "image.h"
+
+#define BUDDHA_DEFAULT_SIZE 1024
+#define BUDDHA_DEFAULT_SAMPLES 10000000
+#define BUDDHA_DEFAULT_ROUNDS 10
+#define BUDDHA_GROUP_SIZE 64			// Must match the shader
+#define BUDDHA_GPU_GROUPS 256			// Workgroups per dispatch, each invocation running its own chain
+#define BUDDHA_GPU_DISPATCH_WORK 16384	// Iterations each invocation traces per dispatch, at most
+#define BUDDHA_CPU_JOBS 256				// Jobs per round, each running its own chain
+#define BUDDHA_MH_LARGE_STEP 0.25		// Chance of a mutation being a fresh sample from anywhere
+#define BUDDHA_MH_WEIGHT 16.0			// Hits spread over each orbit's points when sampling by importance
+#define BUDDHA_MH_MUTATION 0.05			// Largest small mutation, as a fraction of the view width
+
+
+//	Renders a Buddhabrot image (`mandelbrot.exe --buddha ...`)
+//	
+//	`argv[0]` is expected to be the "--buddha" switch itself.
+//	Options:
+//		--x X / --y Y     Centre of the view
+//		--span W          Width of the view on the complex plane
+//		--size N          Renders an N x N image
+//		--iters N         Longest orbit traced
+//		--min-iters N     Skips escaping orbits shorter than this
+//		--samples N       Total points sampled
+//		--rounds N        Rounds the samples are split into
+//		--anti            Draws the Anti-Buddhabrot instead
+//		--mh              Samples by importance with Metropolis-Hastings
+//		--backend gl|cpu  Renderer to use (default gl)
+//		--threads N       Threads for the CPU renderer (default one per core)
+//		--seed N          Seed for the random numbers
+//		--out FILE        Saves the image as FILE (default buddha.bmp)
+//	Returns the exit code for the program.
+int buddha_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,103 @@
+#include "colour.h"
+#include "trace.h"
+
+typedef struct {
+	const char *shader_filename;
+	GLuint program;
+} Colour_Pass;
+
+enum {
+	PASS_HISTOGRAM,
+	PASS_SCAN,
+	PASS_MAP,
+	PASS_COUNT,
+};
+
+static Colour_Pass __passes[PASS_COUNT] = {
+	[PASS_HISTOGRAM] = { "shaders/colour_histogram.comp", NULL_PROGRAM },
+	[PASS_SCAN] = { "shaders/colour_scan.comp", NULL_PROGRAM },
+	[PASS_MAP] = { "shaders/colour_map.comp", NULL_PROGRAM },
+};
+
+static const char *__mode_names[COLOUR_COUNT] = {
+	[COLOUR_LINEAR] = "linear",
+	[COLOUR_HISTOGRAM] = "histogram",
+};
+
+static GLuint __hist_buffer = 0;
+
+// Gets a pass's program, compiling it on first use
+static GLuint __program(int pass) {
+	Colour_Pass *p = &__passes[pass];
+	if (p->program != NULL_PROGRAM) return p->program;
+
+	p->program = glCreateProgram();
+	GLuint comp_shader = gl_load_shader(GL_COMPUTE_SHADER, p->shader_filename);
+	glAttachShader(p->program, comp_shader);
+	gl_link_program(p->program);
+	glDeleteShader(comp_shader);
+	return p->program;
+}
+
+
+const char *colour_mode_name(Colour_Mode mode) {
+	if (mode >= COLOUR_COUNT) return "(none)";
+	return __mode_names[mode];
+}
+
+float colour_bin_scale(Uint32 iterations) {
+	if (iterations == 0) return 0.0f;
+	return (float) COLOUR_HIST_BINS / (float) iterations;
+}
+
+void colour_apply(Colour_Mode mode, gl_frametex ftex, Uint32 iterations) {
+	if (mode != COLOUR_HISTOGRAM) return;
+
+	// Total, then the counts, then their prefix sum
+	if (__hist_buffer == 0) {
+		glCreateBuffers(1, &__hist_buffer);
+		glNamedBufferStorage(__hist_buffer, sizeof(GLuint) * (1 + 2 * COLOUR_HIST_BINS), NULL, GL_DYNAMIC_STORAGE_BIT);
+		gl_check_err("Failed to create histogram buffer");
+	}
+	glClearNamedBufferData(__hist_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COLOUR_HIST_BINDING, __hist_buffer);
+
+	GLuint groups_x = (ftex.w + COLOUR_GROUP_SIZE - 1) / COLOUR_GROUP_SIZE;
+	GLuint groups_y = (ftex.h + COLOUR_GROUP_SIZE - 1) / COLOUR_GROUP_SIZE;
+	float bin_scale = colour_bin_scale(iterations);
+
+	TRACE_BEGIN("histogram");
+	glUseProgram(__program(PASS_HISTOGRAM));
+	glBindImageTexture(1, ftex.escape, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+	glUniform1f(0, bin_scale);
+	glDispatchCompute(groups_x, groups_y, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	TRACE_END();
+
+	TRACE_BEGIN("histogram_scan");
+	glUseProgram(__program(PASS_SCAN));
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	TRACE_END();
+
+	TRACE_BEGIN("histogram_map");
+	glUseProgram(__program(PASS_MAP));
+	glBindImageTexture(0, ftex.tex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glBindImageTexture(1, ftex.escape, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+	glUniform1f(0, bin_scale);
+	glDispatchCompute(groups_x, groups_y, 1);
+	glMemoryBarrier(GL_ALL_BARRIER_BITS);
+	gl_check_err("Failed to apply histogram colouring");
+	TRACE_END();
+}
+
+void colour_term() {
+	for (int i=0; i<PASS_COUNT; i++) {
+		if (__passes[i].program == NULL_PROGRAM) continue;
+		glDeleteProgram(__passes[i].program);
+		__passes[i].program = NULL_PROGRAM;
+	}
+
+	if (__hist_buffer != 0) glDeleteBuffers(1, &__hist_buffer);
+	__hist_buffer = 0;
+}
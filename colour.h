@@ -0,0 +1,54 @@
+//	
+//	Colouring passes run over a frame after it's been iterated
+//	
+//	The kernels colour each pixel linearly by how early it escaped,
+//	which squeezes nearly all the detail into one end of the
+//	spectrum at high iteration counts. Histogram colouring spreads
+//	the colours out by how many pixels escaped sooner instead, which
+//	needs a pass over the whole frame's escape image:
+//	
+//		1. Each workgroup builds a histogram of its pixels' escape
+//		   iterations in shared memory, then merges it into the
+//		   frame's histogram with atomics
+//		2. One workgroup prefix sums the histogram
+//		3. Each pixel is coloured by where it falls in the sum
+//	
+
+#ifndef COLOUR_H
+#define COLOUR_H
+
+#include <stdbool.h>
+
+#include "gl.h"
+
+#define COLOUR_HIST_BINS 1024	// Must match the colouring shaders
+#define COLOUR_GROUP_SIZE 16	// Workgroup width and height of the colouring shaders
+#define COLOUR_HIST_BINDING 2	// Buffer binding of the histogram
+
+
+typedef enum {
+	COLOUR_LINEAR,		// Straight from the kernels
+	COLOUR_HISTOGRAM,	// Histogram equalised
+	COLOUR_COUNT,
+} Colour_Mode;
+
+
+//	Gets the short name of a colouring mode (e.g. "histogram")
+//	
+const char *colour_mode_name(Colour_Mode mode);
+
+//	Works out the histogram bin scale for an iteration count
+//	
+//	Shared with the CPU path so both bin pixels identically.
+float colour_bin_scale(Uint32 iterations);
+
+//	Recolours a frametex from its escape image on the GPU
+//	
+//	Does nothing for COLOUR_LINEAR, since the kernels already did that.
+void colour_apply(Colour_Mode mode, gl_frametex ftex, Uint32 iterations);
+
+//	Frees the colouring programs and buffers
+//	
+void colour_term();
+
+#endif
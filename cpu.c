@@ -0,0 +1,515 @@
+#include "cpu.h"
+
+#define DF_SPLIT 4097.0f	// 2^12 + 1, for splitting a float into two 12-bit halves
+
+// A float per lane, and a matching mask/integer per lane
+typedef float Cpu_Lanes __attribute__((vector_size(CPU_LANES * sizeof(float))));
+typedef Sint32 Cpu_Lane_Ints __attribute__((vector_size(CPU_LANES * sizeof(Sint32))));
+
+// Double-float per lane, the value being `hi + lo`
+typedef struct {
+	Cpu_Lanes hi;
+	Cpu_Lanes lo;
+} Cpu_DFloat;
+
+typedef struct {
+	const Render_View *view;
+	Kernel_Formula formula;	// Taken once, so the whole frame uses the same one
+	const Render_Target *colour;
+	const Render_Target *escape;
+	Uint32 width;
+	Uint32 height;
+	const Uint32 *row_start;	// First row of each band, or NULL for bands of CPU_BAND_ROWS
+	Uint64 iters[POOL_MAX_THREADS];	// Pixel-iterations counted by each thread
+} Cpu_Job;
+
+static Uint8 __to_byte(double v) {
+	if (v <= 0.0) return 0;
+	if (v >= 1.0) return 255;
+	return (Uint8)(v * 255.0 + 0.5);
+}
+
+// Adds two floats per lane exactly, giving the rounded sum and its error
+static inline Cpu_DFloat __two_sum(Cpu_Lanes a, Cpu_Lanes b) {
+	Cpu_DFloat r;
+	r.hi = a + b;
+	Cpu_Lanes bb = r.hi - a;
+	r.lo = (a - (r.hi - bb)) + (b - bb);
+	return r;
+}
+
+// Multiplies two floats per lane exactly, giving the rounded product and its error
+static inline Cpu_DFloat __two_prod(Cpu_Lanes a, Cpu_Lanes b) {
+	Cpu_DFloat r;
+	r.hi = a * b;
+#ifdef __FP_FAST_FMAF
+	// Vectorises to the FMA instructions the target has
+	for (int i=0; i<CPU_LANES; i++) r.lo[i] = __builtin_fmaf(a[i], b[i], -r.hi[i]);
+#else
+	// No FMA, so split into halves whose products are exact (Dekker)
+	Cpu_Lanes at = DF_SPLIT * a;
+	Cpu_Lanes bt = DF_SPLIT * b;
+	Cpu_Lanes a_hi = at - (at - a);
+	Cpu_Lanes b_hi = bt - (bt - b);
+	Cpu_Lanes a_lo = a - a_hi;
+	Cpu_Lanes b_lo = b - b_hi;
+	r.lo = ((a_hi * b_hi - r.hi) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+#endif
+	return r;
+}
+
+static inline Cpu_DFloat __df_add(Cpu_DFloat a, Cpu_DFloat b) {
+	Cpu_DFloat s = __two_sum(a.hi, b.hi);
+	return __two_sum(s.hi, s.lo + a.lo + b.lo);
+}
+
+static inline Cpu_DFloat __df_mul(Cpu_DFloat a, Cpu_DFloat b) {
+	Cpu_DFloat p = __two_prod(a.hi, b.hi);
+	return __two_sum(p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi));
+}
+
+static inline Cpu_DFloat __df_neg(Cpu_DFloat a) {
+	a.hi = -a.hi;
+	a.lo = -a.lo;
+	return a;
+}
+
+// Squares a complex number of double-floats per lane, in place
+static inline void __dc_square(Cpu_DFloat *x, Cpu_DFloat *y) {
+	Cpu_DFloat xx = __df_mul(*x, *x);
+	Cpu_DFloat yy = __df_mul(*y, *y);
+	Cpu_DFloat xy = __df_mul(*x, *y);
+	xy.hi *= 2.0f;	// Doubling is exact
+	xy.lo *= 2.0f;
+	*x = __df_add(xx, __df_neg(yy));
+	*y = xy;
+}
+
+// Multiplies a complex number of double-floats per lane by another, in place
+static inline void __dc_mul(Cpu_DFloat *x, Cpu_DFloat *y, Cpu_DFloat bx, Cpu_DFloat by) {
+	Cpu_DFloat re = __df_add(__df_mul(*x, bx), __df_neg(__df_mul(*y, by)));
+	*y = __df_add(__df_mul(*x, by), __df_mul(*y, bx));
+	*x = re;
+}
+
+// Raises a complex number to the power n by repeated squaring, in place
+//
+// Only ever called with a constant n, so once inlined every test of n
+// folds away, leaving the unrolled sequence of squarings and products
+// for that power (like the kernels' complex_power()).
+static inline __attribute__((always_inline)) void __complex_power(double *zx, double *zy, const Uint32 n) {
+	double sx = *zx;	// z^(2^k)
+	double sy = *zy;
+	bool started = false;
+#pragma GCC unroll 8
+	for (Uint32 bit=1; bit<=n; bit<<=1) {
+		if (bit > 1) {
+			double x = sx * sx - sy * sy;
+			sy = 2.0 * sx * sy;
+			sx = x;
+		}
+		if ((n & bit) == 0) continue;
+		if (!started) {
+			*zx = sx;
+			*zy = sy;
+			started = true;
+		} else {
+			double x = *zx * sx - *zy * sy;
+			*zy = *zx * sy + *zy * sx;
+			*zx = x;
+		}
+	}
+}
+
+// Raises a complex number of double-floats per lane to the power n, the same way as `__complex_power()`
+static inline __attribute__((always_inline)) void __dc_power(Cpu_DFloat *zx, Cpu_DFloat *zy, const Uint32 n) {
+	Cpu_DFloat sx = *zx;
+	Cpu_DFloat sy = *zy;
+	bool started = false;
+#pragma GCC unroll 8
+	for (Uint32 bit=1; bit<=n; bit<<=1) {
+		if (bit > 1) __dc_square(&sx, &sy);
+		if ((n & bit) == 0) continue;
+		if (!started) {
+			*zx = sx;
+			*zy = sy;
+			started = true;
+		} else {
+			__dc_mul(zx, zy, sx, sy);
+		}
+	}
+}
+
+// Iterates z^n + c from a starting z until it escapes, for a constant n
+static inline __attribute__((always_inline)) Uint32 __iterate(double zx, double zy, double cx, double cy, Uint32 iterations, const Uint32 n) {
+	for (Uint32 i=0; i<iterations; i++) {
+		__complex_power(&zx, &zy, n);
+		zx += cx;
+		zy += cy;
+		if (zx * zx + zy * zy > 4.0) return i + 1;
+	}
+
+	return RENDER_INTERIOR;
+}
+
+// Iterates z^n + c like `__iterate()`, also stopping once the orbit comes back to a point saved at every power of two iterations
+static inline __attribute__((always_inline)) Uint32 __iterate_periodic(double zx, double zy, double cx, double cy, Uint32 iterations, double tolerance, Uint64 *performed, const Uint32 n) {
+	double saved_x = zx;
+	double saved_y = zy;
+	Uint32 next_save = 8;
+
+	for (Uint32 i=0; i<iterations; i++) {
+		__complex_power(&zx, &zy, n);
+		zx += cx;
+		zy += cy;
+		if (zx * zx + zy * zy > 4.0) {
+			*performed += i + 1;
+			return i + 1;
+		}
+
+		if (SDL_fabs(zx - saved_x) < tolerance && SDL_fabs(zy - saved_y) < tolerance) {
+			*performed += i + 1;
+			return CPU_PERIODIC;
+		}
+		if (i == next_save) {
+			saved_x = zx;
+			saved_y = zy;
+			next_save *= 2;
+		}
+	}
+
+	*performed += iterations;
+	return RENDER_INTERIOR;
+}
+
+// Works out the double-float coordinates of every pixel of a row, like the dfloat kernel's complex_from_coords()
+static void __row_coords(const Render_View *view, Uint32 y, Uint32 width, Uint32 height, Cpu_DFloat *row_x, Cpu_DFloat *row_y) {
+	// Offset in float and added on to the centre
+	float x_hi = (float) view->screen_x;
+	float y_hi = (float) view->screen_y;
+	Cpu_DFloat centre_x = { { 0 }, { 0 } };
+	Cpu_DFloat centre_y = { { 0 }, { 0 } };
+	centre_x.hi += x_hi;
+	centre_x.lo += (float)(view->screen_x - x_hi);
+	centre_y.hi += y_hi;
+	centre_y.lo += (float)(view->screen_y - y_hi);
+
+	Cpu_DFloat off_y = { { 0 }, { 0 } };
+	off_y.hi += -((float) y - height / 2.0f) / (float) view->zoom;
+	*row_y = __df_add(centre_y, off_y);
+
+	for (Uint32 x_start=0; x_start<width; x_start+=CPU_LANES) {
+		Cpu_DFloat off_x = { { 0 }, { 0 } };
+		for (int i=0; i<CPU_LANES; i++) off_x.hi[i] = ((float)(x_start + i) - width / 2.0f) / (float) view->zoom;
+		row_x[x_start / CPU_LANES] = __df_add(centre_x, off_x);
+	}
+}
+
+// Lanes of a row being iterated in double-floats, refilled as their pixels finish
+typedef struct {
+	const Cpu_DFloat *row_x;	// Real part of each pixel of the row, CPU_LANES pixels per entry
+	Cpu_DFloat row_y;			// Imaginary part of the row, in every lane
+	bool julia;					// C stays fixed rather than being each lane's pixel
+	Uint32 width;
+	Uint32 next;				// Next pixel of the row to pack into a lane
+	int live;					// Lanes with a pixel in them
+	Cpu_DFloat cx, cy;
+	Cpu_DFloat zx, zy;
+	Cpu_Lane_Ints iter;
+	Sint32 pixel[CPU_LANES];	// Pixel in each lane, or -1 once the row has run out
+} Cpu_Packed_Row;
+
+// Packs the next pixel of the row into a lane
+static void __refill_lane(Cpu_Packed_Row *r, int l) {
+	if (r->next >= r->width) {
+		r->pixel[l] = -1;
+		return;
+	}
+
+	const Cpu_DFloat *x = &r->row_x[r->next / CPU_LANES];
+	r->zx.hi[l] = x->hi[r->next % CPU_LANES];
+	r->zx.lo[l] = x->lo[r->next % CPU_LANES];
+	r->zy.hi[l] = r->row_y.hi[l];
+	r->zy.lo[l] = r->row_y.lo[l];
+	if (!r->julia) {
+		r->cx.hi[l] = r->zx.hi[l];
+		r->cx.lo[l] = r->zx.lo[l];
+		r->cy.hi[l] = r->zy.hi[l];
+		r->cy.lo[l] = r->zy.lo[l];
+	}
+	r->iter[l] = 0;
+	r->pixel[l] = (Sint32) r->next++;
+	r->live++;
+}
+
+// Iterates a row of pixels in double-floats, like the dfloat kernel
+//
+// CPU_LANES pixels are iterated together, and whenever one finishes the
+// next pixel of the row is packed into its lane (like the compacting
+// kernel), so lanes don't sit idle waiting for the slowest pixel of a
+// fixed group. `row_x` needs room for the row in whole groups of lanes.
+// Only ever called with a constant n, like `__iterate()`.
+static inline __attribute__((always_inline)) void __iterate_row(const Render_View *view, const Kernel_Formula *formula, Uint32 y, Uint32 width, Uint32 height, Cpu_DFloat *row_x, Uint32 *escapes, const Uint32 n) {
+	if (view->iterations == 0) {
+		for (Uint32 x=0; x<width; x++) escapes[x] = RENDER_INTERIOR;
+		return;
+	}
+
+	Cpu_Packed_Row r;
+	SDL_zero(r);
+	r.row_x = row_x;
+	r.width = width;
+	r.julia = (formula->fractal == KERNEL_JULIA);
+	if (r.julia) {
+		float jx = (float) formula->julia_x;
+		float jy = (float) formula->julia_y;
+		r.cx.hi += jx;
+		r.cx.lo += (float)(formula->julia_x - jx);
+		r.cy.hi += jy;
+		r.cy.lo += (float)(formula->julia_y - jy);
+	}
+	__row_coords(view, y, width, height, row_x, &r.row_y);
+	for (int l=0; l<CPU_LANES; l++) __refill_lane(&r, l);
+
+	while (r.live > 0) {
+		__dc_power(&r.zx, &r.zy, n);
+		r.zx = __df_add(r.zx, r.cx);
+		r.zy = __df_add(r.zy, r.cy);
+		r.iter += 1;
+
+		Cpu_Lane_Ints escaped = (r.zx.hi * r.zx.hi + r.zy.hi * r.zy.hi > 4.0f);
+		Cpu_Lane_Ints done = escaped | (r.iter >= (Sint32) view->iterations);
+		for (int l=0; l<CPU_LANES; l++) {
+			if (!done[l] || r.pixel[l] < 0) continue;
+			escapes[r.pixel[l]] = escaped[l] ? (Uint32) r.iter[l] : RENDER_INTERIOR;
+			r.live--;
+			__refill_lane(&r, l);
+		}
+	}
+}
+
+// Both iteration paths, specialised for one power of z
+typedef struct {
+	Uint32 (*iterate)(double zx, double zy, double cx, double cy, Uint32 iterations);
+	Uint32 (*iterate_periodic)(double zx, double zy, double cx, double cy, Uint32 iterations, double tolerance, Uint64 *performed);
+	void (*iterate_row)(const Render_View *view, const Kernel_Formula *formula, Uint32 y, Uint32 width, Uint32 height, Cpu_DFloat *row_x, Uint32 *escapes);
+} Cpu_Power;
+
+#define CPU_SPECIALISE(n) \
+	static Uint32 __iterate_##n(double zx, double zy, double cx, double cy, Uint32 iterations) { \
+		return __iterate(zx, zy, cx, cy, iterations, n); \
+	} \
+	static Uint32 __iterate_periodic_##n(double zx, double zy, double cx, double cy, Uint32 iterations, double tolerance, Uint64 *performed) { \
+		return __iterate_periodic(zx, zy, cx, cy, iterations, tolerance, performed, n); \
+	} \
+	static void __iterate_row_##n(const Render_View *view, const Kernel_Formula *formula, Uint32 y, Uint32 width, Uint32 height, Cpu_DFloat *row_x, Uint32 *escapes) { \
+		__iterate_row(view, formula, y, width, height, row_x, escapes, n); \
+	}
+
+CPU_SPECIALISE(2)
+CPU_SPECIALISE(3)
+CPU_SPECIALISE(4)
+CPU_SPECIALISE(5)
+CPU_SPECIALISE(6)
+CPU_SPECIALISE(7)
+CPU_SPECIALISE(8)
+
+// One for every power up to KERNEL_MAX_POWER
+static const Cpu_Power __powers[KERNEL_MAX_POWER + 1] = {
+	[2] = { __iterate_2, __iterate_periodic_2, __iterate_row_2 },
+	[3] = { __iterate_3, __iterate_periodic_3, __iterate_row_3 },
+	[4] = { __iterate_4, __iterate_periodic_4, __iterate_row_4 },
+	[5] = { __iterate_5, __iterate_periodic_5, __iterate_row_5 },
+	[6] = { __iterate_6, __iterate_periodic_6, __iterate_row_6 },
+	[7] = { __iterate_7, __iterate_periodic_7, __iterate_row_7 },
+	[8] = { __iterate_8, __iterate_periodic_8, __iterate_row_8 },
+};
+
+typedef struct {
+	const Render_Target *escape;
+	const Render_Target *colour;
+	float bin_scale;
+	Uint32 *counts;		// COLOUR_HIST_BINS per thread, then summed into the first
+	Uint32 *prefix;		// Exclusive prefix sum of the summed counts
+	Uint32 total;
+} Cpu_Hist_Job;
+
+// Fills in a colour from the spectrum, like the kernels' `iter_colour()`
+static void __spectrum(double iter_lvl, Uint8 *rgba) {
+	rgba[0] = __to_byte(iter_lvl);
+	rgba[1] = __to_byte(SDL_fabs(iter_lvl - 0.5));
+	rgba[2] = __to_byte(1.0 - iter_lvl);
+	rgba[3] = 255;
+}
+
+// Counts one band's escape iterations into this thread's histogram
+static void __histogram_band(void *ctx, Uint32 index, int thread) {
+	Cpu_Hist_Job *job = (Cpu_Hist_Job *) ctx;
+	Uint32 *counts = job->counts + (size_t) thread * COLOUR_HIST_BINS;
+	Uint32 y_end = SDL_min((index + 1) * CPU_BAND_ROWS, job->escape->height);
+
+	for (Uint32 y=index * CPU_BAND_ROWS; y<y_end; y++) {
+		const Uint32 *row = (const Uint32 *)((const Uint8 *) job->escape->pixels + (size_t) y * job->escape->stride);
+		for (Uint32 x=0; x<job->escape->width; x++) {
+			if (row[x] == RENDER_INTERIOR) continue;
+			Uint32 bin = (Uint32)((float)(row[x] - 1) * job->bin_scale);	// Same float maths as the shaders
+			counts[SDL_min(bin, COLOUR_HIST_BINS - 1)]++;
+		}
+	}
+}
+
+// Colours one band by where each pixel falls in the histogram
+static void __histogram_map_band(void *ctx, Uint32 index, int thread) {
+	Cpu_Hist_Job *job = (Cpu_Hist_Job *) ctx;
+	Uint32 y_end = SDL_min((index + 1) * CPU_BAND_ROWS, job->escape->height);
+	(void) thread;
+
+	for (Uint32 y=index * CPU_BAND_ROWS; y<y_end; y++) {
+		const Uint32 *row = (const Uint32 *)((const Uint8 *) job->escape->pixels + (size_t) y * job->escape->stride);
+		Uint8 *out = (Uint8 *) job->colour->pixels + (size_t) y * job->colour->stride;
+		for (Uint32 x=0; x<job->escape->width; x++) {
+			if (row[x] == RENDER_INTERIOR) {
+				out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = 0;
+				out[x * 4 + 3] = 255;
+				continue;
+			}
+			float bin_pos = (float)(row[x] - 1) * job->bin_scale;
+			Uint32 bin = SDL_min((Uint32) bin_pos, COLOUR_HIST_BINS - 1);
+			float within = SDL_min(bin_pos - (float) bin, 1.0f);
+			__spectrum((job->prefix[bin] + job->counts[bin] * within) / job->total, &out[x * 4]);
+		}
+	}
+}
+
+// Renders one band of rows
+static void __render_band(void *ctx, Uint32 index, int thread) {
+	Cpu_Job *job = (Cpu_Job *) ctx;
+	const Render_View *view = job->view;
+	const Kernel_Formula *formula = &job->formula;
+	const Cpu_Power *power = &__powers[formula->power];
+	bool julia = (formula->fractal == KERNEL_JULIA);
+	Uint32 y_start = index * CPU_BAND_ROWS;
+	Uint32 y_end = SDL_min(y_start + CPU_BAND_ROWS, job->height);
+	if (job->row_start != NULL) {
+		y_start = job->row_start[index];
+		y_end = SDL_min(job->row_start[index + 1], job->height);
+	}
+	Uint64 performed = 0;
+
+	// The double-float path does a whole row before colouring it
+	Cpu_DFloat *row_x = NULL;
+	Uint32 *row_escapes = NULL;
+	if (view->kernel == KERNEL_DFLOAT) {
+		row_x = SDL_malloc(sizeof(Cpu_DFloat) * ((job->width + CPU_LANES - 1) / CPU_LANES));
+		row_escapes = SDL_malloc(sizeof(Uint32) * job->width);
+	}
+
+	for (Uint32 y=y_start; y<y_end; y++) {
+		Uint8 *colour_row = NULL;
+		Uint32 *escape_row = NULL;
+		if (job->colour != NULL) colour_row = (Uint8 *) job->colour->pixels + (size_t) y * job->colour->stride;
+		if (job->escape != NULL) escape_row = (Uint32 *)((Uint8 *) job->escape->pixels + (size_t) y * job->escape->stride);
+
+		// Same mapping as the kernels' complex_from_coords()
+		double py = -(y - job->height / 2.0) / view->zoom + view->screen_y;
+		if (row_escapes != NULL) power->iterate_row(view, formula, y, job->width, job->height, row_x, row_escapes);
+		for (Uint32 x=0; x<job->width; x++) {
+			Uint32 esc;
+			if (row_escapes != NULL) {
+				esc = row_escapes[x];
+			} else {
+				double px = (x - job->width / 2.0) / view->zoom + view->screen_x;
+				if (julia) esc = power->iterate(px, py, formula->julia_x, formula->julia_y, view->iterations);
+				else esc = power->iterate(px, py, px, py, view->iterations);
+			}
+			performed += (esc == RENDER_INTERIOR) ? view->iterations : esc;
+
+			if (colour_row != NULL) cpu_colour(esc, view->iterations, &colour_row[x * 4]);
+			if (escape_row != NULL) escape_row[x] = esc;
+		}
+	}
+
+	SDL_free(row_x);
+	SDL_free(row_escapes);
+	job->iters[thread] += performed;
+}
+
+
+Uint64 cpu_render(Pool *pool, const Render_View *view, const Render_Target *colour, const Render_Target *escape) {
+	return cpu_render_bands(pool, view, colour, escape, NULL, 0);
+}
+
+Uint64 cpu_render_bands(Pool *pool, const Render_View *view, const Render_Target *colour, const Render_Target *escape, const Uint32 *row_start, Uint32 bands) {
+	const Render_Target *size_from = (colour != NULL) ? colour : escape;
+	if (size_from == NULL) return 0;
+
+	Cpu_Job *job = SDL_calloc(1, sizeof(Cpu_Job));
+	job->view = view;
+	job->formula = kernel_formula();
+	job->colour = colour;
+	job->escape = escape;
+	job->width = size_from->width;
+	job->height = size_from->height;
+	job->row_start = row_start;
+
+	if (row_start == NULL) bands = (job->height + CPU_BAND_ROWS - 1) / CPU_BAND_ROWS;
+	pool_run(pool, bands, __render_band, job);
+
+	Uint64 total = 0;
+	for (int i=0; i<pool_threads(pool); i++) total += job->iters[i];
+	SDL_free(job);
+	return total;
+}
+
+Uint32 cpu_iterate(double x, double y, Uint32 iterations) {
+	Kernel_Formula formula = kernel_formula();
+	const Cpu_Power *power = &__powers[formula.power];
+	if (formula.fractal == KERNEL_JULIA) return power->iterate(x, y, formula.julia_x, formula.julia_y, iterations);
+	return power->iterate(x, y, x, y, iterations);
+}
+
+Uint32 cpu_iterate_periodic(const Kernel_Formula *formula, double x, double y, Uint32 iterations, double tolerance, Uint64 *performed) {
+	const Cpu_Power *power = &__powers[formula->power];
+	if (formula->fractal == KERNEL_JULIA) return power->iterate_periodic(x, y, formula->julia_x, formula->julia_y, iterations, tolerance, performed);
+	return power->iterate_periodic(x, y, x, y, iterations, tolerance, performed);
+}
+
+void cpu_colour(Uint32 escape, Uint32 iterations, Uint8 *rgba) {
+	if (escape == RENDER_INTERIOR) {
+		rgba[0] = rgba[1] = rgba[2] = 0;
+		rgba[3] = 255;
+		return;
+	}
+
+	__spectrum((double)(escape - 1) / (double) iterations, rgba);
+}
+
+void cpu_colour_histogram(Pool *pool, const Render_Target *escape, const Render_Target *colour, Uint32 iterations) {
+	int threads = pool_threads(pool);
+	Uint32 bands = (escape->height + CPU_BAND_ROWS - 1) / CPU_BAND_ROWS;
+	Cpu_Hist_Job job = {
+		.escape = escape,
+		.colour = colour,
+		.bin_scale = colour_bin_scale(iterations),
+		.counts = SDL_calloc((size_t) threads * COLOUR_HIST_BINS, sizeof(Uint32)),
+		.prefix = SDL_malloc(COLOUR_HIST_BINS * sizeof(Uint32)),
+	};
+
+	// Per-thread histograms, so counting needs no atomics
+	pool_run(pool, bands, __histogram_band, &job);
+
+	// Merge them and prefix sum
+	for (int t=1; t<threads; t++) {
+		const Uint32 *counts = job.counts + (size_t) t * COLOUR_HIST_BINS;
+		for (int i=0; i<COLOUR_HIST_BINS; i++) job.counts[i] += counts[i];
+	}
+	for (int i=0; i<COLOUR_HIST_BINS; i++) {
+		job.prefix[i] = job.total;
+		job.total += job.counts[i];
+	}
+
+	pool_run(pool, bands, __histogram_map_band, &job);
+
+	SDL_free(job.counts);
+	SDL_free(job.prefix);
+}
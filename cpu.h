@@ -0,0 +1,71 @@
+//	
+//	Multithreaded CPU mandelbrot renderer
+//	
+//	Mirrors what the GL kernels compute (same coordinates, escape
+//	test and colours) using doubles, with rows split into bands
+//	that are handed out to a thread pool.
+//	
+//	The formula is whichever `kernel_set_formula()` last set. Each power
+//	of z has its own copy of the iteration loops, with the power
+//	unrolled into squarings like in the kernels, and the right copy is
+//	picked once per frame.
+//	
+//	Views asking for KERNEL_DFLOAT are iterated in double-floats
+//	instead, CPU_LANES pixels at a time with GCC vector extensions.
+//	Each lane is refilled with the next pixel of the row as soon as
+//	its pixel finishes, rather than waiting for the rest of its group.
+//	
+
+#ifndef CPU_H
+#define CPU_H
+
+#include <SDL2/SDL.h>
+
+#include "render.h"
+#include "pool.h"
+
+#define CPU_BAND_ROWS 8	// Rows per job handed to the thread pool
+#define CPU_LANES 4		// Pixels iterated together in the double-float path
+#define CPU_PERIODIC 0xFFFFFFFF	// Returned by `cpu_iterate_periodic()` for orbits found to repeat
+
+
+//	Renders a view into colour and/or escape targets
+//	
+//	Either target may be NULL, but if both are given they must be
+//	the same size.
+//	Returns the number of pixel-iterations performed.
+Uint64 cpu_render(Pool *pool, const Render_View *view, const Render_Target *colour, const Render_Target *escape);
+
+//	Renders a view like `cpu_render()`, but in bands of rows chosen by the caller
+//	
+//	`row_start` has `bands + 1` entries: band i covers rows `row_start[i]`
+//	up to `row_start[i + 1]`, the last entry being the height. If it's
+//	NULL, the bands are CPU_BAND_ROWS rows each.
+Uint64 cpu_render_bands(Pool *pool, const Render_View *view, const Render_Target *colour, const Render_Target *escape, const Uint32 *row_start, Uint32 bands);
+
+//	Iterates a single point of the complex plane with the current formula
+//	
+//	Returns the iteration it escaped at (from 1) or RENDER_INTERIOR.
+Uint32 cpu_iterate(double x, double y, Uint32 iterations);
+
+//	Iterates a single point with `formula`, also watching for its orbit repeating
+//	
+//	The orbit is compared against a point saved at every power of two
+//	iterations, and counts as repeating once it comes back to within
+//	`tolerance` of it. The iterations performed are added to `performed`.
+//	Returns the iteration it escaped at (from 1), CPU_PERIODIC, or
+//	RENDER_INTERIOR if neither happened within `iterations`.
+Uint32 cpu_iterate_periodic(const Kernel_Formula *formula, double x, double y, Uint32 iterations, double tolerance, Uint64 *performed);
+
+//	Works out the colour of a pixel from its escape value, like the kernels' `iter_colour()`
+//	
+void cpu_colour(Uint32 escape, Uint32 iterations, Uint8 *rgba);
+
+//	Colours a frame from its escape values with histogram colouring
+//	
+//	Matches `colour_apply()` with COLOUR_HISTOGRAM: each thread counts its
+//	bands into its own histogram, then they're merged, prefix summed and
+//	used to colour the frame. Both targets must be the same size.
+void cpu_colour_histogram(Pool *pool, const Render_Target *escape, const Render_Target *colour, Uint32 iterations);
+
+#endif
@@ -40,6 +40,18 @@ void demo_destroy_seq(Demo_Sequence *seq) {
 	SDL_free(seq);
 }
 
+Demo_Sequence *demo_copy_seq(Demo_Sequence *seq) {
+	if (seq == NULL) return NULL;
+	Demo_Sequence *copy = SDL_malloc(sizeof(Demo_Sequence));
+
+	copy->cap = seq->cap;
+	copy->frames = SDL_malloc(sizeof(Demo_Keyframe) * seq->cap);
+	copy->len = seq->len;
+	SDL_memcpy(copy->frames, seq->frames, sizeof(Demo_Keyframe) * seq->len);
+
+	return copy;
+}
+
 Demo_Sequence *demo_load_seq(char *demo_filename) {
 	if (demo_filename == NULL) return NULL;
 
@@ -346,6 +358,78 @@ bool demo_tick() {
 	return redraw;
 }
 
+Uint64 demo_seq_duration(Demo_Sequence *seq) {
+	if (seq == NULL) return 0;
+
+	Uint64 duration = 0;
+	for (Uint32 i=1; i<seq->len; i++) duration += seq->frames[i].delta_time;
+	return duration;
+}
+
+bool demo_eval(Demo_Sequence *seq, Uint64 time_ms, Demo_Var var, const void *start, void *ptr, size_t size) {
+	if (seq == NULL || start == NULL || ptr == NULL) return false;
+	Demo_Var_Binding bind = __var_bindings[var];
+	if (bind.size == 0 || bind.size != size) return false;
+
+	Demo_Keyframe curr = demo_create_keyframe(var, (void *) start, bind.size);
+	Uint64 group_start = 0;
+	Uint32 frame_index = 0;
+
+	while (frame_index < seq->len) {
+
+		// Find the extent of the next keyframe group and this var's target in it
+		Uint64 group_end = group_start;
+		if (frame_index > 0) group_end += seq->frames[frame_index].delta_time;
+
+		bool has_target = false;
+		Demo_Keyframe target;
+		Uint32 next_index = frame_index;
+		for (; next_index<seq->len; next_index++) {
+			Demo_Keyframe kf = seq->frames[next_index];
+			if (next_index > frame_index && kf.delta_time > 0) break;
+			if (kf.var != var) continue;
+			target = kf;
+			has_target = true;
+		}
+
+		// Interpolate within the group the time falls into
+		if (time_ms < group_end) {
+			if (has_target) {
+				float diff = demo_value_dif(var, curr.value, target.value);
+				float t = (float)(time_ms - group_start) / (float)(group_end - group_start);
+				demo_value_add(var, curr.value, diff * t);
+			}
+			break;
+		}
+
+		if (has_target) SDL_memcpy(curr.value, target.value, sizeof(Demo_Value));
+		group_start = group_end;
+		frame_index = next_index;
+	}
+
+	SDL_memcpy(ptr, curr.value, size);
+	return true;
+}
+
+void demo_apply(Demo_Sequence *seq, Uint64 time_ms) {
+	if (seq == NULL) return;
+
+	// Evaluate everything first, so no var sees another's new value as its start
+	Demo_Keyframe values[DEMO_MAX_VARS];
+	for (int v=0; v<DEMO_MAX_VARS; v++) {
+		Demo_Var_Binding bind = __var_bindings[v];
+		if (bind.size == 0) continue;
+		values[v] = demo_create_keyframe(v, NULL, 0);
+		demo_eval(seq, time_ms, v, bind.ptr, values[v].value, bind.size);	// Starting from whatever value they currently have
+	}
+
+	for (int v=0; v<DEMO_MAX_VARS; v++) {
+		Demo_Var_Binding bind = __var_bindings[v];
+		if (bind.size == 0) continue;
+		SDL_memcpy(bind.ptr, values[v].value, bind.size);
+	}
+}
+
 void demo_value_add(Demo_Var var, Demo_Value val, float delta_val) {
 	Demo_Var_Binding bind = __var_bindings[var];
 
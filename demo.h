@@ -78,6 +78,12 @@ Demo_Sequence *demo_create_seq();
 //	
 void demo_destroy_seq(Demo_Sequence *seq);
 
+//	Creates a copy of a demo sequence
+//	
+//	Returns created demo or NULL on error.
+//	Should be cleaned up with `demo_destroy_seq()`
+Demo_Sequence *demo_copy_seq(Demo_Sequence *seq);
+
 //	Loads a demo sequence from a demo file
 //	
 //	Returns created demo or NULL on error.
@@ -128,6 +134,25 @@ void demo_play(Demo_Sequence *sequence);
 //	
 void demo_stop();
 
+//	Gets the total running time of a demo sequence in milliseconds
+//	
+//	The first keyframe is applied straight away, so its delta time isn't counted.
+Uint64 demo_seq_duration(Demo_Sequence *seq);
+
+//	Evaluates the value a bound variable will have at some point of a sequence
+//	
+//	Follows the same interpolation as `demo_tick()`, but doesn't touch the
+//	bound variables, so frames can be computed ahead of playback.
+//	The variable starts out at `start` (of the bound size), so it can be
+//	evaluated without reading the bound variable from another thread.
+//	The result is written to `ptr` with the bound size (use `DEMO_BIND()`).
+//	Returns false if the variable isn't bound or `size` doesn't match.
+bool demo_eval(Demo_Sequence *seq, Uint64 time_ms, Demo_Var var, const void *start, void *ptr, size_t size);
+
+//	Sets every bound variable to its value at some point of a sequence
+//	
+void demo_apply(Demo_Sequence *seq, Uint64 time_ms);
+
 //	Processes ticks for the demo system
 //	
 //	Should be called between event and draw in main loop
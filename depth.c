@@ -0,0 +1,91 @@
+#include "depth.h"
+#include "cpu.h"
+
+typedef struct {
+	Kernel_Formula formula;	// Taken once, so the whole grid uses the same one
+	bool bulbs;			// Whether the z^2 Mandelbrot set's main cardioid and period-2 bulb can be skipped
+	double left;		// Complex coordinates of the first sample
+	double top;
+	double step_x;		// Between samples
+	double step_y;
+	double tolerance;	// For periodicity checks, on the complex plane
+	Uint32 *escapes;	// One per sample: the iteration it escaped at, CPU_PERIODIC or 0 if undecided
+	Uint64 iters[POOL_MAX_THREADS];
+} Depth_Job;
+
+
+// Checks whether a point is in the main cardioid or the period-2 bulb
+static bool __in_main_bulbs(double cx, double cy) {
+	double x = cx - 0.25;
+	double q = x * x + cy * cy;
+	if (q * (q + x) <= 0.25 * cy * cy) return true;
+	return (cx + 1.0) * (cx + 1.0) + cy * cy <= 0.0625;
+}
+
+// Iterates a point with the job's formula, unless it's known to be inside the set
+static Uint32 __sample(const Depth_Job *job, double cx, double cy, Uint64 *iters) {
+	if (job->bulbs && __in_main_bulbs(cx, cy)) return CPU_PERIODIC;
+	return cpu_iterate_periodic(&job->formula, cx, cy, DEPTH_MAX_ITERATIONS, job->tolerance, iters);
+}
+
+// Samples one row of the grid
+static void __sample_row(void *ctx, Uint32 index, int thread) {
+	Depth_Job *job = ctx;
+	double cy = job->top - index * job->step_y;
+	for (Uint32 x=0; x<DEPTH_GRID; x++) {
+		double cx = job->left + x * job->step_x;
+		job->escapes[index * DEPTH_GRID + x] = __sample(job, cx, cy, &job->iters[thread]);
+	}
+}
+
+static int __cmp_escape(const void *a, const void *b) {
+	Uint32 ea = *(const Uint32 *)a;
+	Uint32 eb = *(const Uint32 *)b;
+	return (ea > eb) - (ea < eb);
+}
+
+Depth_Result depth_choose(Pool *pool, double screen_x, double screen_y, double zoom, Uint32 width, Uint32 height) {
+	Uint64 start = SDL_GetPerformanceCounter();
+	Uint32 escapes[DEPTH_GRID * DEPTH_GRID];
+
+	// Each sample sits in the middle of its cell of the grid
+	Depth_Job job = {
+		.formula = kernel_formula(),
+		.step_x = width / (double) DEPTH_GRID / zoom,
+		.step_y = height / (double) DEPTH_GRID / zoom,
+		.tolerance = DEPTH_PERIOD_TOLERANCE / zoom,
+		.escapes = escapes,
+	};
+	job.bulbs = job.formula.fractal == KERNEL_MANDELBROT && job.formula.power == 2;
+	job.left = screen_x - width / 2.0 / zoom + job.step_x / 2.0;
+	job.top = screen_y + height / 2.0 / zoom - job.step_y / 2.0;
+	pool_run(pool, DEPTH_GRID, __sample_row, &job);
+
+	Depth_Result r = { .samples = DEPTH_GRID * DEPTH_GRID };
+	for (int t=0; t<pool_threads(pool); t++) r.sample_iters += job.iters[t];
+
+	// Pack the escaping samples to the front, then pick the limit from the top of their distribution
+	for (Uint32 i=0; i<r.samples; i++) {
+		if (escapes[i] == CPU_PERIODIC) r.interior++;
+		else if (escapes[i] != 0) escapes[r.escaped++] = escapes[i];
+	}
+
+	Uint32 limit = DEPTH_MIN_ITERATIONS;
+	if (r.escaped > 0) {
+		SDL_qsort(escapes, r.escaped, sizeof(Uint32), __cmp_escape);
+		Uint32 allowed = (Uint32)(DEPTH_UNRESOLVED_TARGET * r.escaped);
+		limit = escapes[r.escaped - 1 - allowed];
+		limit = (limit + DEPTH_ROUND - 1) / DEPTH_ROUND * DEPTH_ROUND;
+		limit = SDL_max(DEPTH_MIN_ITERATIONS, SDL_min(limit, DEPTH_MAX_ITERATIONS));
+		for (Uint32 i=r.escaped; i>0 && escapes[i - 1] > limit; i--) r.unresolved++;
+	}
+	r.iterations = limit;
+
+	r.ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+	return r;
+}
+
+void depth_print(const Depth_Result *r, FILE *f) {
+	fprintf(f, "---> Depth %u: %u of %u samples escaped, %u unresolved, %u inside; sampled %.1lf Miters in %.2lf ms\n",
+		r->iterations, r->escaped, r->samples, r->unresolved, r->interior, r->sample_iters / 1.0e6, r->ms);
+}
@@ -0,0 +1,54 @@
+//	
+//	Automatic iteration depth from escape statistics
+//	
+//	Before a frame is rendered, a sparse grid of points over the view
+//	is iterated on the CPU with the current formula, up to
+//	DEPTH_MAX_ITERATIONS. Orbits that come back to within a fraction
+//	of a pixel of an earlier point are taken to be periodic, and for
+//	the z^2 Mandelbrot set, points in the main cardioid or the
+//	period-2 bulb are skipped outright, so most of the inside of the
+//	set costs little. The rest escape at some iteration, and the limit is set
+//	just high enough that no more than DEPTH_UNRESOLVED_TARGET of them
+//	would escape after it, and so be drawn as if they were inside.
+//	
+
+#ifndef DEPTH_H
+#define DEPTH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+
+#include "pool.h"
+
+#define DEPTH_GRID 48					// Points sampled along each axis
+#define DEPTH_MIN_ITERATIONS 64
+#define DEPTH_MAX_ITERATIONS 65536
+#define DEPTH_UNRESOLVED_TARGET 0.005	// Greatest fraction of escaping samples left unresolved
+#define DEPTH_ROUND 64					// Limits are rounded up to a multiple of this, so they don't change with every small move
+#define DEPTH_PERIOD_TOLERANCE 0.01		// In pixels, how close an orbit must come back to count as periodic
+
+
+typedef struct {
+	Uint32 iterations;		// Chosen limit
+	Uint32 samples;
+	Uint32 escaped;			// Samples that escaped by DEPTH_MAX_ITERATIONS
+	Uint32 interior;		// Samples found to be inside the set
+	Uint32 unresolved;		// Escaping samples the chosen limit stops short of
+	Uint64 sample_iters;	// Iterations spent sampling
+	double ms;				// Time spent sampling
+} Depth_Result;
+
+
+//	Chooses the iteration limit for a view
+//	
+//	`width`x`height` is the size of the frame in pixels and `zoom` is
+//	in pixels per unit. The samples are spread over `pool`'s threads.
+Depth_Result depth_choose(Pool *pool, double screen_x, double screen_y, double zoom, Uint32 width, Uint32 height);
+
+//	Prints what was chosen and what sampling cost to a file (e.g. stdout)
+//	
+void depth_print(const Depth_Result *r, FILE *f);
+
+#endif
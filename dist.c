@@ -0,0 +1,688 @@
+#include "dist.h"
+#include "demo.h"
+#include "image.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#include <signal.h>
+#endif
+
+#define DIST_MAGIC_HELLO 0x4C45484Du	// "MHEL"
+#define DIST_MAGIC_JOB 0x424F4A4Du		// "MJOB"
+#define DIST_MAGIC_RESULT 0x5345524Du	// "MRES"
+#define DIST_VERSION 1
+#define DIST_SHUTDOWN 0xFFFFFFFFu		// Job id that tells a worker to exit
+#define DIST_POLL_MS 100
+
+#ifdef _WIN32
+typedef intptr_t Dist_Process;	// As returned by _spawnl()
+#else
+typedef pid_t Dist_Process;
+#endif
+
+// Sent by a worker when it connects
+typedef struct {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 backend;
+	Uint32 threads;
+} Dist_Hello;
+
+// One tile of one frame to render
+typedef struct {
+	Uint32 magic;
+	Uint32 id;
+	Uint32 frame_w;
+	Uint32 frame_h;
+	Uint32 tile_x;
+	Uint32 tile_y;
+	Uint32 tile_w;
+	Uint32 tile_h;
+	Uint32 iterations;
+	Uint32 kernel;
+	double screen_x;
+	double screen_y;
+	double zoom;
+} Dist_Job_Msg;
+
+// Sent back for each job, followed by the tile's RGBA8 pixels
+typedef struct {
+	Uint32 magic;
+	Uint32 id;
+	Uint32 tile_w;
+	Uint32 tile_h;
+	Uint64 iterations;
+	double render_ms;
+} Dist_Result_Msg;
+
+typedef enum {
+	DIST_JOB_PENDING,
+	DIST_JOB_OUT,
+	DIST_JOB_DONE,
+} Dist_Job_State;
+
+typedef struct {
+	Uint32 x;
+	Uint32 y;
+	Uint32 w;
+	Uint32 h;
+	Dist_Job_State state;
+	int copies;			// Workers currently holding this job
+	double sent_ms;		// When the first copy still out was sent
+} Dist_Job;
+
+typedef struct {
+	Net_Socket sock;
+	Uint32 in_flight[DIST_JOBS_IN_FLIGHT];	// Ids of the jobs it's working through, oldest first
+	int num_in_flight;
+	double last_heard_ms;	// Last result, or when it was given work while idle
+	Uint32 jobs_done;
+	double busy_ms;			// Time spent rendering, as reported by the worker
+	Dist_Hello hello;
+} Dist_Worker;
+
+typedef struct {
+	bool net_ready;
+	Net_Socket listener;
+	Dist_Worker workers[DIST_MAX_WORKERS];
+	int num_workers;
+	int workers_seen;
+	Dist_Process spawned[DIST_MAX_WORKERS];	// Workers started on this machine
+	int num_spawned;
+	Pool *encode_pool;
+
+	// Current frame
+	Render_View view;
+	Uint32 width;
+	Uint32 height;
+	Uint32 first_id;	// Id of the first job of this frame; anything lower is stale
+	Dist_Job *jobs;
+	Uint32 num_jobs;
+	Uint32 jobs_done;
+	Uint32 next_pending;	// No pending jobs before this one
+	Uint8 *image;
+	double *durations;	// Send-to-result time of each finished job
+	Uint32 slow_done;	// Jobs that were done when `slow_ms` was worked out
+	double slow_ms;		// Jobs out for longer than this are worth duplicating
+	Uint8 *scratch;		// Tiles are received into here first
+	size_t scratch_size;
+
+	// Totals
+	Uint64 iterations;
+	Uint32 reissued;	// Jobs handed out again after their worker was dropped
+	Uint32 duplicated;	// Copies of slow jobs handed to idle workers
+	Uint32 wasted;		// Results thrown away because another copy finished first
+} Dist_Coordinator;
+
+static double __now_ms() {
+	return (double) SDL_GetPerformanceCounter() * 1000.0 / (double) SDL_GetPerformanceFrequency();
+}
+
+static int __cmp_double(const void *a, const void *b) {
+	double da = *(const double *) a;
+	double db = *(const double *) b;
+	return (da > db) - (da < db);
+}
+
+// Starts a worker process on this machine, returning -1 if it couldn't be
+static Dist_Process __spawn_worker(const char *program, const char *address, int threads) {
+	char threads_str[16];
+	SDL_snprintf(threads_str, sizeof(threads_str), "%i", threads);
+#ifdef _WIN32
+	Dist_Process process = _spawnl(_P_NOWAIT, program, program, "--worker", address, "--cpu", "--threads", threads_str, NULL);
+#else
+	Dist_Process process = fork();
+	if (process == 0) {
+		execl(program, program, "--worker", address, "--cpu", "--threads", threads_str, (char *) NULL);
+		_exit(1);
+	}
+#endif
+	if (process == -1) printf("[ERROR] Failed to start worker '%s'\n", program);
+	return process;
+}
+
+// Waits for a spawned worker to exit, first stopping it if `kill_it` is set
+static void __reap_worker(Dist_Process process, bool kill_it) {
+#ifdef _WIN32
+	if (kill_it) TerminateProcess((HANDLE) process, 1);
+	_cwait(NULL, process, 0);
+#else
+	if (kill_it) kill(process, SIGTERM);
+	waitpid(process, NULL, 0);
+#endif
+}
+
+// Takes a new worker from the listener
+static void __accept_worker(Dist_Coordinator *c) {
+	Net_Socket s = net_accept(c->listener);
+	if (s == NET_INVALID) return;
+	net_set_timeout(s, DIST_WORKER_TIMEOUT_MS);
+
+	Dist_Hello hello;
+	if (net_recv_all(s, &hello, sizeof(hello)) != 0 || hello.magic != DIST_MAGIC_HELLO || hello.version != DIST_VERSION) {
+		puts("[WARN ] Rejected a connection that isn't a worker (or is a different version)");
+		net_close(s);
+		return;
+	}
+	if (c->num_workers >= DIST_MAX_WORKERS) {
+		puts("[WARN ] Too many workers, turning one away");
+		net_close(s);
+		return;
+	}
+
+	Dist_Worker *w = &c->workers[c->num_workers++];
+	SDL_zerop(w);
+	w->sock = s;
+	w->hello = hello;
+	w->last_heard_ms = __now_ms();
+	c->workers_seen++;
+	printf("---> Worker %i connected (%s, %u threads)\n", c->workers_seen, render_backend_name(hello.backend), hello.threads);
+	fflush(stdout);
+}
+
+// Disconnects a worker and puts the jobs only it held back in the queue
+static void __drop_worker(Dist_Coordinator *c, int index, const char *reason) {
+	Dist_Worker *w = &c->workers[index];
+	printf("[WARN ] Dropping a worker: %s\n", reason);
+	fflush(stdout);
+
+	for (int i=0; i<w->num_in_flight; i++) {
+		Uint32 id = w->in_flight[i];
+		if (id < c->first_id) continue;
+		Dist_Job *job = &c->jobs[id - c->first_id];
+		job->copies--;
+		if (job->state == DIST_JOB_OUT && job->copies == 0) {
+			job->state = DIST_JOB_PENDING;
+			c->next_pending = SDL_min(c->next_pending, id - c->first_id);
+			c->reissued++;
+		}
+	}
+
+	net_close(w->sock);
+	c->workers[index] = c->workers[--c->num_workers];
+}
+
+static bool __holds(const Dist_Worker *w, Uint32 id) {
+	for (int i=0; i<w->num_in_flight; i++) {
+		if (w->in_flight[i] == id) return true;
+	}
+	return false;
+}
+
+// Picks the next job for a worker, returning -1 if there's nothing worth giving it
+static int __pick_job(Dist_Coordinator *c, const Dist_Worker *w, double now) {
+	while (c->next_pending < c->num_jobs && c->jobs[c->next_pending].state != DIST_JOB_PENDING) c->next_pending++;
+	if (c->next_pending < c->num_jobs) return c->next_pending;
+
+	// Nothing left to hand out, so help with the oldest job that's taking too long
+	if (c->jobs_done == 0) return -1;
+	if (c->slow_done != c->jobs_done) {
+		qsort(c->durations, c->jobs_done, sizeof(double), __cmp_double);
+		c->slow_ms = c->durations[c->jobs_done / 2] * DIST_SLOW_FACTOR;
+		c->slow_done = c->jobs_done;
+	}
+
+	int oldest = -1;
+	for (Uint32 i=0; i<c->num_jobs; i++) {
+		Dist_Job *job = &c->jobs[i];
+		if (job->state != DIST_JOB_OUT || job->copies >= DIST_MAX_COPIES) continue;
+		if (now - job->sent_ms < c->slow_ms || __holds(w, c->first_id + i)) continue;
+		if (oldest < 0 || job->sent_ms < c->jobs[oldest].sent_ms) oldest = i;
+	}
+	if (oldest >= 0) c->duplicated++;
+	return oldest;
+}
+
+// Sends a job to a worker, returning 1 if the worker couldn't be reached
+static int __send_job(Dist_Coordinator *c, Dist_Worker *w, int index, double now) {
+	Dist_Job *job = &c->jobs[index];
+	Dist_Job_Msg msg = {
+		.magic = DIST_MAGIC_JOB,
+		.id = c->first_id + index,
+		.frame_w = c->width,
+		.frame_h = c->height,
+		.tile_x = job->x,
+		.tile_y = job->y,
+		.tile_w = job->w,
+		.tile_h = job->h,
+		.iterations = c->view.iterations,
+		.kernel = c->view.kernel,
+		.screen_x = c->view.screen_x,
+		.screen_y = c->view.screen_y,
+		.zoom = c->view.zoom,
+	};
+	if (net_send_all(w->sock, &msg, sizeof(msg)) != 0) return 1;
+
+	if (job->state == DIST_JOB_PENDING) {
+		job->state = DIST_JOB_OUT;
+		job->sent_ms = now;
+	}
+	job->copies++;
+	if (w->num_in_flight == 0) w->last_heard_ms = now;
+	w->in_flight[w->num_in_flight++] = msg.id;
+	return 0;
+}
+
+// Reads a result from a worker into the frame, returning 1 if the worker misbehaved
+static int __receive_result(Dist_Coordinator *c, Dist_Worker *w, double now) {
+	Dist_Result_Msg msg;
+	if (net_recv_all(w->sock, &msg, sizeof(msg)) != 0) return 1;
+	if (msg.magic != DIST_MAGIC_RESULT || !__holds(w, msg.id)) return 1;
+
+	size_t size = (size_t) msg.tile_w * msg.tile_h * 4;
+	if (size > c->scratch_size) {
+		c->scratch = SDL_realloc(c->scratch, size);
+		c->scratch_size = size;
+	}
+	if (net_recv_all(w->sock, c->scratch, size) != 0) return 1;
+
+	// No longer in flight
+	for (int i=0; i<w->num_in_flight; i++) {
+		if (w->in_flight[i] != msg.id) continue;
+		SDL_memmove(&w->in_flight[i], &w->in_flight[i + 1], (w->num_in_flight - i - 1) * sizeof(Uint32));
+		w->num_in_flight--;
+		break;
+	}
+	w->last_heard_ms = now;
+	w->jobs_done++;
+	w->busy_ms += msg.render_ms;
+
+	// From an earlier frame that was finished by another copy
+	if (msg.id < c->first_id) {
+		c->wasted++;
+		return 0;
+	}
+
+	Dist_Job *job = &c->jobs[msg.id - c->first_id];
+	job->copies--;
+	if (job->state == DIST_JOB_DONE) {
+		c->wasted++;
+		return 0;
+	}
+	if (msg.tile_w != job->w || msg.tile_h != job->h) return 1;
+
+	for (Uint32 y=0; y<job->h; y++) {
+		Uint8 *dst = c->image + ((size_t)(job->y + y) * c->width + job->x) * 4;
+		SDL_memcpy(dst, c->scratch + (size_t) y * job->w * 4, job->w * 4);
+	}
+	job->state = DIST_JOB_DONE;
+	c->durations[c->jobs_done++] = now - job->sent_ms;
+	c->iterations += msg.iterations;
+	return 0;
+}
+
+// Renders one frame across the workers into `c->image`, returning 1 if it couldn't be finished
+static int __render_frame(Dist_Coordinator *c, Uint32 tile_size) {
+	// Split the frame into tiles
+	Uint32 tiles_x = (c->width + tile_size - 1) / tile_size;
+	Uint32 tiles_y = (c->height + tile_size - 1) / tile_size;
+	c->first_id += c->num_jobs;
+	c->num_jobs = tiles_x * tiles_y;
+	c->jobs_done = 0;
+	c->slow_done = 0;
+	c->next_pending = 0;
+	for (Uint32 ty=0; ty<tiles_y; ty++) {
+		for (Uint32 tx=0; tx<tiles_x; tx++) {
+			Dist_Job *job = &c->jobs[ty * tiles_x + tx];
+			job->x = tx * tile_size;
+			job->y = ty * tile_size;
+			job->w = SDL_min(tile_size, c->width - job->x);
+			job->h = SDL_min(tile_size, c->height - job->y);
+			job->state = DIST_JOB_PENDING;
+			job->copies = 0;
+		}
+	}
+
+	double no_workers_since = __now_ms();
+	while (c->jobs_done < c->num_jobs) {
+		double now = __now_ms();
+
+		// Keep every worker's queue topped up
+		for (int i=c->num_workers - 1; i>=0; i--) {
+			Dist_Worker *w = &c->workers[i];
+			while (w->num_in_flight < DIST_JOBS_IN_FLIGHT) {
+				int index = __pick_job(c, w, now);
+				if (index < 0) break;
+				if (__send_job(c, w, index, now) != 0) {
+					__drop_worker(c, i, "couldn't send it a job");
+					break;
+				}
+			}
+		}
+
+		if (c->num_workers > 0) no_workers_since = now;
+		else if (now - no_workers_since > DIST_WAIT_WORKERS_MS) {
+			puts("[ERROR] No workers left to finish the frame");
+			return 1;
+		}
+
+		// Wait for results (or new workers)
+		Net_Socket sockets[DIST_MAX_WORKERS + 1];
+		bool readable[DIST_MAX_WORKERS + 1];
+		int num_workers = c->num_workers;
+		sockets[0] = c->listener;
+		for (int i=0; i<num_workers; i++) sockets[i + 1] = c->workers[i].sock;
+		if (net_wait(sockets, num_workers + 1, DIST_POLL_MS, readable) < 0) {
+			puts("[ERROR] Failed waiting on workers");
+			return 1;
+		}
+
+		now = __now_ms();
+		for (int i=num_workers - 1; i>=0; i--) {
+			Dist_Worker *w = &c->workers[i];
+			if (readable[i + 1]) {
+				if (__receive_result(c, w, now) != 0) __drop_worker(c, i, "connection lost");
+			} else if (w->num_in_flight > 0 && now - w->last_heard_ms > DIST_WORKER_TIMEOUT_MS) {
+				__drop_worker(c, i, "timed out");
+			}
+		}
+		if (readable[0]) __accept_worker(c);
+	}
+
+	return 0;
+}
+
+// Waits a short while for the copies of jobs that lost to another worker, so they're counted before the workers are let go
+static void __drain_workers(Dist_Coordinator *c) {
+	double deadline = __now_ms() + DIST_DRAIN_MS;
+	for (;;) {
+		Net_Socket sockets[DIST_MAX_WORKERS];
+		bool readable[DIST_MAX_WORKERS];
+		int num_workers = 0;
+		for (int i=0; i<c->num_workers; i++) {
+			if (c->workers[i].num_in_flight > 0) num_workers++;
+			sockets[i] = c->workers[i].sock;
+		}
+		double now = __now_ms();
+		if (num_workers == 0 || now >= deadline) return;
+
+		if (net_wait(sockets, c->num_workers, (Uint32)(deadline - now) + 1, readable) <= 0) return;
+		now = __now_ms();
+		for (int i=c->num_workers - 1; i>=0; i--) {
+			if (readable[i] && __receive_result(c, &c->workers[i], now) != 0) __drop_worker(c, i, "connection lost");
+		}
+	}
+}
+
+// Lets the workers go and frees everything the coordinator holds, returning `result`
+// Every way out of the coordinator ends here, so nothing is leaked or left running when it fails
+static int __coordinator_end(Dist_Coordinator *c, Demo_Sequence *seq, int result) {
+	if (c != NULL) {
+		for (int i=0; i<c->num_workers; i++) {
+			Dist_Job_Msg bye = { .magic = DIST_MAGIC_JOB, .id = DIST_SHUTDOWN };
+			net_send_all(c->workers[i].sock, &bye, sizeof(bye));
+			net_close(c->workers[i].sock);
+		}
+
+		// Spawned workers exit once told to, but after a failure some may never have connected
+		for (int i=0; i<c->num_spawned; i++) __reap_worker(c->spawned[i], result != 0);
+
+		if (c->listener != NET_INVALID) net_close(c->listener);
+		if (c->net_ready) net_term();
+		if (c->encode_pool != NULL) pool_destroy(c->encode_pool);
+		SDL_free(c->jobs);
+		SDL_free(c->durations);
+		SDL_free(c->image);
+		SDL_free(c->scratch);
+		SDL_free(c);
+	}
+	if (seq != NULL) demo_destroy_seq(seq);
+	SDL_Quit();
+	return result;
+}
+
+
+int dist_coordinator_main(const char *program, int argc, char *argv[]) {
+	const char *address = DIST_DEFAULT_ADDRESS;
+	const char *demo_filename = NULL;
+	const char *out_prefix = "render";
+	Image_Format format = IMAGE_BMP;
+	Render_View view = { -0.7436, 0.1318, 0.0, 1000, KERNEL_AUTO, COLOUR_LINEAR };
+	double span = 0.01;	// Width of the view in the complex plane
+	Uint32 width = DIST_DEFAULT_SIZE;
+	Uint32 height = DIST_DEFAULT_SIZE;
+	Uint32 tile_size = DIST_TILE_SIZE;
+	int fps = DIST_DEFAULT_FPS;
+	int spawn = 0;
+	int threads = 0;
+	int wait_for = 0;
+
+	// Parse options
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--listen") == 0 && has_val) address = argv[++i];
+		else if (SDL_strcmp(argv[i], "--size") == 0 && has_val) width = height = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--width") == 0 && has_val) width = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--height") == 0 && has_val) height = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--x") == 0 && has_val) view.screen_x = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--y") == 0 && has_val) view.screen_y = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--span") == 0 && has_val) span = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--iters") == 0 && has_val) view.iterations = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--kernel") == 0 && has_val) view.kernel = kernel_from_name(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--tile") == 0 && has_val) tile_size = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--demo") == 0 && has_val) demo_filename = argv[++i];
+		else if (SDL_strcmp(argv[i], "--fps") == 0 && has_val) fps = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--out") == 0 && has_val) out_prefix = argv[++i];
+		else if (SDL_strcmp(argv[i], "--format") == 0 && has_val) format = image_format_from_name(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--workers") == 0 && has_val) wait_for = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--spawn") == 0 && has_val) spawn = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--threads") == 0 && has_val) threads = SDL_atoi(argv[++i]);
+		else {
+			printf("[ERROR] Unknown coordinator option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (width == 0 || height == 0 || tile_size == 0 || fps <= 0 || span <= 0.0 || view.kernel == KERNEL_COUNT || format == IMAGE_FORMAT_COUNT
+		|| spawn < 0 || spawn > DIST_MAX_WORKERS) {
+		puts("[ERROR] Invalid coordinator options");
+		return 1;
+	}
+	if (wait_for < SDL_max(spawn, 1)) wait_for = SDL_max(spawn, 1);
+	if (spawn > 0 && threads <= 0) threads = SDL_max(SDL_GetCPUCount() / spawn, 1);
+	view.zoom = width / span;
+
+	// Work out the frames to render
+	Demo_Sequence *seq = NULL;
+	Uint32 num_frames = 1;
+	if (demo_filename != NULL) {
+		demo_bind_var(DEMO_VAR_SCREEN_X, DEMO_FLOAT, DEMO_BIND(view.screen_x));
+		demo_bind_var(DEMO_VAR_SCREEN_Y, DEMO_FLOAT, DEMO_BIND(view.screen_y));
+		demo_bind_var(DEMO_VAR_ZOOM, DEMO_FLOAT, DEMO_BIND(view.zoom));
+		demo_bind_var(DEMO_VAR_ITERS, DEMO_INTEGER, DEMO_BIND(view.iterations));
+		seq = demo_load_seq((char *) demo_filename);
+		if (seq == NULL) return 1;
+		num_frames = (Uint32)(demo_seq_duration(seq) * fps / 1000) + 1;
+	}
+
+	if (SDL_Init(0) < 0) return __coordinator_end(NULL, seq, 1);
+	Dist_Coordinator *c = SDL_calloc(1, sizeof(Dist_Coordinator));
+	if (c == NULL) {
+		puts("[ERROR] Not enough memory for the coordinator");
+		return __coordinator_end(NULL, seq, 1);
+	}
+	c->listener = NET_INVALID;
+	c->net_ready = net_init() == 0;
+	if (!c->net_ready) return __coordinator_end(c, seq, 1);
+	c->listener = net_listen(address);
+	if (c->listener == NET_INVALID) {
+		printf("[ERROR] Failed to listen on '%s'\n", address);
+		return __coordinator_end(c, seq, 1);
+	}
+	printf("---> Coordinator listening on '%s'\n", address);
+	fflush(stdout);
+
+	for (int i=0; i<spawn; i++) {
+		Dist_Process process = __spawn_worker(program, address, threads);
+		if (process != -1) c->spawned[c->num_spawned++] = process;
+	}
+
+	// Wait for the workers before starting, so timings are fair
+	double wait_start = __now_ms();
+	while (c->num_workers < wait_for && __now_ms() - wait_start < DIST_WAIT_WORKERS_MS) {
+		bool readable;
+		if (net_wait(&c->listener, 1, DIST_POLL_MS, &readable) > 0) __accept_worker(c);
+	}
+	if (c->num_workers == 0) {
+		puts("[ERROR] No workers connected");
+		return __coordinator_end(c, seq, 1);
+	}
+
+	Uint32 max_tiles = ((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+	c->jobs = SDL_calloc(max_tiles, sizeof(Dist_Job));
+	c->durations = SDL_calloc(max_tiles, sizeof(double));
+	c->image = SDL_malloc((size_t) width * height * 4);
+	if (c->jobs == NULL || c->durations == NULL || c->image == NULL) {
+		printf("[ERROR] Not enough memory for a %ux%u frame\n", width, height);
+		return __coordinator_end(c, seq, 1);
+	}
+	c->width = width;
+	c->height = height;
+	c->encode_pool = (format == IMAGE_BMP) ? NULL : pool_create(0);
+
+	// Render every frame
+	printf("---> Rendering %u frame(s) of %ux%u in %u tiles with %i worker(s)\n", num_frames, width, height, max_tiles, c->num_workers);
+	fflush(stdout);
+	int result = 0;
+	double start = __now_ms();
+	for (Uint32 f=0; f<num_frames; f++) {
+		c->view = view;
+		if (seq != NULL) {
+			demo_apply(seq, (Uint64) f * 1000 / fps);
+			c->view = view;
+			c->view.zoom *= (double) width / DIST_DEMO_WIDTH;	// Keep the framing it was recorded with
+		}
+
+		if (__render_frame(c, tile_size) != 0) {
+			result = 1;
+			break;
+		}
+
+		char filename[512];
+		const char *extension = image_format_extension(format);
+		if (seq != NULL) SDL_snprintf(filename, sizeof(filename), "%s_%05u.%s", out_prefix, f, extension);
+		else SDL_snprintf(filename, sizeof(filename), "%s.%s", out_prefix, extension);
+		if (image_save(filename, format, c->image, width, height, width * 4, c->encode_pool) != 0) result = 1;
+	}
+	double elapsed = __now_ms() - start;
+	if (result == 0) __drain_workers(c);
+
+	// Report
+	if (result == 0) {
+		double pixels = (double) width * height * num_frames;
+		printf("---> Rendered in %.1lf ms: %.2lf Mpixel/s, %.3lf Giter/s\n", elapsed, pixels / elapsed / 1000.0, (double) c->iterations / elapsed / 1.0e6);
+		printf("      %u jobs handed out again, %u slow jobs duplicated, %u results discarded\n", c->reissued, c->duplicated, c->wasted);
+		for (int i=0; i<c->num_workers; i++) {
+			Dist_Worker *w = &c->workers[i];
+			printf("      Worker %-3i %6u jobs, %5.1lf%% busy\n", i + 1, w->jobs_done, w->busy_ms / elapsed * 100.0);
+		}
+		fflush(stdout);
+	}
+
+	return __coordinator_end(c, seq, result);
+}
+
+int dist_worker_main(int argc, char *argv[]) {
+	const char *address = DIST_DEFAULT_ADDRESS;
+	Render_Backend backend = RENDER_BACKEND_GL;
+	int threads = 0;
+
+	// Parse options
+	int first_opt = 1;
+	if (argc > 1 && SDL_strncmp(argv[1], "--", 2) != 0) {
+		address = argv[1];
+		first_opt = 2;
+	}
+	for (int i=first_opt; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--cpu") == 0) backend = RENDER_BACKEND_CPU;
+		else if (SDL_strcmp(argv[i], "--threads") == 0 && has_val) threads = SDL_atoi(argv[++i]);
+		else {
+			printf("[ERROR] Unknown worker option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (SDL_Init(0) < 0) return 1;
+	if (net_init() != 0) {
+		SDL_Quit();
+		return 1;
+	}
+
+	// The coordinator may still be starting up
+	Net_Socket s = NET_INVALID;
+	double start = __now_ms();
+	while (s == NET_INVALID && __now_ms() - start < DIST_CONNECT_RETRY_MS) {
+		s = net_connect(address);
+		if (s == NET_INVALID) SDL_Delay(DIST_POLL_MS);
+	}
+	if (s == NET_INVALID) {
+		printf("[ERROR] Couldn't connect to the coordinator at '%s'\n", address);
+		net_term();
+		SDL_Quit();
+		return 1;
+	}
+
+	Render_Handle *h = render_create(backend);
+	if (h == NULL) {
+		net_close(s);
+		net_term();
+		SDL_Quit();
+		return 1;
+	}
+	if (threads > 0) render_set_threads(h, threads);
+
+	Dist_Hello hello = { DIST_MAGIC_HELLO, DIST_VERSION, backend, 0 };
+	if (backend == RENDER_BACKEND_CPU) hello.threads = (threads > 0) ? threads : SDL_GetCPUCount();
+	net_send_all(s, &hello, sizeof(hello));
+
+	// Render jobs until told to stop
+	Uint8 *pixels = NULL;
+	size_t pixels_size = 0;
+	Uint32 jobs = 0;
+	Dist_Job_Msg job;
+	while (net_recv_all(s, &job, sizeof(job)) == 0 && job.magic == DIST_MAGIC_JOB && job.id != DIST_SHUTDOWN) {
+		size_t size = (size_t) job.tile_w * job.tile_h * 4;
+		if (size > pixels_size) {
+			pixels = SDL_realloc(pixels, size);
+			pixels_size = size;
+		}
+
+		// Centre the view on the tile, keeping the frame's pixel grid
+		Render_View view = {
+			job.screen_x + (job.tile_x + job.tile_w / 2.0 - job.frame_w / 2.0) / job.zoom,
+			job.screen_y - (job.tile_y + job.tile_h / 2.0 - job.frame_h / 2.0) / job.zoom,
+			job.zoom,
+			job.iterations,
+			job.kernel,
+			COLOUR_LINEAR,	// Histograms need the whole frame, which no one worker has
+		};
+
+		// Every tile of a frame should use the same kernel, so choose it for the whole frame
+		if (view.kernel == KERNEL_AUTO && backend == RENDER_BACKEND_GL) {
+			view.kernel = kernel_choose(job.screen_x, job.screen_y, job.zoom, job.frame_w, job.frame_h);
+		}
+
+		Render_Target target = { pixels, job.tile_w, job.tile_h, job.tile_w * 4, RENDER_FORMAT_RGBA8 };
+		double render_start = __now_ms();
+		if (render_frame(h, &view, &target) != 0) {
+			puts("[ERROR] Failed to render a job");
+			break;
+		}
+
+		Dist_Result_Msg result = { DIST_MAGIC_RESULT, job.id, job.tile_w, job.tile_h, render_last_iterations(h), __now_ms() - render_start };
+		if (net_send_all(s, &result, sizeof(result)) != 0 || net_send_all(s, pixels, size) != 0) break;
+		jobs++;
+	}
+
+	printf("---> Worker finished after %u jobs\n", jobs);
+	SDL_free(pixels);
+	render_destroy(h);
+	net_close(s);
+	net_term();
+	SDL_Quit();
+	return 0;
+}
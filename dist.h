@@ -0,0 +1,74 @@
+//	
+//	Distributed rendering across worker processes
+//	
+//	A coordinator splits each frame (a single view, or every frame
+//	of a demo) into tiles and hands them out as jobs to any number
+//	of workers connected over TCP or Unix sockets, then assembles
+//	the tiles they send back and saves the frames.
+//	
+//	Each worker keeps a couple of jobs queued so it never waits on
+//	the network. Jobs from a worker that disconnects or goes quiet
+//	are handed out again, and once there is nothing left to hand
+//	out, jobs that are taking much longer than usual are duplicated
+//	on idle workers, with whichever copy finishes first being kept.
+//	
+//	Messages are sent as raw structs, so every machine involved
+//	needs the same byte order.
+//	
+
+#ifndef DIST_H
+#define DIST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "net.h"
+#include <SDL2/SDL.h>
+
+#include "kernel.h"
+#include "render.h"
+
+#define DIST_DEFAULT_ADDRESS "127.0.0.1:5757"
+#define DIST_DEFAULT_SIZE 2048
+#define DIST_DEFAULT_FPS 30
+#define DIST_DEMO_WIDTH 1024		// Window width demos are recorded at
+#define DIST_TILE_SIZE 128			// Width and height of the tiles a frame is split into
+#define DIST_MAX_WORKERS 64
+#define DIST_JOBS_IN_FLIGHT 2		// Jobs each worker has queued at once
+#define DIST_WORKER_TIMEOUT_MS 30000	// Workers with jobs out that are silent this long are dropped
+#define DIST_WAIT_WORKERS_MS 30000	// How long to wait for workers to connect
+#define DIST_SLOW_FACTOR 4.0		// Jobs out this many times longer than the median are duplicated
+#define DIST_MAX_COPIES 2			// Most workers a single job is given to at once
+#define DIST_DRAIN_MS 1000			// How long to wait for the losing copies of the last frame's jobs
+#define DIST_CONNECT_RETRY_MS 10000	// How long workers keep retrying to connect
+
+
+//	Runs the coordinator (`mandelbrot.exe --coordinator ...`)
+//	
+//	`program` is the path to this executable, for spawning local workers.
+//	`argv[0]` is expected to be the "--coordinator" switch itself.
+//	Options:
+//		--listen ADDRESS  Where workers connect to (default 127.0.0.1:5757, or unix:PATH)
+//		--spawn N         Starts N CPU workers on this machine
+//		--workers N       Waits for N workers to connect before starting
+//		--threads N       Threads for each spawned worker (default the cores shared between them)
+//		--size N          Renders N x N frames (or --width N / --height N)
+//		--x X / --y Y     Centre of the view
+//		--span W          Width of the view on the complex plane
+//		--iters N         Iterations per pixel
+//		--kernel NAME     Kernel the workers use
+//		--demo FILE       Renders every frame of a demo instead of a single view
+//		--fps N           Frames per second of demo playback
+//		--tile N          Width and height of the tiles in pixels
+//		--out PREFIX      Saves to PREFIX.EXT, or PREFIX_00000.EXT onwards for demos
+//		--format NAME     Image format: bmp, png, png_stored or qoi (default bmp)
+//	Returns the exit code for the program.
+int dist_coordinator_main(const char *program, int argc, char *argv[]);
+
+//	Runs a worker (`mandelbrot.exe --worker ...`) until the coordinator is done with it
+//	
+//	Returns the exit code for the program.
+int dist_worker_main(int argc, char *argv[]);
+
+#endif
@@ -0,0 +1,251 @@
+#include "expmap.h"
+#include "cpu.h"
+#include "image.h"
+
+#define EXPMAP_TAU 6.283185307179586
+
+typedef struct {
+	double centre_x;
+	double centre_y;
+	Uint32 iterations;
+	Uint32 columns;		// One per angle step
+	Uint32 rows;		// One per log-radius step, from the outside in
+	double step;		// Step in both angle and log-radius
+	double rho_max;		// Log-radius of row 0
+	Uint8 *pixels;		// RGBA8, `columns` wide
+	Uint32 inner_size;	// The disc inside the strip comes from an ordinary render of the last frame
+	double inner_zoom;
+	double inner_radius;	// Radius on the plane below which `inner` is sampled instead
+	Uint8 *inner;		// RGBA8, `inner_size` square
+	Uint64 iters[POOL_MAX_THREADS];
+} Expmap_Strip;
+
+typedef struct {
+	const Expmap_Strip *strip;
+	Uint32 size;
+	double zoom;
+	Uint8 *pixels;
+} Expmap_Frame;
+
+// Renders one band of strip rows
+static void __render_strip_band(void *ctx, Uint32 index, int thread) {
+	Expmap_Strip *strip = (Expmap_Strip *) ctx;
+	Uint32 y_start = index * EXPMAP_BAND_ROWS;
+	Uint32 y_end = SDL_min(y_start + EXPMAP_BAND_ROWS, strip->rows);
+	Uint64 performed = 0;
+
+	for (Uint32 y=y_start; y<y_end; y++) {
+		double radius = SDL_exp(strip->rho_max - y * strip->step);
+		Uint8 *row = strip->pixels + (size_t) y * strip->columns * 4;
+		for (Uint32 x=0; x<strip->columns; x++) {
+			double angle = x * strip->step;
+			double cx = strip->centre_x + radius * SDL_cos(angle);
+			double cy = strip->centre_y + radius * SDL_sin(angle);
+			Uint32 esc = cpu_iterate(cx, cy, strip->iterations);
+			performed += (esc == RENDER_INTERIOR) ? strip->iterations : esc;
+			cpu_colour(esc, strip->iterations, &row[x * 4]);
+		}
+	}
+
+	strip->iters[thread] += performed;
+}
+
+// Renders one row of the last frame, for the disc inside the strip
+static void __render_inner_row(void *ctx, Uint32 y, int thread) {
+	Expmap_Strip *strip = (Expmap_Strip *) ctx;
+	Uint8 *row = strip->inner + (size_t) y * strip->inner_size * 4;
+	Uint64 performed = 0;
+
+	double cy = strip->centre_y - (y - strip->inner_size / 2.0) / strip->inner_zoom;
+	for (Uint32 x=0; x<strip->inner_size; x++) {
+		double cx = strip->centre_x + (x - strip->inner_size / 2.0) / strip->inner_zoom;
+		Uint32 esc = cpu_iterate(cx, cy, strip->iterations);
+		performed += (esc == RENDER_INTERIOR) ? strip->iterations : esc;
+		cpu_colour(esc, strip->iterations, &row[x * 4]);
+	}
+
+	strip->iters[thread] += performed;
+}
+
+// Bilinearly samples an RGBA8 image, wrapping around in x if `wrap` is set and clamping otherwise
+static void __sample(const Uint8 *pixels, Uint32 w, Uint32 h, double fx, double fy, bool wrap, Uint8 *out) {
+	if (fy < 0.0) fy = 0.0;
+	if (!wrap && fx < 0.0) fx = 0.0;
+	Uint32 x0 = (Uint32) fx;
+	Uint32 x1 = x0 + 1;
+	if (wrap) {
+		x0 %= w;
+		x1 %= w;
+	} else {
+		x0 = SDL_min(x0, w - 1);
+		x1 = SDL_min(x1, w - 1);
+	}
+	Uint32 y0 = SDL_min((Uint32) fy, h - 1);
+	Uint32 y1 = SDL_min(y0 + 1, h - 1);
+	double tx = fx - SDL_floor(fx);
+	double ty = SDL_min(fy - y0, 1.0);
+	const Uint8 *p00 = pixels + ((size_t) y0 * w + x0) * 4;
+	const Uint8 *p01 = pixels + ((size_t) y0 * w + x1) * 4;
+	const Uint8 *p10 = pixels + ((size_t) y1 * w + x0) * 4;
+	const Uint8 *p11 = pixels + ((size_t) y1 * w + x1) * 4;
+	for (int c=0; c<4; c++) {
+		double top = p00[c] + (p01[c] - p00[c]) * tx;
+		double bottom = p10[c] + (p11[c] - p10[c]) * tx;
+		out[c] = (Uint8)(top + (bottom - top) * ty + 0.5);
+	}
+}
+
+// Resamples one row of a frame from the strip
+static void __resample_row(void *ctx, Uint32 y, int thread) {
+	Expmap_Frame *frame = (Expmap_Frame *) ctx;
+	const Expmap_Strip *strip = frame->strip;
+	Uint8 *row = frame->pixels + (size_t) y * frame->size * 4;
+
+	// Same mapping as the kernels' complex_from_coords(), relative to the centre
+	double dy = -(y - frame->size / 2.0) / frame->zoom;
+	for (Uint32 x=0; x<frame->size; x++) {
+		double dx = (x - frame->size / 2.0) / frame->zoom;
+
+		// Close to the centre, take the last frame, which is at least as fine as this one there
+		double r2 = dx * dx + dy * dy;
+		if (r2 < strip->inner_radius * strip->inner_radius) {
+			double fx = dx * strip->inner_zoom + strip->inner_size / 2.0;
+			double fy = -dy * strip->inner_zoom + strip->inner_size / 2.0;
+			__sample(strip->inner, strip->inner_size, strip->inner_size, fx, fy, false, &row[x * 4]);
+			continue;
+		}
+
+		// Otherwise the position in the strip, wrapping around in angle
+		double angle = SDL_atan2(dy, dx);
+		if (angle < 0.0) angle += EXPMAP_TAU;
+		double fx = angle / strip->step;
+		double fy = (strip->rho_max - 0.5 * SDL_log(r2)) / strip->step;
+		__sample(strip->pixels, strip->columns, strip->rows, fx, fy, true, &row[x * 4]);
+	}
+}
+
+
+int expmap_main(int argc, char *argv[]) {
+	double centre_x = -0.743643887037151;
+	double centre_y = 0.131825904205330;
+	double span = 4.0;
+	double octaves = EXPMAP_DEFAULT_OCTAVES;
+	int frames = EXPMAP_DEFAULT_FRAMES;
+	int size = EXPMAP_DEFAULT_SIZE;
+	int iterations = 1000;
+	int threads = 0;
+	const char *out_prefix = "zoom";
+	Image_Format format = IMAGE_BMP;
+
+	// Parse options
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--x") == 0 && has_val) centre_x = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--y") == 0 && has_val) centre_y = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--span") == 0 && has_val) span = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--octaves") == 0 && has_val) octaves = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--frames") == 0 && has_val) frames = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--size") == 0 && has_val) size = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--iters") == 0 && has_val) iterations = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--threads") == 0 && has_val) threads = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--out") == 0 && has_val) out_prefix = argv[++i];
+		else if (SDL_strcmp(argv[i], "--format") == 0 && has_val) format = image_format_from_name(argv[++i]);
+		else {
+			printf("[ERROR] Unknown expmap option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (span <= 0.0 || octaves < 0.0 || frames <= 0 || size <= 0 || iterations <= 0 || format == IMAGE_FORMAT_COUNT) {
+		puts("[ERROR] Invalid expmap options");
+		return 1;
+	}
+	if (SDL_Init(0) < 0) return 1;
+
+	// Size the strip so that its samples are about a pixel apart at the frame corners
+	// It only reaches in to the largest disc the last frame covers; inside that the last frame is rendered as it is
+	double zoom_start = size / span;
+	double zoom_end = zoom_start * SDL_pow(2.0, octaves);
+	double corner_px = size / SDL_sqrt(2.0);
+	Expmap_Strip *strip = SDL_calloc(1, sizeof(Expmap_Strip));
+	if (strip == NULL) {
+		puts("[ERROR] Not enough memory for the strip");
+		SDL_Quit();
+		return 1;
+	}
+	strip->centre_x = centre_x;
+	strip->centre_y = centre_y;
+	strip->iterations = iterations;
+	strip->columns = (Uint32) SDL_ceil(EXPMAP_TAU * corner_px);
+	strip->step = EXPMAP_TAU / strip->columns;
+	strip->rho_max = SDL_log(corner_px / zoom_start);
+	strip->inner_size = size;
+	strip->inner_zoom = zoom_end;
+	strip->inner_radius = SDL_max(size / 2.0 - 1.0, 0.5) / zoom_end;	// A pixel in, so sampling stays inside the frame
+	double rho_min = SDL_log(strip->inner_radius) - strip->step;	// A row past it, for the same reason
+	strip->rows = (Uint32) SDL_ceil((strip->rho_max - rho_min) / strip->step) + 1;
+	strip->pixels = SDL_malloc((size_t) strip->columns * strip->rows * 4);
+	strip->inner = SDL_malloc((size_t) size * size * 4);
+	if (strip->pixels == NULL || strip->inner == NULL) {
+		printf("[ERROR] Not enough memory for a %ux%u strip\n", strip->columns, strip->rows);
+		SDL_free(strip->pixels);
+		SDL_free(strip->inner);
+		SDL_free(strip);
+		SDL_Quit();
+		return 1;
+	}
+
+	Pool *pool = pool_create(threads);
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+
+	// Render the strip once
+	printf("---> Rendering a %ux%u log-polar strip and the last frame (%.1lf octaves, %i iterations)\n", strip->columns, strip->rows, octaves, iterations);
+	fflush(stdout);
+	Uint64 start = SDL_GetPerformanceCounter();
+	pool_run(pool, (strip->rows + EXPMAP_BAND_ROWS - 1) / EXPMAP_BAND_ROWS, __render_strip_band, strip);
+	pool_run(pool, size, __render_inner_row, strip);
+	double strip_ms = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+
+	// Resample every frame out of it, zooming in at a steady rate
+	Uint8 *pixels = SDL_malloc((size_t) size * size * 4);
+	if (pixels == NULL) {
+		printf("[ERROR] Not enough memory for a %ix%i frame\n", size, size);
+		pool_destroy(pool);
+		SDL_free(strip->pixels);
+		SDL_free(strip->inner);
+		SDL_free(strip);
+		SDL_Quit();
+		return 1;
+	}
+	Expmap_Frame frame = { strip, size, zoom_start, pixels };
+	double resample_ms = 0.0;
+	int result = 0;
+	for (int f=0; f<frames && result==0; f++) {
+		double t = (frames > 1) ? (double) f / (frames - 1) : 0.0;
+		frame.zoom = zoom_start * SDL_pow(2.0, octaves * t);
+
+		start = SDL_GetPerformanceCounter();
+		pool_run(pool, size, __resample_row, &frame);
+		resample_ms += (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+
+		char filename[512];
+		SDL_snprintf(filename, sizeof(filename), "%s_%05i.%s", out_prefix, f, image_format_extension(format));
+		result = image_save(filename, format, pixels, size, size, size * 4, pool);
+	}
+
+	// Compare with rendering each frame on its own
+	double strip_samples = (double) strip->columns * strip->rows + (double) size * size;
+	double frame_samples = (double) size * size * frames;
+	Uint64 strip_iters = 0;
+	for (int i=0; i<pool_threads(pool); i++) strip_iters += strip->iters[i];
+	printf("---> Strip took %.1lf ms (%.3lf Giter), resampling %i frames took %.1lf ms\n", strip_ms, strip_iters / 1.0e9, frames, resample_ms);
+	printf("      %.0lf strip and last frame samples instead of %.0lf frame pixels (%.1lfx fewer)\n", strip_samples, frame_samples, frame_samples / strip_samples);
+	fflush(stdout);
+
+	SDL_free(pixels);
+	pool_destroy(pool);
+	SDL_free(strip->pixels);
+	SDL_free(strip->inner);
+	SDL_free(strip);
+	SDL_Quit();
+	return result;
+}
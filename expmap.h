@@ -0,0 +1,50 @@
+//	
+//	Exponential-map (log-polar) zoom videos
+//	
+//	Instead of rendering every frame of a zoom on its own, the
+//	whole zoom is rendered once as a log-polar strip around the
+//	zoom centre: each column is an angle, and each row is one step
+//	further in, with rows and columns spaced equally in log space
+//	so every sample of the strip covers a roughly square patch of
+//	the plane. Every frame of the zoom is then just a resampling of
+//	part of the strip, and neighbouring frames share almost all of
+//	their samples instead of iterating them again.
+//	The strip only reaches in as far as the edge of the last frame,
+//	since the rows beyond would get ever more samples per pixel;
+//	the disc inside it is taken from an ordinary render of the last
+//	frame instead.
+//	
+
+#ifndef EXPMAP_H
+#define EXPMAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "pool.h"
+
+#define EXPMAP_DEFAULT_SIZE 1024
+#define EXPMAP_DEFAULT_FRAMES 600
+#define EXPMAP_DEFAULT_OCTAVES 20.0	// Halvings of the view width over the whole zoom
+#define EXPMAP_BAND_ROWS 16			// Strip rows per job handed to the thread pool
+
+
+//	Renders a zoom video through a log-polar strip (`mandelbrot.exe --expmap ...`)
+//	
+//	`argv[0]` is expected to be the "--expmap" switch itself.
+//	Options:
+//		--x X / --y Y     Centre of the zoom
+//		--span W          Width of the view on the complex plane at the first frame
+//		--octaves N       How many times the view width halves by the last frame
+//		--frames N        Number of frames to output
+//		--size N          Renders N x N frames
+//		--iters N         Iterations per sample
+//		--threads N       Threads to render with (default one per core)
+//		--out PREFIX      Saves frames as PREFIX_00000.bmp onwards
+//		--format NAME     Image format of the frames: bmp, png, png_stored or qoi (default bmp)
+//	Returns the exit code for the program.
+int expmap_main(int argc, char *argv[]);
+
+#endif
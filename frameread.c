@@ -0,0 +1,145 @@
+//	
+//	Example consumer of the shared memory frame ring
+//	
+//	Maps the ring published by `mandelbrot.exe --publish` and reads
+//	every frame in place as it arrives, reporting once a second how
+//	many frames were read and dropped, and the latency from when each
+//	frame was started (and finished) to when it was read.
+//	
+//	Usage: framereader.exe [NAME] [--frames N] [--hold MS]
+//		NAME        Name of the ring (default mandelbrot_frames)
+//		--frames N  Stops after N frames have been read
+//		--hold MS   Spends MS on every frame, to act like a slow consumer
+//	
+
+#include "publish.h"
+
+#define READER_MAX_SAMPLES 4096		// Latencies kept per report
+#define READER_REPORT_MS 1000
+#define READER_POLL_MS 1
+
+
+typedef struct {
+	Uint32 read;
+	Uint32 dropped;
+	Uint32 samples;
+	double begin_ms[READER_MAX_SAMPLES];	// From the frame being started
+	double publish_ms[READER_MAX_SAMPLES];	// From the frame being published
+} Reader_Stats;
+
+
+static int __cmp_double(const void *a, const void *b) {
+	double da = *(const double *)a;
+	double db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+static double __percentile(double *values, Uint32 count, double p) {
+	if (count == 0) return 0.0;
+	SDL_qsort(values, count, sizeof(double), __cmp_double);
+	Uint32 index = (Uint32)(p * (count - 1) + 0.5);
+	return values[index];
+}
+
+static void __report(Reader_Stats *s, const char *what) {
+	printf("---> %s: %u frames read, %u dropped | latency from start p50 %.2lf ms, p99 %.2lf ms | from publish p50 %.2lf ms, p99 %.2lf ms\n",
+		what, s->read, s->dropped,
+		__percentile(s->begin_ms, s->samples, 0.5), __percentile(s->begin_ms, s->samples, 0.99),
+		__percentile(s->publish_ms, s->samples, 0.5), __percentile(s->publish_ms, s->samples, 0.99));
+	fflush(stdout);
+}
+
+// Stands in for whatever a real consumer does with the frame, reading it where it is
+static Uint32 __count_interior(const Uint32 *escapes, Uint32 pixels) {
+	Uint32 interior = 0;
+	for (Uint32 i=0; i<pixels; i++) interior += (escapes[i] == 0);
+	return interior;
+}
+
+int main(int argc, char *argv[]) {
+	const char *name = PUBLISH_DEFAULT_NAME;
+	Uint32 max_frames = 0;
+	Uint32 hold_ms = 0;
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--frames") == 0 && has_val) max_frames = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--hold") == 0 && has_val) hold_ms = SDL_atoi(argv[++i]);
+		else if (argv[i][0] != '-') name = argv[i];
+		else {
+			printf("[ERROR] Unknown option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+
+	Publish_Ring *ring = publish_open(name);
+	if (ring == NULL) {
+		printf("[ERROR] No frame ring named '%s' (is `mandelbrot.exe --publish` running?)\n", name);
+		return 1;
+	}
+	Publish_Header *header = publish_header(ring);
+	printf("---> Reading %ux%u frames from '%s' (%u slots)\n", header->width, header->height, name, header->slots);
+	fflush(stdout);
+
+	double ms_per_tick = 1000.0 / header->frequency;
+	Uint64 next = (Uint32) SDL_AtomicGet(&header->published);	// Frames from before we started don't count
+	Reader_Stats interval = { 0 };
+	Reader_Stats total = { 0 };
+	Uint64 last_report = SDL_GetPerformanceCounter();
+	Uint64 interior = 0;
+
+	while (!SDL_AtomicGet(&header->closed) && (max_frames == 0 || total.read < max_frames)) {
+		Uint64 published = (Uint32) SDL_AtomicGet(&header->published);
+		if (next == published) {
+			SDL_Delay(READER_POLL_MS);
+		}
+
+		for (; next < published; next++) {
+			Publish_Slot *slot = publish_slot(ring, next);
+			int sequence = SDL_AtomicGet(&slot->sequence);
+			SDL_MemoryBarrierAcquire();
+			if (sequence != PUBLISH_SEQUENCE(next)) {
+				// Already overwritten by a later frame
+				interval.dropped++;
+				total.dropped++;
+				continue;
+			}
+
+			Uint64 now = SDL_GetPerformanceCounter();
+			double begin_ms = (now - slot->ts_begin) * ms_per_tick;
+			double publish_ms = (now - slot->ts_published) * ms_per_tick;
+			Uint32 frame_interior = __count_interior(publish_escape(ring, slot), header->width * header->height);
+			if (hold_ms > 0) SDL_Delay(hold_ms);
+
+			// If the slot changed while we were using it, what we read may be torn
+			SDL_MemoryBarrierAcquire();
+			if (SDL_AtomicGet(&slot->sequence) != sequence) {
+				interval.dropped++;
+				total.dropped++;
+				continue;
+			}
+
+			interval.read++;
+			total.read++;
+			interior += frame_interior;
+			if (interval.samples < READER_MAX_SAMPLES) {
+				interval.begin_ms[interval.samples] = begin_ms;
+				interval.publish_ms[interval.samples++] = publish_ms;
+			}
+			if (total.samples < READER_MAX_SAMPLES) {
+				total.begin_ms[total.samples] = begin_ms;
+				total.publish_ms[total.samples++] = publish_ms;
+			}
+		}
+
+		if ((SDL_GetPerformanceCounter() - last_report) * ms_per_tick >= READER_REPORT_MS) {
+			if (interval.read + interval.dropped > 0) __report(&interval, "Last second");
+			interval = (Reader_Stats){ 0 };
+			last_report = SDL_GetPerformanceCounter();
+		}
+	}
+
+	__report(&total, "Total");
+	if (total.read > 0) printf("---> Frames were %.1lf%% interior on average\n", 100.0 * interior / ((double) total.read * header->width * header->height));
+	publish_close(ring);
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include "gl.h"
+#include "trace.h"
 
 
 static SDL_GLContext __glcontext = NULL;
@@ -68,10 +69,23 @@ void gl_term() {
 
 	// Destroy the context
 	SDL_GL_DeleteContext(__glcontext);
+	__glcontext = NULL;
+}
+
+void gl_make_current(SDL_Window *window) {
+	__ensure_init();
+	if (SDL_GL_MakeCurrent(window, (window != NULL) ? __glcontext : NULL) < 0) {
+		__log_err("Failed to make GL Context current", SDL_GetError());
+	}
 }
 
 GLuint gl_load_shader(GLenum type, const char *source_filename) {
+	return gl_load_shader_defines(type, source_filename, NULL);
+}
+
+GLuint gl_load_shader_defines(GLenum type, const char *source_filename, const char *defines) {
 	__ensure_init();
+	TRACE_BEGIN("load_shader");
 
 	// Open source file
 	FILE *f = fopen(source_filename, "r");
@@ -91,7 +105,7 @@ GLuint gl_load_shader(GLenum type, const char *source_filename) {
 	char curr_line[MAX_SHADER_COLS];
 	size_t curr_len = 0;
 
-	while (!feof(f) && line_count <= MAX_SHADER_LINES) {
+	while (!feof(f) && line_count < MAX_SHADER_LINES) {
 		int ch = fgetc(f);
 		if (feof(f)) break;
 
@@ -107,7 +121,8 @@ GLuint gl_load_shader(GLenum type, const char *source_filename) {
 	}
 
 	// Finish parsing last line
-	if (curr_len > 0) {
+	bool fits = (line_count < MAX_SHADER_LINES || fgetc(f) == EOF);
+	if (curr_len > 0 && line_count < MAX_SHADER_LINES) {
 		line_lens[line_count] = curr_len;
 		lines[line_count] = SDL_malloc(sizeof(char) * curr_len);
 		SDL_memcpy(lines[line_count], curr_line, curr_len);
@@ -115,6 +130,28 @@ GLuint gl_load_shader(GLenum type, const char *source_filename) {
 	}
 	fclose(f);
 
+	// Building the shader cut short, or without its defines, would silently give the wrong one
+	if (defines != NULL && line_count + 2 > MAX_SHADER_LINES) fits = false;
+	if (!fits) {
+		printf("[ERROR] Shader source has too many lines (over %i):\n       %s\n", MAX_SHADER_LINES, source_filename);
+		fflush(stdout);
+		for (int i=0; i<line_count; i++) SDL_free(lines[i]);
+		glDeleteShader(shader);
+		TRACE_END();
+		return 0;
+	}
+
+	// Defines go straight after the #version line, then line numbers carry on as in the file
+	if (defines != NULL && line_count > 0) {
+		SDL_memmove(&lines[3], &lines[1], sizeof(lines[0]) * (line_count - 1));
+		SDL_memmove(&line_lens[3], &line_lens[1], sizeof(line_lens[0]) * (line_count - 1));
+		lines[1] = SDL_strdup(defines);
+		line_lens[1] = SDL_strlen(defines);
+		lines[2] = SDL_strdup("#line 2\n");
+		line_lens[2] = SDL_strlen(lines[2]);
+		line_count += 2;
+	}
+
 	// DEBUG: Print lines
 	//printf("Successfully parsed %i lines from '%s':\n", line_count, source_filename);
 	//for (int i=0; i<line_count; i++) {
@@ -138,12 +175,14 @@ GLuint gl_load_shader(GLenum type, const char *source_filename) {
 	}
 	__log_info("Successfully compiled shader", source_filename);
 
+	TRACE_END();
 	return shader;
 }
 
 void gl_link_program(GLuint program) {
 	__ensure_init();
 
+	TRACE_BEGIN("link_program");
 	glLinkProgram(program);
 	gl_check_err("Failed to link program");
 
@@ -153,6 +192,7 @@ void gl_link_program(GLuint program) {
 		__log_warn("Program linking was unsuccessful:", NULL);
 		gl_print_prog_log(program);
 	}
+	TRACE_END();
 }
 
 gl_frametex gl_create_frametex(GLuint width, GLuint height) {
@@ -174,6 +214,13 @@ gl_frametex gl_create_frametex(GLuint width, GLuint height) {
 	glTextureParameteri(ftex.tex, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	gl_check_err("Failed to set frame-texture parameters");
 
+	// Create the matching escape data texture
+	glCreateTextures(GL_TEXTURE_2D, 1, &ftex.escape);
+	glTextureStorage2D(ftex.escape, 1, GL_R32UI, width, height);
+	glTextureParameteri(ftex.escape, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTextureParameteri(ftex.escape, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	gl_check_err("Failed to create escape texture");
+
 	// Create a new framebuffer and attach the texture to it
 	glCreateFramebuffers(1, &ftex.fb);
 	glNamedFramebufferTexture(ftex.fb, GL_COLOR_ATTACHMENT0, ftex.tex, 0);
@@ -182,11 +229,17 @@ gl_frametex gl_create_frametex(GLuint width, GLuint height) {
 	return ftex;
 }
 
+void gl_destroy_frametex(gl_frametex ftex) {
+	glDeleteFramebuffers(1, &ftex.fb);
+	glDeleteTextures(1, &ftex.tex);
+	glDeleteTextures(1, &ftex.escape);
+}
+
 void gl_draw_frametex(gl_frametex ftex) {
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, ftex.fb);
 	glBlitFramebuffer(
 		0, 0, ftex.w, ftex.h,
-		0, 0, ftex.w, ftex.h,
+		0, ftex.h, ftex.w, 0,
 		GL_COLOR_BUFFER_BIT,
 		GL_NEAREST
 	);
@@ -29,7 +29,8 @@ typedef struct {
 typedef struct {
 	GLuint w;
 	GLuint h;
-	GLuint tex;
+	GLuint tex;		// RGBA8 colours, rows from the top down
+	GLuint escape;	// R32UI escape iterations, same layout as `tex`
 	GLuint fb;
 } gl_frametex;
 
@@ -46,6 +47,12 @@ void gl_init(int major, int minor, SDL_Window *window);
 //	
 void gl_term();
 
+//	Makes the context current on the calling thread, or releases it if `window` is NULL
+//	
+//	A context can only be current on one thread at a time, so the
+//	thread that has it must release it before another can take it.
+void gl_make_current(SDL_Window *window);
+
 //	Loads and compiles a shader from a source file
 //	
 //	Returns ID of the newly loaded and compiled shader,
@@ -53,16 +60,31 @@ void gl_term();
 //	Messages are logged.
 GLuint gl_load_shader(GLenum type, const char *source_filename);
 
+//	Loads and compiles a shader from a source file, with some #defines
+//	
+//	`defines` is inserted after the #version line, one or more whole
+//	lines (e.g. "#define POWER 3\n"), so one source can be built into
+//	several specialised shaders. NULL adds nothing.
+//	Returns 0 if the source and defines don't fit in MAX_SHADER_LINES.
+GLuint gl_load_shader_defines(GLenum type, const char *source_filename, const char *defines);
+
 //	Links a program and handles errors
 //	
 void gl_link_program(GLuint program);
 
 //	Creates a frametex which encapsulates a texture for drawing
 //	
+//	Also holds a second texture for the per-pixel escape data.
 gl_frametex gl_create_frametex(GLuint width, GLuint height);
 
+//	Frees the texture and framebuffer of a frametex
+//	
+void gl_destroy_frametex(gl_frametex ftex);
+
 //	Draws a previously created frametex to the screen
 //	
+//	The frametex's rows are stored from the top down, so it is flipped
+//	to match the bottom-up default framebuffer.
 void gl_draw_frametex(gl_frametex ftex);
 
 //	Load a texture from a .bmp file
@@ -0,0 +1,345 @@
+#include "heatmap.h"
+#include "trace.h"
+
+#define HEATMAP_LANES (KERNEL_PERSISTENT_GROUP_SIZE * KERNEL_PERSISTENT_GROUP_SIZE)
+
+static const char *__block_names[HEATMAP_BLOCK_COUNT] = {
+	[HEATMAP_BLOCK_8X8] = "8x8",
+	[HEATMAP_BLOCK_32X1] = "32x1",
+};
+static const Uint32 __block_sizes[HEATMAP_BLOCK_COUNT][2] = {
+	[HEATMAP_BLOCK_8X8] = { 8, 8 },
+	[HEATMAP_BLOCK_32X1] = { 32, 1 },
+};
+static const Uint32 __tile_sizes[] = { 8, 16, 32, 64 };	// Compared by `--heatmap`
+#define NUM_TILE_SIZES (int)(sizeof(__tile_sizes) / sizeof(__tile_sizes[0]))
+
+static GLuint __program = NULL_PROGRAM;
+
+typedef struct {
+	Uint64 sum;
+	Uint32 min;
+	Uint32 max;
+	Uint32 pixels;
+} Heatmap_Block_Cost;
+
+
+// Gets the cost of a block of pixels, clipped to the frame
+static Heatmap_Block_Cost __block_cost(const Uint32 *escapes, Uint32 width, Uint32 height, Uint32 iterations, Uint32 x0, Uint32 y0, Uint32 w, Uint32 h) {
+	Heatmap_Block_Cost b = { .min = 0xFFFFFFFF };
+	Uint32 x1 = SDL_min(x0 + w, width);
+	Uint32 y1 = SDL_min(y0 + h, height);
+	for (Uint32 y=y0; y<y1; y++) {
+		const Uint32 *row = escapes + (size_t) y * width;
+		for (Uint32 x=x0; x<x1; x++) {
+			Uint32 cost = (row[x] != 0) ? row[x] : iterations;
+			b.sum += cost;
+			b.min = SDL_min(b.min, cost);
+			b.max = SDL_max(b.max, cost);
+		}
+	}
+	b.pixels = (x1 - x0) * (y1 - y0);
+	return b;
+}
+
+// Adds up a tile's cost, and how long a persistent workgroup spends on it one chunk of pixels at a time
+static void __tile_cost(const Uint32 *escapes, Heatmap_Stats *s, Uint32 tx, Uint32 ty, Uint64 *cost, Uint64 *span) {
+	Uint32 x0 = tx * s->tile_size;
+	Uint32 y0 = ty * s->tile_size;
+	Uint32 x1 = SDL_min(x0 + s->tile_size, s->width);
+	Uint32 y1 = SDL_min(y0 + s->tile_size, s->height);
+	Uint32 chunk = KERNEL_PERSISTENT_GROUP_SIZE;
+	*cost = *span = 0;
+	for (Uint32 y=y0; y<y1; y+=chunk) {
+		for (Uint32 x=x0; x<x1; x+=chunk) {
+			Heatmap_Block_Cost b = __block_cost(escapes, s->width, s->height, s->iterations, x, y, SDL_min(chunk, x1 - x), SDL_min(chunk, y1 - y));
+			*cost += b.sum;
+			*span += b.max;
+			s->min_pixel_cost = SDL_min(s->min_pixel_cost, b.min);
+			s->max_pixel_cost = SDL_max(s->max_pixel_cost, b.max);
+		}
+	}
+}
+
+// Gets the overlay's program, compiling it on first use
+static GLuint __overlay_program() {
+	if (__program != NULL_PROGRAM) return __program;
+
+	__program = glCreateProgram();
+	GLuint comp_shader = gl_load_shader(GL_COMPUTE_SHADER, "shaders/heatmap.comp");
+	glAttachShader(__program, comp_shader);
+	gl_link_program(__program);
+	glDeleteShader(comp_shader);
+	return __program;
+}
+
+
+int heatmap_analyse(const Uint32 *escapes, Uint32 width, Uint32 height, Uint32 iterations, Uint32 tile_size, Heatmap_Stats *s) {
+	*s = (Heatmap_Stats){
+		.width = width,
+		.height = height,
+		.iterations = iterations,
+		.tile_size = tile_size,
+		.tiles_x = (width + tile_size - 1) / tile_size,
+		.tiles_y = (height + tile_size - 1) / tile_size,
+		.min_pixel_cost = 0xFFFFFFFF,
+	};
+	Uint32 tiles = s->tiles_x * s->tiles_y;
+	s->tile_costs = SDL_malloc(sizeof(Uint64) * tiles);
+	s->tile_spans = SDL_malloc(sizeof(Uint64) * tiles);
+	if (s->tile_costs == NULL || s->tile_spans == NULL) {
+		heatmap_free(s);
+		return 1;
+	}
+
+	for (Uint32 ty=0; ty<s->tiles_y; ty++) {
+		for (Uint32 tx=0; tx<s->tiles_x; tx++) {
+			Uint32 t = ty * s->tiles_x + tx;
+			__tile_cost(escapes, s, tx, ty, &s->tile_costs[t], &s->tile_spans[t]);
+			s->total_cost += s->tile_costs[t];
+			s->max_tile_cost = SDL_max(s->max_tile_cost, s->tile_costs[t]);
+		}
+	}
+	s->mean_tile_cost = s->total_cost / (double) tiles;
+	s->imbalance = (s->total_cost > 0) ? s->max_tile_cost / s->mean_tile_cost : 1.0;
+
+	// Every lane of a block is busy for as long as its slowest one
+	for (int k=0; k<HEATMAP_BLOCK_COUNT; k++) {
+		Uint32 bw = __block_sizes[k][0];
+		Uint32 bh = __block_sizes[k][1];
+		Uint64 busy = 0;
+		Uint64 lanes = 0;
+		for (Uint32 y=0; y<height; y+=bh) {
+			for (Uint32 x=0; x<width; x+=bw) {
+				Heatmap_Block_Cost b = __block_cost(escapes, width, height, iterations, x, y, bw, bh);
+				busy += b.sum;
+				lanes += (Uint64) b.max * b.pixels;
+			}
+		}
+		s->divergence[k] = (lanes > 0) ? 1.0 - busy / (double) lanes : 0.0;
+	}
+	return 0;
+}
+
+int heatmap_read(gl_frametex ftex, Uint32 iterations, Uint32 tile_size, Heatmap_Stats *s) {
+	size_t bytes = (size_t) ftex.w * ftex.h * sizeof(Uint32);
+	Uint32 *escapes = SDL_malloc(bytes);
+	if (escapes == NULL) return 1;
+
+	TRACE_BEGIN("heatmap_read");
+	glGetTextureImage(ftex.escape, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, (GLsizei) bytes, escapes);
+	gl_check_err("Failed to read back escape image");
+	int err = heatmap_analyse(escapes, ftex.w, ftex.h, iterations, tile_size, s);
+	TRACE_END();
+
+	SDL_free(escapes);
+	return err;
+}
+
+void heatmap_free(Heatmap_Stats *s) {
+	SDL_free(s->tile_costs);
+	SDL_free(s->tile_spans);
+	s->tile_costs = NULL;
+	s->tile_spans = NULL;
+}
+
+Heatmap_Schedule heatmap_schedule(const Heatmap_Stats *s, Kernel_Tile_Order order, Uint32 groups) {
+	Heatmap_Schedule r = { 0 };
+	Uint32 tiles = s->tiles_x * s->tiles_y;
+	GLuint *queue = SDL_malloc(sizeof(GLuint) * tiles);
+	Uint64 *busy = SDL_calloc(groups, sizeof(Uint64));
+	if (queue == NULL || busy == NULL || kernel_tile_order(s->width, s->height, s->tile_size, order, queue) != 0) {
+		SDL_free(queue);
+		SDL_free(busy);
+		return r;
+	}
+
+	// Whichever workgroup finishes first takes the next tile
+	Uint64 total = 0;
+	for (Uint32 i=0; i<tiles; i++) {
+		Uint32 next = 0;
+		for (Uint32 g=1; g<groups; g++) {
+			if (busy[g] < busy[next]) next = g;
+		}
+		busy[next] += s->tile_spans[queue[i]];
+		total += s->tile_spans[queue[i]];
+	}
+	for (Uint32 g=0; g<groups; g++) r.makespan = SDL_max(r.makespan, busy[g]);
+
+	if (r.makespan > 0) {
+		r.balance = total / ((double) groups * r.makespan);
+		r.efficiency = s->total_cost / ((double) groups * HEATMAP_LANES * r.makespan);
+	}
+	SDL_free(queue);
+	SDL_free(busy);
+	return r;
+}
+
+void heatmap_print(const Heatmap_Stats *s, FILE *f) {
+	fprintf(f, "---> Cost %.1lf Miters | %ux%u tiles: mean %.1lf k, max %.1lf k (imbalance %.2lfx) | divergence",
+		s->total_cost / 1.0e6, s->tile_size, s->tile_size, s->mean_tile_cost / 1.0e3, s->max_tile_cost / 1.0e3, s->imbalance);
+	for (int k=0; k<HEATMAP_BLOCK_COUNT; k++) fprintf(f, " %s %.1lf%%", __block_names[k], 100.0 * s->divergence[k]);
+	fprintf(f, "\n");
+}
+
+void heatmap_apply(gl_frametex ftex, const Heatmap_Stats *s) {
+	TRACE_BEGIN("heatmap");
+	glUseProgram(__overlay_program());
+	glBindImageTexture(0, ftex.tex, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
+	glBindImageTexture(1, ftex.escape, 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+	glUniform1ui(0, s->iterations);
+	glUniform1f(1, (float) log(SDL_max(s->min_pixel_cost, 1)));
+	glUniform1f(2, (float) log(SDL_max(s->max_pixel_cost, s->min_pixel_cost + 1)));
+	glUniform1f(3, HEATMAP_OPACITY);
+	glDispatchCompute((ftex.w + HEATMAP_GROUP_SIZE - 1) / HEATMAP_GROUP_SIZE, (ftex.h + HEATMAP_GROUP_SIZE - 1) / HEATMAP_GROUP_SIZE, 1);
+	glMemoryBarrier(GL_ALL_BARRIER_BITS);
+	gl_check_err("Failed to draw heatmap");
+	TRACE_END();
+}
+
+int heatmap_save_image(gl_frametex ftex, const char *filename) {
+	size_t bytes = (size_t) ftex.w * ftex.h * 4;
+	Uint8 *pixels = SDL_malloc(bytes);
+	if (pixels == NULL) return 1;
+
+	glGetTextureImage(ftex.tex, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei) bytes, pixels);
+	gl_check_err("Failed to read back heatmap");
+	int err = image_save(filename, image_format_from_filename(filename), pixels, ftex.w, ftex.h, ftex.w * 4, NULL);
+	SDL_free(pixels);
+	return err;
+}
+
+int heatmap_save_tiles(const Heatmap_Stats *s, const char *filename) {
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) return 1;
+
+	fprintf(f, "tile_x,tile_y,x,y,cost,span,relative\n");
+	for (Uint32 ty=0; ty<s->tiles_y; ty++) {
+		for (Uint32 tx=0; tx<s->tiles_x; tx++) {
+			Uint32 t = ty * s->tiles_x + tx;
+			double relative = (s->mean_tile_cost > 0.0) ? s->tile_costs[t] / s->mean_tile_cost : 0.0;
+			fprintf(f, "%u,%u,%u,%u,%llu,%llu,%.4lf\n", tx, ty, tx * s->tile_size, ty * s->tile_size,
+				(unsigned long long) s->tile_costs[t], (unsigned long long) s->tile_spans[t], relative);
+		}
+	}
+
+	fclose(f);
+	return 0;
+}
+
+void heatmap_term() {
+	if (__program != NULL_PROGRAM) glDeleteProgram(__program);
+	__program = NULL_PROGRAM;
+}
+
+int heatmap_main(int argc, char *argv[]) {
+	double centre_x = -0.75;
+	double centre_y = 0.0;
+	double span = 3.0;
+	int size = 1024;
+	int iterations = 1000;
+	int groups = KERNEL_PERSISTENT_GROUPS;
+	Kernel_Id kernel = KERNEL_FLOAT;
+	const char *out_filename = HEATMAP_IMAGE_FILENAME;
+	const char *tiles_filename = HEATMAP_TILES_FILENAME;
+
+	// Parse options
+	for (int i=1; i<argc; i++) {
+		bool has_val = i + 1 < argc;
+		if (SDL_strcmp(argv[i], "--x") == 0 && has_val) centre_x = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--y") == 0 && has_val) centre_y = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--span") == 0 && has_val) span = SDL_strtod(argv[++i], NULL);
+		else if (SDL_strcmp(argv[i], "--size") == 0 && has_val) size = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--iters") == 0 && has_val) iterations = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--groups") == 0 && has_val) groups = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--out") == 0 && has_val) out_filename = argv[++i];
+		else if (SDL_strcmp(argv[i], "--tiles") == 0 && has_val) tiles_filename = argv[++i];
+		else if (SDL_strcmp(argv[i], "--kernel") == 0 && has_val) {
+			kernel = kernel_from_name(argv[++i]);
+			if (kernel == KERNEL_COUNT) {
+				printf("[ERROR] Unknown kernel '%s'\n", argv[i]);
+				return 1;
+			}
+		}
+		else {
+			printf("[ERROR] Unknown heatmap option '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (span <= 0.0 || size <= 0 || iterations <= 0 || groups <= 0) {
+		puts("[ERROR] Invalid heatmap options");
+		return 1;
+	}
+
+	// Set up a hidden window just to get a GL context
+	if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+		printf("[ERROR] Failed to initialise SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_Window *window = SDL_CreateWindow(
+		"Mandelbrot Heatmap",
+		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+		size, size,
+		SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+	);
+	if (window == NULL) {
+		printf("[ERROR] Failed to create Window: %s\n", SDL_GetError());
+		return 1;
+	}
+	gl_init(4, 5, window);
+	gl_frametex ftex = gl_create_frametex(size, size);
+	Render_Handle *gl = render_create(RENDER_BACKEND_GL);
+
+	int err = 0;
+	if (kernel != KERNEL_AUTO && !kernel_available(kernel)) {
+		printf("[ERROR] The %s kernel isn't available\n", kernel_name(kernel));
+		err = 1;
+	} else {
+		Render_View view = { centre_x, centre_y, size / span, iterations, kernel, COLOUR_LINEAR };
+		render_to_frametex(gl, &view, ftex);
+		printf("---> Analysing %ix%i frame at %.17g, %.17g (span %g, %i iterations), %i workgroups\n", size, size, centre_x, centre_y, span, iterations, groups);
+		printf("      %-6s %-8s %10s %12s %10s %10s\n", "Tile", "Order", "Imbalance", "Makespan k", "Balance", "Efficiency");
+
+		// Every tile size with every order, keeping the default tiling for the heatmap itself
+		Heatmap_Stats shown = { 0 };
+		for (int i=0; i<NUM_TILE_SIZES && err == 0; i++) {
+			Heatmap_Stats s;
+			if (heatmap_read(ftex, iterations, __tile_sizes[i], &s) != 0) {
+				puts("[ERROR] Failed to analyse frame");
+				err = 1;
+				break;
+			}
+			for (int order=0; order<KERNEL_ORDER_COUNT; order++) {
+				Heatmap_Schedule sched = heatmap_schedule(&s, order, groups);
+				printf("      %-6u %-8s %9.2lfx %12.1lf %9.1lf%% %9.1lf%%\n", s.tile_size, kernel_order_name(order),
+					s.imbalance, sched.makespan / 1.0e3, 100.0 * sched.balance, 100.0 * sched.efficiency);
+			}
+			if (s.tile_size == KERNEL_TILE_SIZE) shown = s;
+			else heatmap_free(&s);
+		}
+
+		if (err == 0) {
+			heatmap_print(&shown, stdout);
+			heatmap_apply(ftex, &shown);
+			if (heatmap_save_image(ftex, out_filename) != 0) {
+				printf("[ERROR] Failed to write '%s'\n", out_filename);
+				err = 1;
+			} else if (heatmap_save_tiles(&shown, tiles_filename) != 0) {
+				printf("[ERROR] Failed to write '%s'\n", tiles_filename);
+				err = 1;
+			} else {
+				printf("---> Wrote heatmap to '%s' and tile costs to '%s'\n", out_filename, tiles_filename);
+			}
+		}
+		heatmap_free(&shown);
+	}
+
+	render_destroy(gl);
+	heatmap_term();
+	gl_destroy_frametex(ftex);
+	kernel_term();
+	gl_term();
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	return err;
+}
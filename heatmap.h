@@ -0,0 +1,138 @@
+//	
+//	Per-pixel cost heatmaps and load imbalance analysis
+//	
+//	A pixel costs as many iterations as it took: the iteration it
+//	escaped at, or the whole iteration count if it never did. Costs
+//	are read back from a frame's escape image and summed per tile, as
+//	the persistent kernel hands tiles out, to show how unevenly the
+//	work is spread over the frame.
+//	
+//	The lanes of a SIMD unit run in lockstep, so a block of pixels
+//	iterated together takes as long as its most expensive pixel. The
+//	rest of its lanes sit idle for the difference, and the fraction
+//	of lane time lost that way is the divergence of the block shape.
+//	It's estimated for 8x8 blocks (a persistent workgroup, or a
+//	64-wide wavefront) and 32x1 blocks (a 32-wide warp along a row).
+//	
+//	Given the tile costs, the persistent kernel's scheduling can be
+//	simulated: each workgroup takes the next tile from the queue when
+//	it finishes its last, and the frame is done when the busiest
+//	workgroup is. This compares tile sizes and orders on a real view
+//	without needing a GPU whose timings can be trusted.
+//	
+//	`mandelbrot.exe --heatmap` renders one view, prints the metrics
+//	for a range of tile sizes and orders, and saves the heatmap:
+//		--x X, --y Y      Centre of the view (default -0.75, 0)
+//		--span S          Width of the view on the complex plane (default 3)
+//		--size N          Width and height in pixels (default 1024)
+//		--iters N         Iteration count (default 1000)
+//		--kernel NAME     Kernel to render with (default float)
+//		--groups N        Persistent workgroups to simulate (default KERNEL_PERSISTENT_GROUPS)
+//		--out FILE        Heatmap image (default heatmap.bmp)
+//		--tiles FILE      Per-tile costs, as CSV (default heatmap_tiles.csv)
+//	
+
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <math.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "kernel.h"
+#include "render.h"
+#include "image.h"
+
+#define HEATMAP_GROUP_SIZE 16		// Workgroup width and height of the overlay shader, must match it
+#define HEATMAP_OPACITY 0.8f		// How much of the overlay is heat rather than the frame underneath
+#define HEATMAP_IMAGE_FILENAME "heatmap.bmp"
+#define HEATMAP_TILES_FILENAME "heatmap_tiles.csv"
+
+
+// Shapes of SIMD block divergence is estimated for
+typedef enum {
+	HEATMAP_BLOCK_8X8,
+	HEATMAP_BLOCK_32X1,
+	HEATMAP_BLOCK_COUNT,
+} Heatmap_Block;
+
+typedef struct {
+	Uint32 width;
+	Uint32 height;
+	Uint32 iterations;
+	Uint32 tile_size;
+	Uint32 tiles_x;
+	Uint32 tiles_y;
+	Uint64 *tile_costs;		// Iterations of each tile, along rows
+	Uint64 *tile_spans;		// Lockstep time of each tile for a persistent workgroup, in iterations
+	Uint64 total_cost;
+	Uint32 min_pixel_cost;
+	Uint32 max_pixel_cost;
+	Uint64 max_tile_cost;
+	double mean_tile_cost;
+	double imbalance;		// Max over mean tile cost
+	double divergence[HEATMAP_BLOCK_COUNT];	// Fraction of lane time spent waiting on the slowest pixel of a block
+} Heatmap_Stats;
+
+// Outcome of simulating the persistent kernel's tile queue
+typedef struct {
+	Uint64 makespan;	// Lockstep iterations until the last workgroup finishes
+	double balance;		// Mean over max workgroup busy time
+	double efficiency;	// Lane time spent iterating, counting both divergence and imbalance
+} Heatmap_Schedule;
+
+
+//	Entry point for `mandelbrot.exe --heatmap ...`
+//	
+int heatmap_main(int argc, char *argv[]);
+
+//	Works out the cost statistics of an escape image
+//	
+//	`escapes` has one Uint32 per pixel, rows packed. The stats own
+//	their tile arrays until `heatmap_free()`.
+//	Returns 0 on success, 1 if the tile arrays couldn't be allocated.
+int heatmap_analyse(const Uint32 *escapes, Uint32 width, Uint32 height, Uint32 iterations, Uint32 tile_size, Heatmap_Stats *s);
+
+//	Reads back a frametex's escape image and analyses it
+//	
+//	Returns 0 on success, 1 otherwise.
+int heatmap_read(gl_frametex ftex, Uint32 iterations, Uint32 tile_size, Heatmap_Stats *s);
+
+//	Frees the tile arrays of some stats
+//	
+void heatmap_free(Heatmap_Stats *s);
+
+//	Simulates workgroups taking tiles from a queue in some order
+//	
+Heatmap_Schedule heatmap_schedule(const Heatmap_Stats *s, Kernel_Tile_Order order, Uint32 groups);
+
+//	Prints the imbalance and divergence metrics to a file (e.g. stdout)
+//	
+void heatmap_print(const Heatmap_Stats *s, FILE *f);
+
+//	Draws the cost of each pixel over a frametex's colours on the GPU
+//	
+//	Costs are shaded on a log scale from the cheapest pixel to the
+//	most expensive.
+void heatmap_apply(gl_frametex ftex, const Heatmap_Stats *s);
+
+//	Saves the frametex's colours (e.g. with the heatmap drawn) to an image file
+//	
+//	The image is saved as PNG or QOI if `filename` ends with ".png" or
+//	".qoi", and as .bmp otherwise.
+//	
+//	Returns 0 on success, 1 otherwise.
+int heatmap_save_image(gl_frametex ftex, const char *filename);
+
+//	Saves the cost of each tile to a CSV file, one tile per line
+//	
+//	Returns 0 on success, 1 otherwise.
+int heatmap_save_tiles(const Heatmap_Stats *s, const char *filename);
+
+//	Frees the overlay program
+//	
+void heatmap_term();
+
+#endif
@@ -0,0 +1,674 @@
+#include "image.h"
+
+#define PNG_WINDOW 32768		// Furthest back a deflate match can reach
+#define PNG_HASH_BITS 15
+#define PNG_MIN_MATCH 4
+#define PNG_MAX_MATCH 258
+#define PNG_STORED_MAX 65535	// Most bytes in one stored deflate block
+#define ADLER_BASE 65521
+#define ADLER_NMAX 5552			// Most bytes summed before the Adler-32 sums could overflow
+#define QOI_RUN_MAX 62
+#define QOI_INDEX_SIZE 64
+#define WORD_LANES (IMAGE_VECTOR_BYTES / 4)
+
+// Bytes and 32 bit words handled together
+typedef Uint8 Image_Bytes __attribute__((vector_size(IMAGE_VECTOR_BYTES)));
+typedef Uint32 Image_Words __attribute__((vector_size(IMAGE_VECTOR_BYTES)));
+
+// Deflate bitstream being written, least significant bit first
+typedef struct {
+	Uint8 *out;
+	size_t pos;
+	Uint64 bits;
+	int count;
+} Image_Bits;
+
+// One band of rows, encoded on its own
+typedef struct {
+	Uint8 *data;		// For PNGs, a whole IDAT chunk
+	size_t size;
+	Uint32 adler;		// Adler-32 of the band's filtered bytes, for PNGs
+	size_t raw_size;	// How many filtered bytes there were
+} Image_Band;
+
+typedef struct {
+	Image_Format format;
+	const Uint8 *pixels;
+	Uint32 width;
+	Uint32 height;
+	Uint32 stride;
+	bool escape;		// Pixels are escape values rather than RGBA8
+	Uint32 bands;
+	Image_Band *out;
+	SDL_atomic_t failed;
+} Image_Job;
+
+static const char *__format_names[IMAGE_FORMAT_COUNT] = {
+	[IMAGE_BMP] = "bmp",
+	[IMAGE_PNG] = "png",
+	[IMAGE_PNG_STORED] = "png_stored",
+	[IMAGE_QOI] = "qoi",
+};
+
+static const char *__format_extensions[IMAGE_FORMAT_COUNT] = {
+	[IMAGE_BMP] = "bmp",
+	[IMAGE_PNG] = "png",
+	[IMAGE_PNG_STORED] = "png",
+	[IMAGE_QOI] = "qoi",
+};
+
+static const Uint8 __png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+static const Uint8 __zlib_header[2] = { 0x78, 0x01 };	// Deflate with a 32K window
+static const Uint8 __qoi_end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+// Deflate's match lengths and distances: the smallest each code stands for, and the extra bits after it
+static const Uint16 __len_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const Uint8 __len_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const Uint16 __dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const Uint8 __dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// Tables filled in by the first encode
+static SDL_atomic_t __tables_state;		// 0 until filled in, 1 while filling in, then 2
+static Uint32 __crc_table[4][256];		// CRC-32 of a byte, then of a byte followed by 1 to 3 zero bytes
+static Uint16 __lit_codes[288];			// Fixed Huffman codes of the literal/length symbols, bit reversed for writing
+static Uint8 __lit_lengths[288];
+static Uint8 __dist_codes[30];
+static Uint8 __len_symbol[PNG_MAX_MATCH + 1];	// Length code of each match length, less 257
+static Uint8 __dist_symbol[512];		// Distance code of each distance - 1 below 256, then of (distance - 1) >> 7
+
+static Uint32 __reverse_bits(Uint32 code, int length) {
+	Uint32 r = 0;
+	for (int i=0; i<length; i++) r |= ((code >> i) & 1) << (length - 1 - i);
+	return r;
+}
+
+static void __fill_tables() {
+	for (Uint32 n=0; n<256; n++) {
+		Uint32 c = n;
+		for (int k=0; k<8; k++) c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		__crc_table[0][n] = c;
+	}
+	for (Uint32 n=0; n<256; n++) {
+		for (int t=1; t<4; t++) __crc_table[t][n] = __crc_table[0][__crc_table[t - 1][n] & 0xFF] ^ (__crc_table[t - 1][n] >> 8);
+	}
+
+	for (Uint32 s=0; s<288; s++) {
+		Uint32 code, length;
+		if (s < 144) { code = 0x30 + s; length = 8; }
+		else if (s < 256) { code = 0x190 + s - 144; length = 9; }
+		else if (s < 280) { code = s - 256; length = 7; }
+		else { code = 0xC0 + s - 280; length = 8; }
+		__lit_codes[s] = (Uint16) __reverse_bits(code, length);
+		__lit_lengths[s] = (Uint8) length;
+	}
+	for (Uint32 d=0; d<30; d++) __dist_codes[d] = (Uint8) __reverse_bits(d, 5);
+
+	// 258 has its own code, so is left for last
+	for (Uint32 c=0; c<29; c++) {
+		for (Uint32 len=__len_base[c]; len<__len_base[c] + (1u << __len_extra[c]) && len<=PNG_MAX_MATCH; len++) __len_symbol[len] = (Uint8) c;
+	}
+	for (Uint32 c=0; c<30; c++) {
+		for (Uint32 d=__dist_base[c]; d<__dist_base[c] + (1u << __dist_extra[c]); d++) {
+			if (d - 1 < 256) __dist_symbol[d - 1] = (Uint8) c;
+			else __dist_symbol[256 + ((d - 1) >> 7)] = (Uint8) c;
+		}
+	}
+}
+
+// Fills the tables in the first time round, whichever thread gets there first
+static void __init_tables() {
+	if (SDL_AtomicGet(&__tables_state) == 2) return;
+	if (SDL_AtomicCAS(&__tables_state, 0, 1)) {
+		__fill_tables();
+		SDL_AtomicSet(&__tables_state, 2);
+		return;
+	}
+	while (SDL_AtomicGet(&__tables_state) != 2) SDL_Delay(0);
+}
+
+static void __put_be32(Uint8 *p, Uint32 v) {
+	p[0] = (Uint8)(v >> 24);
+	p[1] = (Uint8)(v >> 16);
+	p[2] = (Uint8)(v >> 8);
+	p[3] = (Uint8) v;
+}
+
+// Carries a CRC-32 on over more bytes, four at a time
+static Uint32 __crc32(Uint32 crc, const Uint8 *data, size_t len) {
+	crc = ~crc;
+	while (len >= 4) {
+		crc ^= (Uint32) data[0] | ((Uint32) data[1] << 8) | ((Uint32) data[2] << 16) | ((Uint32) data[3] << 24);
+		crc = __crc_table[3][crc & 0xFF] ^ __crc_table[2][(crc >> 8) & 0xFF] ^ __crc_table[1][(crc >> 16) & 0xFF] ^ __crc_table[0][crc >> 24];
+		data += 4;
+		len -= 4;
+	}
+	while (len-- > 0) crc = __crc_table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+// Carries an Adler-32 on over more bytes
+static Uint32 __adler32(Uint32 adler, const Uint8 *data, size_t len) {
+	Uint32 a = adler & 0xFFFF;
+	Uint32 b = adler >> 16;
+	while (len > 0) {
+		size_t n = SDL_min(len, ADLER_NMAX);
+		len -= n;
+		while (n-- > 0) {
+			a += *data++;
+			b += a;
+		}
+		a %= ADLER_BASE;
+		b %= ADLER_BASE;
+	}
+	return a | (b << 16);
+}
+
+// Works out the Adler-32 of two runs of bytes one after the other, from each run's own (like zlib's adler32_combine())
+static Uint32 __adler32_combine(Uint32 adler1, Uint32 adler2, size_t len2) {
+	Uint32 rem = (Uint32)(len2 % ADLER_BASE);
+	Uint32 a = adler1 & 0xFFFF;
+	Uint32 b = (Uint32)(((Uint64) rem * a) % ADLER_BASE);
+	a += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+	b += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+	if (a >= ADLER_BASE) a -= ADLER_BASE;
+	if (a >= ADLER_BASE) a -= ADLER_BASE;
+	if (b >= 2 * ADLER_BASE) b -= 2 * ADLER_BASE;
+	if (b >= ADLER_BASE) b -= ADLER_BASE;
+	return a | (b << 16);
+}
+
+static inline void __put_bits(Image_Bits *b, Uint32 value, int count) {
+	b->bits |= (Uint64) value << b->count;
+	b->count += count;
+	while (b->count >= 8) {
+		b->out[b->pos++] = (Uint8) b->bits;
+		b->bits >>= 8;
+		b->count -= 8;
+	}
+}
+
+static void __align_bits(Image_Bits *b) {
+	if (b->count > 0) __put_bits(b, 0, 8 - b->count);
+}
+
+static inline Uint32 __hash(const Uint8 *p) {
+	Uint32 v = (Uint32) p[0] | ((Uint32) p[1] << 8) | ((Uint32) p[2] << 16) | ((Uint32) p[3] << 24);
+	return (v * 2654435761u) >> (32 - PNG_HASH_BITS);
+}
+
+// How many bytes two runs share from the start, up to `max_len`
+static inline Uint32 __match_length(const Uint8 *a, const Uint8 *b, Uint32 max_len) {
+	Uint32 len = 0;
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+	while (len + 8 <= max_len) {
+		Uint64 x, y;
+		SDL_memcpy(&x, a + len, 8);
+		SDL_memcpy(&y, b + len, 8);
+		if (x != y) return len + (__builtin_ctzll(x ^ y) >> 3);
+		len += 8;
+	}
+#endif
+	while (len < max_len && a[len] == b[len]) len++;
+	return len;
+}
+
+static void __put_match(Image_Bits *b, Uint32 len, Uint32 dist) {
+	Uint32 ls = __len_symbol[len];
+	__put_bits(b, __lit_codes[257 + ls], __lit_lengths[257 + ls]);
+	if (__len_extra[ls] > 0) __put_bits(b, len - __len_base[ls], __len_extra[ls]);
+
+	Uint32 ds = (dist - 1 < 256) ? __dist_symbol[dist - 1] : __dist_symbol[256 + ((dist - 1) >> 7)];
+	__put_bits(b, __dist_codes[ds], 5);
+	if (__dist_extra[ds] > 0) __put_bits(b, dist - __dist_base[ds], __dist_extra[ds]);
+}
+
+// Deflates a band as one block with the fixed Huffman codes, finding matches through hash chains
+//
+// Bands other than the last finish with an empty stored block, which
+// ends them on a byte boundary so the next band's blocks can follow.
+static void __deflate_fixed(const Uint8 *in, size_t n, bool last, Image_Bits *b, Sint32 *head, Sint32 *prev) {
+	__put_bits(b, last ? 1 : 0, 1);
+	__put_bits(b, 1, 2);
+	SDL_memset(head, 0xFF, sizeof(Sint32) << PNG_HASH_BITS);
+
+	size_t i = 0;
+	while (i < n) {
+		Uint32 best_len = 0;
+		Uint32 best_dist = 0;
+		if (i + PNG_MIN_MATCH <= n) {
+			Uint32 h = __hash(in + i);
+			Sint32 cand = head[h];
+			head[h] = (Sint32) i;
+			prev[i & (PNG_WINDOW - 1)] = cand;
+
+			Uint32 max_len = (Uint32) SDL_min(PNG_MAX_MATCH, n - i);
+			for (int chain=0; chain<IMAGE_PNG_CHAIN && cand >= 0 && i - cand < PNG_WINDOW; chain++) {
+				Uint32 len = __match_length(in + cand, in + i, max_len);
+				if (len > best_len) {
+					best_len = len;
+					best_dist = (Uint32)(i - cand);
+					if (len == max_len) break;
+				}
+				Sint32 next = prev[cand & (PNG_WINDOW - 1)];
+				if (next >= cand) break;
+				cand = next;
+			}
+		}
+
+		if (best_len < PNG_MIN_MATCH) {
+			__put_bits(b, __lit_codes[in[i]], __lit_lengths[in[i]]);
+			i++;
+			continue;
+		}
+
+		// The bytes inside a match can start later matches too
+		__put_match(b, best_len, best_dist);
+		for (size_t j=i + 1; j<i + best_len && j + PNG_MIN_MATCH <= n; j++) {
+			Uint32 h = __hash(in + j);
+			prev[j & (PNG_WINDOW - 1)] = head[h];
+			head[h] = (Sint32) j;
+		}
+		i += best_len;
+	}
+	__put_bits(b, __lit_codes[256], __lit_lengths[256]);
+
+	if (!last) {
+		__put_bits(b, 0, 3);
+		__align_bits(b);
+		__put_bits(b, 0x0000, 16);
+		__put_bits(b, 0xFFFF, 16);
+	}
+	__align_bits(b);
+}
+
+// Stores a band in uncompressed deflate blocks, which always end on a byte boundary
+static void __deflate_stored(const Uint8 *in, size_t n, bool last, Image_Bits *b) {
+	size_t i = 0;
+	do {
+		Uint32 len = (Uint32) SDL_min(n - i, PNG_STORED_MAX);
+		__put_bits(b, (last && i + len == n) ? 1 : 0, 3);
+		__align_bits(b);
+		__put_bits(b, len, 16);
+		__put_bits(b, len ^ 0xFFFF, 16);
+		SDL_memcpy(b->out + b->pos, in + i, len);
+		b->pos += len;
+		i += len;
+	} while (i < n);
+}
+
+// Turns a row of escape values into big endian 16 bit greys, clamped to fit
+static void __escape_to_grey16(const Uint32 *escapes, Uint32 width, Uint8 *out) {
+	Image_Words limit = (Image_Words){ 0 } + 0xFFFF;
+	Uint32 x = 0;
+	for (; x + WORD_LANES <= width; x += WORD_LANES) {
+		Image_Words v;
+		SDL_memcpy(&v, escapes + x, sizeof(v));
+		Image_Words over = (Image_Words)(v > limit);
+		v = (v & ~over) | (limit & over);
+		Image_Words hi = v >> 8;
+		Image_Words lo = v & 0xFF;
+		for (int l=0; l<WORD_LANES; l++) {
+			out[(x + l) * 2] = (Uint8) hi[l];
+			out[(x + l) * 2 + 1] = (Uint8) lo[l];
+		}
+	}
+	for (; x<width; x++) {
+		Uint32 v = SDL_min(escapes[x], 0xFFFF);
+		out[x * 2] = (Uint8)(v >> 8);
+		out[x * 2 + 1] = (Uint8) v;
+	}
+}
+
+// Filters a row with PNG's Sub filter: each byte less the one a pixel to its left
+static void __filter_sub(const Uint8 *row, Uint32 row_bytes, Uint32 bpp, Uint8 *out) {
+	*out++ = 1;
+	Uint32 i = 0;
+	for (; i<bpp && i<row_bytes; i++) out[i] = row[i];
+	for (; i + IMAGE_VECTOR_BYTES <= row_bytes; i += IMAGE_VECTOR_BYTES) {
+		Image_Bytes cur, left;
+		SDL_memcpy(&cur, row + i, sizeof(cur));
+		SDL_memcpy(&left, row + i - bpp, sizeof(left));
+		cur -= left;
+		SDL_memcpy(out + i, &cur, sizeof(cur));
+	}
+	for (; i<row_bytes; i++) out[i] = row[i] - row[i - bpp];
+}
+
+// Filters a band's rows into `raw`, then deflates them into an IDAT chunk in `out`
+static void __png_filter_deflate(Image_Job *job, Uint32 index, Uint8 *raw, Uint8 *grey, Uint8 *out, Sint32 *head, Sint32 *prev) {
+	Image_Band *band = &job->out[index];
+	Uint32 y_start = index * IMAGE_BAND_ROWS;
+	Uint32 y_end = SDL_min(y_start + IMAGE_BAND_ROWS, job->height);
+	Uint32 bpp = job->escape ? 2 : 4;
+	Uint32 row_bytes = job->width * bpp;
+	size_t raw_size = (size_t)(y_end - y_start) * (row_bytes + 1);
+
+	for (Uint32 y=y_start; y<y_end; y++) {
+		const Uint8 *row = job->pixels + (size_t) y * job->stride;
+		if (job->escape) {
+			__escape_to_grey16((const Uint32 *) row, job->width, grey);
+			row = grey;
+		}
+		__filter_sub(row, row_bytes, bpp, raw + (size_t)(y - y_start) * (row_bytes + 1));
+	}
+	band->adler = __adler32(1, raw, raw_size);
+	band->raw_size = raw_size;
+
+	// Deflated straight into the chunk, then its length and CRC go either side
+	Image_Bits bits = { out + 8, 0, 0, 0 };
+	bool last = (index == job->bands - 1);
+	if (job->format == IMAGE_PNG_STORED) __deflate_stored(raw, raw_size, last, &bits);
+	else __deflate_fixed(raw, raw_size, last, &bits, head, prev);
+
+	__put_be32(out, (Uint32) bits.pos);
+	SDL_memcpy(out + 4, "IDAT", 4);
+	__put_be32(out + 8 + bits.pos, __crc32(0, out + 4, bits.pos + 4));
+	band->size = bits.pos + 12;
+
+}
+
+// Filters and deflates one band of rows into an IDAT chunk
+static void __png_band(void *ctx, Uint32 index, int thread) {
+	Image_Job *job = (Image_Job *) ctx;
+	Image_Band *band = &job->out[index];
+	Uint32 y_start = index * IMAGE_BAND_ROWS;
+	Uint32 y_end = SDL_min(y_start + IMAGE_BAND_ROWS, job->height);
+	Uint32 bpp = job->escape ? 2 : 4;
+	Uint32 row_bytes = job->width * bpp;
+	size_t raw_size = (size_t)(y_end - y_start) * (row_bytes + 1);
+	size_t bound = raw_size + raw_size / 8 + 5 * (raw_size / PNG_STORED_MAX + 1) + 32;
+	(void) thread;
+
+	Uint8 *raw = SDL_malloc(raw_size);
+	Uint8 *grey = job->escape ? SDL_malloc(row_bytes) : NULL;
+	Uint8 *out = SDL_malloc(8 + bound + 4);
+	Sint32 *head = NULL;
+	Sint32 *prev = NULL;
+	if (job->format == IMAGE_PNG) {
+		head = SDL_malloc(sizeof(Sint32) << PNG_HASH_BITS);
+		prev = SDL_malloc(sizeof(Sint32) * PNG_WINDOW);
+	}
+	bool failed = (raw == NULL || out == NULL || (job->escape && grey == NULL) || (job->format == IMAGE_PNG && (head == NULL || prev == NULL)));
+	if (failed) {
+		SDL_AtomicSet(&job->failed, 1);
+		SDL_free(out);
+		out = NULL;
+	}
+	band->data = out;
+	if (!failed) __png_filter_deflate(job, index, raw, grey, out, head, prev);
+
+	SDL_free(raw);
+	SDL_free(grey);
+	SDL_free(head);
+	SDL_free(prev);
+}
+
+static inline bool __same_pixel(const Uint8 *a, const Uint8 *b) {
+	return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+// Reads a pixel as four bytes; escape values least significant byte first
+static inline void __qoi_pixel(const Image_Job *job, Uint32 x, Uint32 y, Uint8 *px) {
+	const Uint8 *row = job->pixels + (size_t) y * job->stride;
+	if (!job->escape) {
+		SDL_memcpy(px, row + x * 4, 4);
+		return;
+	}
+	Uint32 v = ((const Uint32 *) row)[x];
+	px[0] = (Uint8) v;
+	px[1] = (Uint8)(v >> 8);
+	px[2] = (Uint8)(v >> 16);
+	px[3] = (Uint8)(v >> 24);
+}
+
+// QOI encodes one band of rows
+//
+// The band carries on from the band before's last pixel, like a
+// decoder would, but only uses index entries it's set itself, as it
+// can't know the rest of the decoder's index.
+static void __qoi_band(void *ctx, Uint32 index, int thread) {
+	Image_Job *job = (Image_Job *) ctx;
+	Image_Band *band = &job->out[index];
+	Uint32 y_start = index * IMAGE_BAND_ROWS;
+	Uint32 y_end = SDL_min(y_start + IMAGE_BAND_ROWS, job->height);
+	(void) thread;
+
+	Uint8 *out = SDL_malloc((size_t)(y_end - y_start) * job->width * 5);
+	band->data = out;
+	if (out == NULL) {
+		SDL_AtomicSet(&job->failed, 1);
+		return;
+	}
+
+	Uint8 seen_px[QOI_INDEX_SIZE][4];
+	bool seen[QOI_INDEX_SIZE];
+	SDL_zero(seen);
+	Uint8 prev[4] = { 0, 0, 0, 255 };
+	if (y_start > 0) __qoi_pixel(job, job->width - 1, y_start - 1, prev);
+
+	size_t pos = 0;
+	Uint32 run = 0;
+	for (Uint32 y=y_start; y<y_end; y++) {
+		for (Uint32 x=0; x<job->width; x++) {
+			Uint8 px[4];
+			__qoi_pixel(job, x, y, px);
+			if (__same_pixel(px, prev)) {
+				if (++run == QOI_RUN_MAX) {
+					out[pos++] = 0xC0 | (run - 1);
+					run = 0;
+				}
+				continue;
+			}
+			if (run > 0) {
+				out[pos++] = 0xC0 | (run - 1);
+				run = 0;
+			}
+
+			Uint32 h = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % QOI_INDEX_SIZE;
+			if (seen[h] && __same_pixel(seen_px[h], px)) {
+				out[pos++] = (Uint8) h;
+			} else {
+				SDL_memcpy(seen_px[h], px, 4);
+				seen[h] = true;
+				Sint8 dr = (Sint8)(px[0] - prev[0]);
+				Sint8 dg = (Sint8)(px[1] - prev[1]);
+				Sint8 db = (Sint8)(px[2] - prev[2]);
+				Sint8 dr_dg = (Sint8)(dr - dg);
+				Sint8 db_dg = (Sint8)(db - dg);
+				if (px[3] != prev[3]) {
+					out[pos++] = 0xFF;
+					SDL_memcpy(out + pos, px, 4);
+					pos += 4;
+				} else if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+					out[pos++] = 0x40 | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+				} else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7) {
+					out[pos++] = 0x80 | (dg + 32);
+					out[pos++] = ((dr_dg + 8) << 4) | (db_dg + 8);
+				} else {
+					out[pos++] = 0xFE;
+					SDL_memcpy(out + pos, px, 3);
+					pos += 3;
+				}
+			}
+			SDL_memcpy(prev, px, 4);
+		}
+	}
+	if (run > 0) out[pos++] = 0xC0 | (run - 1);
+	band->size = pos;
+}
+
+// Writes a chunk with its length and CRC, returning where the next one goes
+static Uint8 *__put_chunk(Uint8 *p, const char *type, const Uint8 *data, Uint32 len) {
+	__put_be32(p, len);
+	SDL_memcpy(p + 4, type, 4);
+	if (len > 0) SDL_memcpy(p + 8, data, len);
+	__put_be32(p + 8 + len, __crc32(0, p + 4, len + 4));
+	return p + 12 + len;
+}
+
+// Joins the bands into a PNG file
+static Uint8 *__png_join(const Image_Job *job, size_t *size) {
+	Uint8 ihdr[13];
+	__put_be32(ihdr, job->width);
+	__put_be32(ihdr + 4, job->height);
+	ihdr[8] = job->escape ? 16 : 8;		// Bit depth
+	ihdr[9] = job->escape ? 0 : 6;		// Greyscale or RGBA
+	ihdr[10] = ihdr[11] = ihdr[12] = 0;	// Deflate, adaptive filtering, no interlacing
+
+	Uint32 adler = job->out[0].adler;
+	size_t total = sizeof(__png_signature) + (12 + sizeof(ihdr)) + (12 + sizeof(__zlib_header)) + (12 + 4) + 12;
+	for (Uint32 i=0; i<job->bands; i++) {
+		total += job->out[i].size;
+		if (i > 0) adler = __adler32_combine(adler, job->out[i].adler, job->out[i].raw_size);
+	}
+	Uint8 *file = SDL_malloc(total);
+	if (file == NULL) return NULL;
+
+	Uint8 adler_be[4];
+	__put_be32(adler_be, adler);
+	Uint8 *p = file;
+	SDL_memcpy(p, __png_signature, sizeof(__png_signature));
+	p += sizeof(__png_signature);
+	p = __put_chunk(p, "IHDR", ihdr, sizeof(ihdr));
+	p = __put_chunk(p, "IDAT", __zlib_header, sizeof(__zlib_header));
+	for (Uint32 i=0; i<job->bands; i++) {
+		SDL_memcpy(p, job->out[i].data, job->out[i].size);
+		p += job->out[i].size;
+	}
+	p = __put_chunk(p, "IDAT", adler_be, sizeof(adler_be));
+	p = __put_chunk(p, "IEND", NULL, 0);
+
+	*size = (size_t)(p - file);
+	return file;
+}
+
+// Joins the bands into a QOI file
+static Uint8 *__qoi_join(const Image_Job *job, size_t *size) {
+	size_t total = 14 + sizeof(__qoi_end);
+	for (Uint32 i=0; i<job->bands; i++) total += job->out[i].size;
+	Uint8 *file = SDL_malloc(total);
+	if (file == NULL) return NULL;
+
+	SDL_memcpy(file, "qoif", 4);
+	__put_be32(file + 4, job->width);
+	__put_be32(file + 8, job->height);
+	file[12] = 4;						// RGBA
+	file[13] = job->escape ? 1 : 0;		// Escape values are "linear", colours sRGB
+	Uint8 *p = file + 14;
+	for (Uint32 i=0; i<job->bands; i++) {
+		SDL_memcpy(p, job->out[i].data, job->out[i].size);
+		p += job->out[i].size;
+	}
+	SDL_memcpy(p, __qoi_end, sizeof(__qoi_end));
+
+	*size = total;
+	return file;
+}
+
+// Encodes and writes an image file
+static int __save_encoded(const char *filename, Image_Format format, const void *pixels, Uint32 width, Uint32 height, Uint32 stride, bool escape, Pool *pool) {
+	size_t size = 0;
+	Uint8 *data = image_encode(format, pixels, width, height, stride, escape, pool, &size);
+	if (data == NULL) {
+		printf("[ERROR] Failed to encode '%s'\n", filename);
+		return 1;
+	}
+
+	int result = 0;
+	FILE *f = fopen(filename, "wb");
+	if (f == NULL || fwrite(data, 1, size, f) != size) {
+		printf("[ERROR] Failed to save '%s'\n", filename);
+		result = 1;
+	}
+	if (f != NULL && fclose(f) != 0) result = 1;
+	SDL_free(data);
+	return result;
+}
+
+
+int image_save_bmp(const char *filename, const void *pixels, Uint32 width, Uint32 height, Uint32 stride) {
+	SDL_Surface *surf = SDL_CreateRGBSurfaceWithFormatFrom((void *) pixels, width, height, 32, stride, SDL_PIXELFORMAT_RGBA32);
+	if (surf == NULL) {
+		printf("[ERROR] Failed to create surface for '%s': %s\n", filename, SDL_GetError());
+		return 1;
+	}
+
+	int result = 0;
+	if (SDL_SaveBMP(surf, filename) != 0) {
+		printf("[ERROR] Failed to save '%s': %s\n", filename, SDL_GetError());
+		result = 1;
+	}
+
+	SDL_FreeSurface(surf);
+	return result;
+}
+
+Uint8 *image_encode(Image_Format format, const void *pixels, Uint32 width, Uint32 height, Uint32 stride, bool escape, Pool *pool, size_t *size) {
+	if (format == IMAGE_BMP || format >= IMAGE_FORMAT_COUNT) return NULL;
+	if (pixels == NULL || width == 0 || height == 0 || stride < width * 4) return NULL;
+	__init_tables();
+
+	Image_Job job = {
+		.format = format,
+		.pixels = pixels,
+		.width = width,
+		.height = height,
+		.stride = stride,
+		.escape = escape,
+		.bands = (height + IMAGE_BAND_ROWS - 1) / IMAGE_BAND_ROWS,
+	};
+	job.out = SDL_calloc(job.bands, sizeof(Image_Band));
+	if (job.out == NULL) return NULL;
+
+	Pool_Job band_job = (format == IMAGE_QOI) ? __qoi_band : __png_band;
+	if (pool != NULL) pool_run(pool, job.bands, band_job, &job);
+	else for (Uint32 i=0; i<job.bands; i++) band_job(&job, i, 0);
+
+	Uint8 *file = NULL;
+	if (SDL_AtomicGet(&job.failed) == 0) {
+		if (format == IMAGE_QOI) file = __qoi_join(&job, size);
+		else file = __png_join(&job, size);
+	}
+
+	for (Uint32 i=0; i<job.bands; i++) SDL_free(job.out[i].data);
+	SDL_free(job.out);
+	return file;
+}
+
+int image_save(const char *filename, Image_Format format, const void *pixels, Uint32 width, Uint32 height, Uint32 stride, Pool *pool) {
+	if (format == IMAGE_BMP) return image_save_bmp(filename, pixels, width, height, stride);
+	return __save_encoded(filename, format, pixels, width, height, stride, false, pool);
+}
+
+int image_save_escape(const char *filename, Image_Format format, const Uint32 *escapes, Uint32 width, Uint32 height, Uint32 stride, Pool *pool) {
+	if (format == IMAGE_BMP) {
+		printf("[ERROR] Escape values can't be saved as a .bmp ('%s')\n", filename);
+		return 1;
+	}
+	return __save_encoded(filename, format, escapes, width, height, stride, true, pool);
+}
+
+Image_Format image_format_from_filename(const char *filename) {
+	const char *dot = SDL_strrchr(filename, '.');
+	if (dot == NULL) return IMAGE_BMP;
+	if (SDL_strcasecmp(dot, ".png") == 0) return IMAGE_PNG;
+	if (SDL_strcasecmp(dot, ".qoi") == 0) return IMAGE_QOI;
+	return IMAGE_BMP;
+}
+
+Image_Format image_format_from_name(const char *name) {
+	for (int f=0; f<IMAGE_FORMAT_COUNT; f++) {
+		if (SDL_strcmp(name, __format_names[f]) == 0) return f;
+	}
+	return IMAGE_FORMAT_COUNT;
+}
+
+const char *image_format_name(Image_Format format) {
+	if (format >= IMAGE_FORMAT_COUNT) return "(none)";
+	return __format_names[format];
+}
+
+const char *image_format_extension(Image_Format format) {
+	if (format >= IMAGE_FORMAT_COUNT) return "";
+	return __format_extensions[format];
+}
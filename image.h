@@ -0,0 +1,85 @@
+//	
+//	Saving rendered frames to image files
+//	
+//	PNG and QOI files are encoded in bands of rows, each band on its
+//	own thread of a pool. PNG bands are filtered and deflated on their
+//	own (so matches never reach back into the band before) and each
+//	ends on a byte boundary with an empty stored block, so the bands
+//	can simply be written one after another as separate IDAT chunks.
+//	The zlib checksum of the whole image is combined from the bands'
+//	checksums at the end. The deflate encoder is a simple one, using
+//	the fixed Huffman codes, which suits the long runs and repeats of
+//	rendered frames well enough at a fraction of zlib's cost.
+//	
+//	QOI bands start from the last pixel of the band before, and only
+//	refer back to colours the band has seen itself, so any QOI decoder
+//	reads the joined bands as one image.
+//	
+//	Escape values can be saved as 16 bit greyscale PNGs (clamped to
+//	65535) or losslessly as QOIs, with each value's bytes (least
+//	significant first) as the red, green, blue and alpha channels.
+//	
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "pool.h"
+
+#define IMAGE_BAND_ROWS 64		// Rows per band encoded on its own
+#define IMAGE_PNG_CHAIN 8		// Earlier matches tried at each byte when deflating; more compresses better but slower
+#define IMAGE_VECTOR_BYTES 16	// Bytes filtered together
+
+
+typedef enum {
+	IMAGE_BMP,
+	IMAGE_PNG,
+	IMAGE_PNG_STORED,	// PNG with uncompressed deflate blocks, for when saving speed matters more than size
+	IMAGE_QOI,
+	IMAGE_FORMAT_COUNT
+} Image_Format;
+
+
+//	Saves RGBA8 pixels (rows from the top down) to a .bmp file
+//	
+//	Returns 0 on success, 1 otherwise.
+int image_save_bmp(const char *filename, const void *pixels, Uint32 width, Uint32 height, Uint32 stride);
+
+//	Encodes RGBA8 pixels, or escape values if `escape` is set, to an image file in memory
+//	
+//	Bands are encoded in parallel on `pool`, or all on the calling thread
+//	if it's NULL. Doesn't support IMAGE_BMP.
+//	Returns the file's bytes, to be freed with `SDL_free()`, or NULL on error.
+Uint8 *image_encode(Image_Format format, const void *pixels, Uint32 width, Uint32 height, Uint32 stride, bool escape, Pool *pool, size_t *size);
+
+//	Saves RGBA8 pixels to an image file in any format
+//	
+//	PNGs and QOIs are encoded on `pool`, which may be NULL.
+//	Returns 0 on success, 1 otherwise.
+int image_save(const char *filename, Image_Format format, const void *pixels, Uint32 width, Uint32 height, Uint32 stride, Pool *pool);
+
+//	Saves escape values to an image file in any format but IMAGE_BMP
+//	
+//	Returns 0 on success, 1 otherwise.
+int image_save_escape(const char *filename, Image_Format format, const Uint32 *escapes, Uint32 width, Uint32 height, Uint32 stride, Pool *pool);
+
+//	Picks an image format from a file's extension
+//	
+//	Anything that isn't .png or .qoi is IMAGE_BMP.
+Image_Format image_format_from_filename(const char *filename);
+
+//	Gets an image format from its name (e.g. "png"), or IMAGE_FORMAT_COUNT if there isn't one
+//	
+Image_Format image_format_from_name(const char *name);
+
+//	Gets the short name of an image format (e.g. "png_stored")
+//	
+const char *image_format_name(Image_Format format);
+
+//	Gets the file extension of an image format, without the dot (e.g. "png")
+//	
+const char *image_format_extension(Image_Format format);
+
+#endif
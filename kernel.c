@@ -0,0 +1,574 @@
+#include "kernel.h"
+#include "trace.h"
+
+// How a kernel's workgroups are launched over the frame
+typedef enum {
+	LAUNCH_PIXELS,		// A workgroup per pixel
+	LAUNCH_PERSISTENT,	// A fixed number of workgroups that pull tiles off a queue
+	LAUNCH_PASSES,		// Passes over a list of the pixels still iterating, compacted between passes
+} Kernel_Launch;
+
+typedef struct {
+	const char *name;
+	const char *shader_filename;
+	int precision_bits;	// Mantissa bits, or fractional bits for fixed point
+	bool fixed_point;	// Precision is absolute rather than relative to the magnitude
+	int cost;			// Rough relative cost per iteration, for picking the cheapest kernel
+	Kernel_Launch launch;
+	Uint32 max_power;	// Highest power of z it can be built for
+	GLuint programs[KERNEL_FRACTAL_COUNT][KERNEL_MAX_POWER + 1];	// Built variants, by formula
+	bool failed[KERNEL_FRACTAL_COUNT][KERNEL_MAX_POWER + 1];	// Variants that didn't build on this device
+} Kernel;
+
+static Kernel __kernels[KERNEL_COUNT] = {
+	[KERNEL_FLOAT] = { "float", "shaders/mandelbrot_float.comp", 24, false, 1, LAUNCH_PIXELS, KERNEL_MAX_POWER, { { NULL_PROGRAM } }, { { false } } },
+	[KERNEL_DOUBLE] = { "double", "shaders/mandelbrot_double.comp", 53, false, 16, LAUNCH_PIXELS, KERNEL_MAX_POWER, { { NULL_PROGRAM } }, { { false } } },
+	[KERNEL_FIXPT] = { "fixpt", "shaders/mandelbrot_fixpt.comp", KERNEL_FIXPT_FRAC_BITS, true, 4, LAUNCH_PIXELS, 2, { { NULL_PROGRAM } }, { { false } } },
+	[KERNEL_DFLOAT] = { "dfloat", "shaders/mandelbrot_dfloat.comp", KERNEL_DFLOAT_BITS, false, 6, LAUNCH_PIXELS, KERNEL_MAX_POWER, { { NULL_PROGRAM } }, { { false } } },
+	// Same cost as float so that auto, which keeps the first of a tie, sticks with plain dispatch
+	[KERNEL_PERSISTENT] = { "persist", "shaders/mandelbrot_persistent.comp", 24, false, 1, LAUNCH_PERSISTENT, KERNEL_MAX_POWER, { { NULL_PROGRAM } }, { { false } } },
+	[KERNEL_COMPACT] = { "compact", "shaders/mandelbrot_compact.comp", 24, false, 1, LAUNCH_PASSES, KERNEL_MAX_POWER, { { NULL_PROGRAM } }, { { false } } },
+};
+
+static const char *__fractal_names[KERNEL_FRACTAL_COUNT] = {
+	[KERNEL_MANDELBROT] = "mandelbrot",
+	[KERNEL_JULIA] = "julia",
+};
+
+static Kernel_Formula __formula = { KERNEL_MANDELBROT, 2, 0.0, 0.0 };
+static bool __all_loaded = false;	// Every variant of every kernel has been built, or failed to
+
+static const char *__order_names[KERNEL_ORDER_COUNT] = {
+	[KERNEL_ORDER_ROWS] = "rows",
+	[KERNEL_ORDER_MORTON] = "morton",
+	[KERNEL_ORDER_CENTRE_OUT] = "centre",
+};
+
+static GLuint __counter_buffer = 0;
+
+// Copies of the counters on their way back to the CPU, read once their fences signal
+static GLuint __readback_buffer = 0;
+static const GLuint *__readback_map = NULL;	// Persistently mapped
+static GLsync __readback_fences[KERNEL_COUNTER_READBACKS];
+static Uint32 __readback_head = 0;	// Oldest copy in flight
+static Uint32 __readback_count = 0;
+
+// Persistent kernel settings, and the tile queue built for them
+static GLuint __tile_size = KERNEL_TILE_SIZE;
+static Kernel_Tile_Order __tile_order = KERNEL_ORDER_ROWS;
+static GLuint __persistent_groups = KERNEL_PERSISTENT_GROUPS;
+static GLuint __queue_buffer = 0;
+static GLuint __queue_w = 0, __queue_h = 0;	// Frame size the queue was built for, 0 if it needs rebuilding
+
+typedef struct {
+	Uint64 key;
+	GLuint tile;
+} Kernel_Tile_Key;
+
+// Compacting kernel's live pixel lists (one read and one written by each pass) and pass state
+static GLuint __prepare_program = NULL_PROGRAM;
+static GLuint __live_buffers[2] = { 0, 0 };
+static GLuint __pass_buffer = 0;
+static GLuint __live_pixels = 0;	// Pixels the live lists can hold
+
+// Creates and binds the buffer the kernels count their iterations into
+static void __bind_counter() {
+	if (__counter_buffer == 0) {
+		glCreateBuffers(1, &__counter_buffer);
+		glNamedBufferStorage(__counter_buffer, KERNEL_COUNTER_BYTES, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glClearNamedBufferData(__counter_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+		gl_check_err("Failed to create iteration counter");
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, __counter_buffer);
+}
+
+// Adds up the counters, each a low and a high word
+static Uint64 __sum_counters(const GLuint *counts) {
+	Uint64 total = 0;
+	for (int i=0; i<KERNEL_COUNTER_SLOTS; i++) total += counts[2 * i] | ((Uint64) counts[2 * i + 1] << 32);
+	return total;
+}
+
+// Adds up the oldest copy of the counters in flight, once the GPU has written it (waiting for it if `wait`)
+static bool __collect_readback(bool wait, Uint64 *total) {
+	if (__readback_count == 0) return false;
+	GLsync *fence = &__readback_fences[__readback_head];
+	GLenum status = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+
+	glDeleteSync(*fence);
+	*fence = NULL;
+	*total += __sum_counters(__readback_map + __readback_head * KERNEL_COUNTER_SLOTS * 2);
+	__readback_head = (__readback_head + 1) % KERNEL_COUNTER_READBACKS;
+	__readback_count--;
+	return true;
+}
+
+// Interleaves the bits of x and y, giving a tile's position along a Z-order curve
+static Uint64 __morton(Uint32 x, Uint32 y) {
+	Uint64 code = 0;
+	for (int bit=0; bit<32; bit++) {
+		code |= (Uint64)((x >> bit) & 1) << (2 * bit);
+		code |= (Uint64)((y >> bit) & 1) << (2 * bit + 1);
+	}
+	return code;
+}
+
+static int __compare_tiles(const void *a, const void *b) {
+	const Kernel_Tile_Key *ta = (const Kernel_Tile_Key *) a;
+	const Kernel_Tile_Key *tb = (const Kernel_Tile_Key *) b;
+	if (ta->key != tb->key) return (ta->key < tb->key) ? -1 : 1;
+	return (ta->tile < tb->tile) ? -1 : (ta->tile > tb->tile);	// Keep ties in a stable order
+}
+
+// Builds the tile queue for a frame size and binds it, only resetting its read position if it's already built
+static int __bind_queue(GLuint width, GLuint height) {
+	if (__queue_buffer != 0 && __queue_w == width && __queue_h == height) {
+		GLuint zero = 0;
+		glNamedBufferSubData(__queue_buffer, 0, sizeof(zero), &zero);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, __queue_buffer);
+		return 0;
+	}
+
+	GLuint tiles_x = (width + __tile_size - 1) / __tile_size;
+	GLuint tiles_y = (height + __tile_size - 1) / __tile_size;
+	GLuint count = tiles_x * tiles_y;
+
+	GLuint *queue = SDL_malloc(sizeof(GLuint) * (count + 1));
+	if (queue == NULL || kernel_tile_order(width, height, __tile_size, __tile_order, queue + 1) != 0) {
+		puts("[ERROR] Failed to allocate the tile queue");
+		SDL_free(queue);
+		return 1;
+	}
+	queue[0] = 0;	// Read position
+
+	// The shader gets the number of tiles from the size of the buffer, so it has to fit exactly
+	if (__queue_buffer != 0) glDeleteBuffers(1, &__queue_buffer);
+	glCreateBuffers(1, &__queue_buffer);
+	glNamedBufferStorage(__queue_buffer, sizeof(GLuint) * (count + 1), queue, GL_DYNAMIC_STORAGE_BIT);
+	SDL_free(queue);
+	gl_check_err("Failed to create tile queue");
+
+	__queue_w = width;
+	__queue_h = height;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, __queue_buffer);
+	return 0;
+}
+
+// Makes sure the compacting kernel's buffers can hold every pixel of a frame
+static void __ensure_live_lists(GLuint pixels) {
+	if (__prepare_program == NULL_PROGRAM) {
+		__prepare_program = glCreateProgram();
+		GLuint comp_shader = gl_load_shader(GL_COMPUTE_SHADER, "shaders/compact_prepare.comp");
+		glAttachShader(__prepare_program, comp_shader);
+		gl_link_program(__prepare_program);
+		glDeleteShader(comp_shader);
+	}
+	if (__pass_buffer == 0) {
+		glCreateBuffers(1, &__pass_buffer);
+		glNamedBufferStorage(__pass_buffer, sizeof(GLuint) * 5, NULL, GL_DYNAMIC_STORAGE_BIT);
+	}
+	if (__live_pixels < pixels) {
+		if (__live_buffers[0] != 0) glDeleteBuffers(2, __live_buffers);
+		glCreateBuffers(2, __live_buffers);
+		for (int i=0; i<2; i++) {
+			// z (2 floats), pixel index and iterations so far
+			glNamedBufferStorage(__live_buffers[i], (GLsizeiptr) pixels * sizeof(GLuint) * 4, NULL, 0);
+		}
+		__live_pixels = pixels;
+	}
+	gl_check_err("Failed to create live pixel lists");
+}
+
+// Issues every pass of the compacting kernel, whose program must be in use with its view set
+static void __dispatch_passes(GLuint program, gl_frametex ftex, GLuint iterations) {
+	GLuint pixels = ftex.w * ftex.h;
+	__ensure_live_lists(pixels);
+
+	// Nothing to read in the first pass, and nothing written yet
+	GLuint state[5] = { 0, 0, 0, 0, 0 };
+	glNamedBufferSubData(__pass_buffer, 0, sizeof(state), state);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, __pass_buffer);
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, __pass_buffer);
+	glUniform1ui(3, KERNEL_COMPACT_PASS_ITERATIONS);
+
+	// Always at least the first pass, which is what writes every pixel (as interior, with no iterations)
+	GLuint passes = SDL_max((iterations + KERNEL_COMPACT_PASS_ITERATIONS - 1) / KERNEL_COMPACT_PASS_ITERATIONS, 1);
+	for (GLuint pass=0; pass<passes; pass++) {
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, __live_buffers[pass % 2]);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, __live_buffers[1 - pass % 2]);
+
+		if (pass == 0) {
+			// Every pixel starts off alive, so the size is known up front
+			GLuint groups = (pixels + KERNEL_COMPACT_GROUP_SIZE - 1) / KERNEL_COMPACT_GROUP_SIZE;
+			glUniform1i(4, GL_TRUE);
+			glDispatchCompute(SDL_min(groups, KERNEL_COMPACT_ROW_GROUPS), (groups + KERNEL_COMPACT_ROW_GROUPS - 1) / KERNEL_COMPACT_ROW_GROUPS, 1);
+			glUniform1i(4, GL_FALSE);
+		} else {
+			// Size this pass by what the last one left alive, without reading it back
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+			glUseProgram(__prepare_program);
+			glDispatchCompute(1, 1, 1);
+			glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+			glUseProgram(program);
+			glDispatchComputeIndirect(0);
+		}
+	}
+
+	glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+}
+
+// Builds the variant of a kernel for a formula, remembering if it fails so it's only tried once
+static GLuint __build_variant(Kernel *k, Kernel_Fractal fractal, Uint32 power) {
+	GLuint *program = &k->programs[fractal][power];
+	if (*program != NULL_PROGRAM || k->failed[fractal][power] || power > k->max_power) return *program;
+
+	// The formula is baked into each variant, so the power can be unrolled
+	char defines[64];
+	SDL_snprintf(defines, sizeof(defines), "#define POWER %u\n%s", power, (fractal == KERNEL_JULIA) ? "#define JULIA\n" : "");
+	GLuint comp_shader = gl_load_shader_defines(GL_COMPUTE_SHADER, k->shader_filename, defines);
+	GLint linked = GL_FALSE;
+	*program = glCreateProgram();
+	if (comp_shader != 0) {
+		glAttachShader(*program, comp_shader);
+		gl_link_program(*program);
+		glDeleteShader(comp_shader);
+		glGetProgramiv(*program, GL_LINK_STATUS, &linked);
+	}
+
+	// Not every device supports every number format (e.g. fp64), or every variant of one
+	if (linked != GL_TRUE) {
+		printf("[WARN ] Kernel '%s' is unavailable for z^%u %s on this device\n", k->name, power, __fractal_names[fractal]);
+		fflush(stdout);
+		glDeleteProgram(*program);
+		*program = NULL_PROGRAM;
+		k->failed[fractal][power] = true;
+	}
+
+	return *program;
+}
+
+// Converts to the fixed-point kernel's format
+static GLint __to_fixed(double v) {
+	return (GLint) SDL_floor(v * (double)(1 << KERNEL_FIXPT_FRAC_BITS) + 0.5);
+}
+
+
+const char *kernel_name(Kernel_Id id) {
+	if (id == KERNEL_AUTO) return "auto";
+	if (id >= KERNEL_COUNT) return "(none)";
+	return __kernels[id].name;
+}
+
+Kernel_Id kernel_from_name(const char *name) {
+	if (name == NULL) return KERNEL_COUNT;
+	if (SDL_strcmp(name, "auto") == 0) return KERNEL_AUTO;
+	for (int i=0; i<KERNEL_COUNT; i++) {
+		if (SDL_strcmp(__kernels[i].name, name) == 0) return (Kernel_Id) i;
+	}
+	return KERNEL_COUNT;
+}
+
+int kernel_cost(Kernel_Id id) {
+	if (id >= KERNEL_COUNT) return 1;
+	return __kernels[id].cost;
+}
+
+GLuint kernel_program(Kernel_Id id) {
+	if (id >= KERNEL_COUNT) return NULL_PROGRAM;
+	return __build_variant(&__kernels[id], __formula.fractal, __formula.power);
+}
+
+void kernel_load_all() {
+	for (int i=0; i<KERNEL_COUNT; i++) kernel_program(i);
+}
+
+bool kernel_load_next() {
+	if (__all_loaded) return false;
+
+	// A formula at a time, so each one becomes free to switch to as soon as possible
+	for (int f=0; f<KERNEL_FRACTAL_COUNT; f++) {
+		for (Uint32 n=2; n<=KERNEL_MAX_POWER; n++) {
+			for (int i=0; i<KERNEL_COUNT; i++) {
+				Kernel *k = &__kernels[i];
+				if (k->programs[f][n] != NULL_PROGRAM || k->failed[f][n] || n > k->max_power) continue;
+				__build_variant(k, f, n);
+				return true;
+			}
+		}
+	}
+
+	__all_loaded = true;
+	return false;
+}
+
+bool kernel_available(Kernel_Id id) {
+	return kernel_program(id) != NULL_PROGRAM;
+}
+
+const char *kernel_fractal_name(Kernel_Fractal fractal) {
+	if (fractal >= KERNEL_FRACTAL_COUNT) return "(none)";
+	return __fractal_names[fractal];
+}
+
+Kernel_Fractal kernel_fractal_from_name(const char *name) {
+	if (name == NULL) return KERNEL_FRACTAL_COUNT;
+	for (int i=0; i<KERNEL_FRACTAL_COUNT; i++) {
+		if (SDL_strcmp(__fractal_names[i], name) == 0) return (Kernel_Fractal) i;
+	}
+	return KERNEL_FRACTAL_COUNT;
+}
+
+int kernel_set_formula(Kernel_Formula formula) {
+	if (!kernel_formula_valid(formula)) return 1;
+	__formula = formula;
+	return 0;
+}
+
+bool kernel_formula_valid(Kernel_Formula formula) {
+	if (formula.fractal >= KERNEL_FRACTAL_COUNT || formula.power < 2 || formula.power > KERNEL_MAX_POWER) return false;
+	if (formula.fractal == KERNEL_JULIA && SDL_sqrt(formula.julia_x * formula.julia_x + formula.julia_y * formula.julia_y) > KERNEL_JULIA_MAX_C) return false;
+	return true;
+}
+
+Kernel_Formula kernel_formula() {
+	return __formula;
+}
+
+bool kernel_is_exact(Kernel_Id id, double screen_x, double screen_y, double zoom, GLuint width, GLuint height) {
+	if (id >= KERNEL_COUNT || zoom <= 0.0) return false;
+	Kernel *k = &__kernels[id];
+
+	// Furthest the view reaches from 0,0 on either axis
+	double extent_x = SDL_fabs(screen_x) + width / 2.0 / zoom;
+	double extent_y = SDL_fabs(screen_y) + height / 2.0 / zoom;
+	double extent = SDL_max(extent_x, extent_y);
+
+	// Z itself gets out to 2 before escaping, whatever the view
+	double magnitude = SDL_max(extent, 2.0);
+
+	double step;
+	if (k->fixed_point) {
+		if (extent >= KERNEL_FIXPT_RANGE) return false;
+		step = SDL_pow(2.0, -k->precision_bits);
+	} else {
+		step = magnitude * SDL_pow(2.0, 1 - k->precision_bits);
+	}
+
+	return (1.0 / zoom) >= KERNEL_PRECISION_MARGIN * step;
+}
+
+Kernel_Id kernel_choose(double screen_x, double screen_y, double zoom, GLuint width, GLuint height) {
+	Kernel_Id best = KERNEL_COUNT;
+	Kernel_Id most_precise = KERNEL_COUNT;
+
+	for (int i=0; i<KERNEL_COUNT; i++) {
+		if (!kernel_available(i)) continue;
+		Kernel *k = &__kernels[i];
+
+		if (most_precise == KERNEL_COUNT || (!k->fixed_point && k->precision_bits > __kernels[most_precise].precision_bits)) {
+			most_precise = i;
+		}
+		if (!kernel_is_exact(i, screen_x, screen_y, zoom, width, height)) continue;
+		if (best == KERNEL_COUNT || k->cost < __kernels[best].cost) best = i;
+	}
+
+	// Past what any kernel can resolve, so just do the best we can
+	if (best == KERNEL_COUNT) return most_precise;
+	return best;
+}
+
+const char *kernel_order_name(Kernel_Tile_Order order) {
+	if (order >= KERNEL_ORDER_COUNT) return "(none)";
+	return __order_names[order];
+}
+
+Kernel_Tile_Order kernel_order_from_name(const char *name) {
+	if (name == NULL) return KERNEL_ORDER_COUNT;
+	for (int i=0; i<KERNEL_ORDER_COUNT; i++) {
+		if (SDL_strcmp(__order_names[i], name) == 0) return (Kernel_Tile_Order) i;
+	}
+	return KERNEL_ORDER_COUNT;
+}
+
+int kernel_tile_order(GLuint width, GLuint height, GLuint tile_size, Kernel_Tile_Order order, GLuint *queue) {
+	GLuint tiles_x = (width + tile_size - 1) / tile_size;
+	GLuint tiles_y = (height + tile_size - 1) / tile_size;
+	GLuint count = tiles_x * tiles_y;
+
+	Kernel_Tile_Key *keys = SDL_malloc(sizeof(Kernel_Tile_Key) * count);
+	if (keys == NULL) return 1;
+
+	for (GLuint ty=0; ty<tiles_y; ty++) {
+		for (GLuint tx=0; tx<tiles_x; tx++) {
+			Kernel_Tile_Key *k = &keys[ty * tiles_x + tx];
+			k->tile = ty * tiles_x + tx;
+			switch (order) {
+				case KERNEL_ORDER_MORTON: k->key = __morton(tx, ty); break;
+				case KERNEL_ORDER_CENTRE_OUT: {
+					// Twice the tile centre's offset from the frame centre, to keep it integral
+					Sint64 dx = (Sint64)(2 * tx + 1) * tile_size - width;
+					Sint64 dy = (Sint64)(2 * ty + 1) * tile_size - height;
+					k->key = (Uint64)(dx * dx + dy * dy);
+				} break;
+				default: k->key = k->tile; break;
+			}
+		}
+	}
+	SDL_qsort(keys, count, sizeof(Kernel_Tile_Key), __compare_tiles);
+
+	for (GLuint i=0; i<count; i++) queue[i] = keys[i].tile;
+	SDL_free(keys);
+	return 0;
+}
+
+void kernel_set_tiling(GLuint tile_size, Kernel_Tile_Order order, GLuint groups) {
+	if (tile_size == 0 || order >= KERNEL_ORDER_COUNT || groups == 0) return;
+	if (tile_size != __tile_size || order != __tile_order) __queue_w = __queue_h = 0;
+	__tile_size = tile_size;
+	__tile_order = order;
+	__persistent_groups = groups;
+}
+
+void kernel_set_view(Kernel_Id id, double screen_x, double screen_y, double zoom, GLuint iterations) {
+	switch (id) {
+		case KERNEL_FLOAT:
+		case KERNEL_PERSISTENT:
+		case KERNEL_COMPACT: glUniform3f(0, (float) screen_x, (float) screen_y, (float) zoom); break;
+		case KERNEL_DOUBLE: glUniform3d(0, screen_x, screen_y, zoom); break;
+		case KERNEL_FIXPT: {
+			glUniform2i(0, __to_fixed(screen_x), __to_fixed(screen_y));
+			glUniform1f(2, (float) zoom);
+		} break;
+		case KERNEL_DFLOAT: {
+			float x_hi = (float) screen_x;
+			float y_hi = (float) screen_y;
+			glUniform4f(0, x_hi, (float)(screen_x - x_hi), y_hi, (float)(screen_y - y_hi));
+			glUniform1f(2, (float) zoom);
+		} break;
+		default: return;
+	}
+
+	if (__formula.fractal == KERNEL_JULIA) {
+		double jx = __formula.julia_x;
+		double jy = __formula.julia_y;
+		switch (id) {
+			case KERNEL_DOUBLE: glUniform2d(KERNEL_JULIA_LOCATION, jx, jy); break;
+			case KERNEL_FIXPT: glUniform2i(KERNEL_JULIA_LOCATION, __to_fixed(jx), __to_fixed(jy)); break;
+			case KERNEL_DFLOAT: glUniform4f(KERNEL_JULIA_LOCATION, (float) jx, (float)(jx - (float) jx), (float) jy, (float)(jy - (float) jy)); break;
+			default: glUniform2f(KERNEL_JULIA_LOCATION, (float) jx, (float) jy); break;
+		}
+	}
+	glUniform1ui(1, iterations);
+	gl_check_err("Failed to set kernel view");
+}
+
+void kernel_dispatch(Kernel_Id id, gl_frametex ftex, double screen_x, double screen_y, double zoom, GLuint iterations) {
+	if (id == KERNEL_AUTO) id = kernel_choose(screen_x, screen_y, zoom, ftex.w, ftex.h);
+	if (!kernel_available(id)) return;
+
+	Kernel_Launch launch = __kernels[id].launch;
+	GLuint program = kernel_program(id);
+
+	TRACE_BEGIN("uniforms");
+	glUseProgram(program);
+	glBindImageTexture(0, ftex.tex, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+	glBindImageTexture(1, ftex.escape, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+	__bind_counter();
+	kernel_set_view(id, screen_x, screen_y, zoom, iterations);
+	bool queued = (launch == LAUNCH_PERSISTENT) && __bind_queue(ftex.w, ftex.h) == 0;
+	if (queued) {
+		glUniform1ui(3, __tile_size);
+		glUniform1ui(4, (ftex.w + __tile_size - 1) / __tile_size);
+	}
+	TRACE_END();
+
+	TRACE_BEGIN("dispatch");
+	switch (launch) {
+		case LAUNCH_PERSISTENT: if (queued) glDispatchCompute(__persistent_groups, 1, 1); break;
+		case LAUNCH_PASSES: __dispatch_passes(program, ftex, iterations); break;
+		default: glDispatchCompute(ftex.w, ftex.h, 1); break;
+	}
+	TRACE_END();
+
+	TRACE_BEGIN("barrier");
+	glMemoryBarrier(GL_ALL_BARRIER_BITS);
+	gl_check_err("Failed to dispatch kernel");
+	TRACE_END();
+}
+
+Uint64 kernel_read_iterations() {
+	if (__counter_buffer == 0) return 0;
+
+	// Copies still in flight are from before, so they count too
+	Uint64 total = 0;
+	while (__collect_readback(true, &total));
+
+	GLuint counts[KERNEL_COUNTER_SLOTS * 2];
+	glGetNamedBufferSubData(__counter_buffer, 0, sizeof(counts), counts);
+	glClearNamedBufferData(__counter_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	gl_check_err("Failed to read iteration counter");
+	return total + __sum_counters(counts);
+}
+
+Uint64 kernel_poll_iterations() {
+	if (__counter_buffer == 0) return 0;
+	if (__readback_buffer == 0) {
+		GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glCreateBuffers(1, &__readback_buffer);
+		glNamedBufferStorage(__readback_buffer, KERNEL_COUNTER_BYTES * KERNEL_COUNTER_READBACKS, NULL, flags);
+		__readback_map = glMapNamedBufferRange(__readback_buffer, 0, KERNEL_COUNTER_BYTES * KERNEL_COUNTER_READBACKS, flags);
+		gl_check_err("Failed to create iteration counter readback");
+	}
+
+	// Only waits if every copy is still in flight, which means the GPU is that many frames behind
+	Uint64 total = 0;
+	if (__readback_count == KERNEL_COUNTER_READBACKS) __collect_readback(true, &total);
+
+	// Copy the counters as they'll be after everything dispatched so far, and start them again
+	Uint32 slot = (__readback_head + __readback_count) % KERNEL_COUNTER_READBACKS;
+	glCopyNamedBufferSubData(__counter_buffer, __readback_buffer, 0, (GLintptr) slot * KERNEL_COUNTER_BYTES, KERNEL_COUNTER_BYTES);
+	glClearNamedBufferData(__counter_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	__readback_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	__readback_count++;
+	gl_check_err("Failed to copy iteration counter");
+
+	while (__collect_readback(false, &total));
+	return total;
+}
+
+void kernel_term() {
+	for (int i=0; i<KERNEL_COUNT; i++) {
+		for (int f=0; f<KERNEL_FRACTAL_COUNT; f++) {
+			for (int n=0; n<=KERNEL_MAX_POWER; n++) {
+				GLuint *program = &__kernels[i].programs[f][n];
+				if (*program == NULL_PROGRAM) continue;
+				glDeleteProgram(*program);
+				*program = NULL_PROGRAM;
+			}
+		}
+	}
+	__all_loaded = false;
+
+	if (__counter_buffer != 0) glDeleteBuffers(1, &__counter_buffer);
+	__counter_buffer = 0;
+	for (Uint32 i=0; i<__readback_count; i++) glDeleteSync(__readback_fences[(__readback_head + i) % KERNEL_COUNTER_READBACKS]);
+	__readback_head = __readback_count = 0;
+	if (__readback_buffer != 0) {
+		glUnmapNamedBuffer(__readback_buffer);
+		glDeleteBuffers(1, &__readback_buffer);
+	}
+	__readback_buffer = 0;
+	__readback_map = NULL;
+	if (__queue_buffer != 0) glDeleteBuffers(1, &__queue_buffer);
+	__queue_buffer = 0;
+	__queue_w = __queue_h = 0;
+
+	if (__prepare_program != NULL_PROGRAM) glDeleteProgram(__prepare_program);
+	__prepare_program = NULL_PROGRAM;
+	if (__live_buffers[0] != 0) glDeleteBuffers(2, __live_buffers);
+	__live_buffers[0] = __live_buffers[1] = 0;
+	__live_pixels = 0;
+	if (__pass_buffer != 0) glDeleteBuffers(1, &__pass_buffer);
+	__pass_buffer = 0;
+}
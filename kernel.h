@@ -0,0 +1,226 @@
+//	
+//	Registry of the available mandelbrot compute kernels
+//	
+//	Each kernel is a compute shader with the same interface
+//	(view window at uniform 0, iterations at uniform 1, the
+//	colour and escape images at bindings 0 and 1 and the
+//	64-bit iteration counters at buffer binding 0) but a different
+//	number format, so the view has to be uploaded differently
+//	for each one. The fixed-point and double-float kernels take
+//	their view as the centre at uniform 0 and the zoom at uniform 2.
+//	
+//	The persistent kernel is the float kernel reorganised so only
+//	enough workgroups to fill the device are launched, each pulling
+//	tiles off an atomic queue (buffer binding 3) until it's empty,
+//	rather than one workgroup being launched per pixel.
+//	
+//	The compacting kernel is also the float kernel, but run as a
+//	series of passes of KERNEL_COMPACT_PASS_ITERATIONS each over a
+//	dense list of the pixels still iterating, so lanes whose pixels
+//	escaped early don't sit idle beside ones that keep going.
+//	Survivors are compacted into the next pass's list with a prefix
+//	sum, and each pass is sized with an indirect dispatch.
+//	
+//	Every kernel iterates z^n + c for an integer power n, either as a
+//	Mandelbrot set (z and c start at the pixel) or a Julia set (z
+//	starts at the pixel and c is fixed). Each formula is built as its
+//	own variant of the kernel, with POWER and JULIA defined, so z^n is
+//	unrolled into a sequence of squarings at compile time. The fixed-
+//	point kernel only has z^2, since higher powers overflow its range.
+//	
+//	Building every variant of every kernel takes much longer than
+//	building one formula's, so only the current formula's are built up
+//	front. The interactive app builds the rest one at a time while it's
+//	idle, so switching formula soon after start-up can still stall on
+//	a compile; anything else builds variants the first time they're used.
+//	
+//	With KERNEL_AUTO, the cheapest kernel that can still resolve
+//	the pixel spacing of the view is picked for every dispatch.
+//	
+
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#include <stdbool.h>
+
+#include "gl.h"
+
+#define KERNEL_FIXPT_FRAC_BITS 28	// Fractional bits of the fixed-point kernel's numbers
+#define KERNEL_DFLOAT_BITS 48		// Mantissa bits of a double-float (a pair of floats)
+#define KERNEL_FIXPT_RANGE 4.0		// Views must stay this close to 0,0 for the fixed-point kernel
+#define KERNEL_PRECISION_MARGIN 8.0	// Smallest steps a kernel needs per pixel to count as exact
+#define KERNEL_COUNTER_SLOTS 64		// Number of pixel-iteration counters the kernels spread their atomics over
+#define KERNEL_COUNTER_BYTES (KERNEL_COUNTER_SLOTS * 8)	// Each counter is 64 bits, as a low and a high word
+#define KERNEL_COUNTER_READBACKS 4	// Copies of the counters that can be on their way back to the CPU at once
+#define KERNEL_TILE_SIZE 16			// Default width and height of the persistent kernel's tiles
+#define KERNEL_PERSISTENT_GROUPS 256	// Default workgroups launched by the persistent kernel
+#define KERNEL_PERSISTENT_GROUP_SIZE 8	// Width and height of a persistent workgroup, must match the shader
+#define KERNEL_COMPACT_PASS_ITERATIONS 64	// Iterations per pass of the compacting kernel
+#define KERNEL_COMPACT_GROUP_SIZE 64	// Pixels per workgroup of the compacting kernel, must match its shaders
+#define KERNEL_COMPACT_ROW_GROUPS 1024	// Most workgroups per row of a compacting dispatch, must match its shaders
+#define KERNEL_MAX_POWER 8			// Highest power of z the kernels can be built for
+#define KERNEL_JULIA_LOCATION 5		// Uniform location of a Julia set's c
+#define KERNEL_JULIA_MAX_C 2.0		// Furthest c can be from 0,0, so an escape radius of 2 still holds
+
+
+typedef enum {
+	KERNEL_FLOAT,
+	KERNEL_DOUBLE,
+	KERNEL_FIXPT,
+	KERNEL_DFLOAT,	// Double precision emulated with pairs of floats
+	KERNEL_PERSISTENT,	// Float precision, with persistent workgroups and a tile queue
+	KERNEL_COMPACT,		// Float precision, in passes over a compacted list of live pixels
+	KERNEL_COUNT,
+	KERNEL_AUTO,	// Pick by zoom level
+} Kernel_Id;
+
+// Which set the formula iterates for
+typedef enum {
+	KERNEL_MANDELBROT,	// z starts at c, which is the pixel
+	KERNEL_JULIA,		// z starts at the pixel, and c is fixed
+	KERNEL_FRACTAL_COUNT,
+} Kernel_Fractal;
+
+// Formula the kernels iterate: z^power + c
+typedef struct {
+	Kernel_Fractal fractal;
+	Uint32 power;		// From 2 to KERNEL_MAX_POWER
+	double julia_x;		// c of a Julia set
+	double julia_y;
+} Kernel_Formula;
+
+// Order the persistent kernel's tiles are queued in
+typedef enum {
+	KERNEL_ORDER_ROWS,			// Row by row from the top left
+	KERNEL_ORDER_MORTON,		// Along a Z-order curve, keeping neighbouring tiles close in time
+	KERNEL_ORDER_CENTRE_OUT,	// Nearest the centre first, which is usually where the expensive pixels are
+	KERNEL_ORDER_COUNT,
+} Kernel_Tile_Order;
+
+
+//	Gets the short name of a kernel (e.g. "float")
+//	
+const char *kernel_name(Kernel_Id id);
+
+//	Looks up a kernel by its short name
+//	
+//	"auto" gives KERNEL_AUTO.
+//	Returns KERNEL_COUNT if no kernel has that name.
+Kernel_Id kernel_from_name(const char *name);
+
+//	Gets the rough relative cost per iteration of a kernel (float is 1)
+//	
+int kernel_cost(Kernel_Id id);
+
+//	Gets the program of a kernel for the current formula, compiling and linking it on first use
+//	
+//	Returns NULL_PROGRAM if the kernel failed to build, or doesn't
+//	support the formula.
+GLuint kernel_program(Kernel_Id id);
+
+//	Compiles and links every kernel for the current formula up front
+//	
+//	So that switching kernels mid-zoom doesn't stall on a compile.
+void kernel_load_all();
+
+//	Compiles and links one variant of any kernel, for any formula, that hasn't been built yet
+//	
+//	Meant for idle time, so switching formula later doesn't stall.
+//	Returns false once every variant has been built (or failed to).
+bool kernel_load_next();
+
+//	Checks whether a kernel can resolve the pixels of a view
+//	
+//	Compares the pixel spacing to the smallest step the kernel's
+//	number format can take around the largest values the view
+//	will iterate, with some margin for rounding error building up.
+bool kernel_is_exact(Kernel_Id id, double screen_x, double screen_y, double zoom, GLuint width, GLuint height);
+
+//	Picks the cheapest available kernel that is exact for a view
+//	
+//	Falls back to the most precise available kernel if none are exact.
+Kernel_Id kernel_choose(double screen_x, double screen_y, double zoom, GLuint width, GLuint height);
+
+//	Checks whether a kernel could be built on this device for the current formula
+//	
+//	Loads the kernel if it hasn't been already.
+bool kernel_available(Kernel_Id id);
+
+//	Gets the short name of a fractal (e.g. "julia")
+//	
+const char *kernel_fractal_name(Kernel_Fractal fractal);
+
+//	Looks up a fractal by its short name
+//	
+//	Returns KERNEL_FRACTAL_COUNT if no fractal has that name.
+Kernel_Fractal kernel_fractal_from_name(const char *name);
+
+//	Sets the formula every kernel (and the CPU renderer) iterates
+//	
+//	Returns 1 if the power is out of range or a Julia set's c is
+//	further than KERNEL_JULIA_MAX_C from 0,0, else 0.
+int kernel_set_formula(Kernel_Formula formula);
+
+//	Checks whether a formula is one the kernels can iterate
+//	
+bool kernel_formula_valid(Kernel_Formula formula);
+
+//	Gets the formula the kernels iterate
+//	
+//	Starts off as the z^2 Mandelbrot set.
+Kernel_Formula kernel_formula();
+
+//	Gets the short name of a tile order (e.g. "morton")
+//	
+const char *kernel_order_name(Kernel_Tile_Order order);
+
+//	Looks up a tile order by its short name
+//	
+//	Returns KERNEL_ORDER_COUNT if no order has that name.
+Kernel_Tile_Order kernel_order_from_name(const char *name);
+
+//	Lists the tiles of a frame in the order the persistent kernel takes them
+//	
+//	Tiles are numbered along rows, starting from the first row of the
+//	frametex. `queue` must have room for every tile of the frame.
+//	Returns 1 if it couldn't allocate its scratch space.
+int kernel_tile_order(GLuint width, GLuint height, GLuint tile_size, Kernel_Tile_Order order, GLuint *queue);
+
+//	Configures how the persistent kernel splits up frames
+//	
+//	`groups` is how many workgroups to launch, which should be
+//	enough to fill every compute unit of the device. GL has no way
+//	to ask how many there are, so it has to be tuned by hand.
+void kernel_set_tiling(GLuint tile_size, Kernel_Tile_Order order, GLuint groups);
+
+//	Uploads the view window and iteration count in the kernel's number format
+//	
+//	The kernel's program must currently be in use.
+void kernel_set_view(Kernel_Id id, double screen_x, double screen_y, double zoom, GLuint iterations);
+
+//	Renders a view into a frametex with a kernel
+//	
+//	KERNEL_AUTO picks the kernel with `kernel_choose()`.
+//	Only issues the dispatch and barrier, so it doesn't wait for the GPU.
+void kernel_dispatch(Kernel_Id id, gl_frametex ftex, double screen_x, double screen_y, double zoom, GLuint iterations);
+
+//	Reads and resets the number of pixel-iterations performed by the kernels
+//	
+//	Counts everything dispatched since the last call (of this or
+//	`kernel_poll_iterations()`), and waits for those dispatches to finish.
+Uint64 kernel_read_iterations();
+
+//	Reads the number of pixel-iterations performed by the kernels without waiting for the GPU
+//	
+//	Queues a copy of the counters as they'll be once everything
+//	dispatched so far is done and resets them, then returns the counts
+//	of any earlier copies that have arrived since the last call. So the
+//	count lags behind by however many frames the GPU is behind, usually
+//	one, and every dispatch is still counted exactly once.
+Uint64 kernel_poll_iterations();
+
+//	Deletes the programs of any kernels that were loaded
+//	
+void kernel_term();
+
+#endif
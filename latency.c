@@ -0,0 +1,201 @@
+#include "latency.h"
+
+typedef struct {
+	double total_ms;
+	double queue_ms;
+	double render_ms;
+	double present_ms;
+	Uint32 events;
+} Latency_Sample;
+
+static const char *__kind_names[LATENCY_KIND_COUNT] = {
+	[LATENCY_PAN] = "pan",
+	[LATENCY_ZOOM] = "zoom",
+	[LATENCY_ITERATIONS] = "iterations",
+};
+
+// A frame that's been swapped to the screen, but may not be finished on the GPU yet
+typedef struct {
+	Latency_Tag tag;
+	Uint64 ts_swapped;	// When the swap returned
+} Latency_Pending;
+
+static Latency_Sample __rings[LATENCY_KIND_COUNT][LATENCY_RING_SIZE];
+static Uint32 __ring_next[LATENCY_KIND_COUNT];
+static Uint32 __ring_len[LATENCY_KIND_COUNT];
+
+static Latency_Pending __pending[LATENCY_MAX_PENDING];	// Oldest first, from `__pending_head`
+static Uint32 __pending_head = 0;
+static Uint32 __pending_count = 0;
+
+static int __cmp_double(const void *a, const void *b) {
+	double da = *(const double *) a;
+	double db = *(const double *) b;
+	return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of an already sorted array
+static double __percentile(double *sorted, Uint32 len, double pct) {
+	if (len == 0) return 0.0;
+	int index = (int) SDL_ceil(pct / 100.0 * len) - 1;
+	if (index < 0) index = 0;
+	return sorted[index];
+}
+
+// Whether a tag reflects any input
+static bool __has_input(const Latency_Tag *tag) {
+	for (int k=0; k<LATENCY_KIND_COUNT; k++) if (tag->events[k] != 0) return true;
+	return false;
+}
+
+static double __ms_between(Uint64 ts_from, Uint64 ts_to) {
+	if (ts_to <= ts_from) return 0.0;
+	return (ts_to - ts_from) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// Keeps one sample for each kind of input a frame reflects, now that it's on the screen
+static void __record(const Latency_Tag *tag, Uint64 ts_swapped, Uint64 ts_shown) {
+	for (int k=0; k<LATENCY_KIND_COUNT; k++) {
+		if (tag->events[k] == 0) continue;
+
+		__rings[k][__ring_next[k]] = (Latency_Sample){
+			.total_ms = __ms_between(tag->ts_input[k], ts_shown),
+			.queue_ms = __ms_between(tag->ts_input[k], tag->ts_begin),
+			.render_ms = __ms_between(tag->ts_begin, ts_swapped),
+			.present_ms = __ms_between(ts_swapped, ts_shown),
+			.events = tag->events[k],
+		};
+		__ring_next[k] = (__ring_next[k] + 1) % LATENCY_RING_SIZE;
+		if (__ring_len[k] < LATENCY_RING_SIZE) __ring_len[k]++;
+	}
+}
+
+// Records the oldest pending frame, once its fence has signalled or been waited on
+static void __close_oldest(Uint64 ts_shown) {
+	Latency_Pending *p = &__pending[__pending_head];
+	__record(&p->tag, p->ts_swapped, ts_shown);
+	glDeleteSync(p->tag.fence);
+	__pending_head = (__pending_head + 1) % LATENCY_MAX_PENDING;
+	__pending_count--;
+}
+
+
+const char *latency_kind_name(Latency_Kind kind) {
+	if (kind >= LATENCY_KIND_COUNT) return "(none)";
+	return __kind_names[kind];
+}
+
+void latency_input(Latency_Tag *tag, Latency_Kind kind, Uint32 event_timestamp) {
+	if (kind >= LATENCY_KIND_COUNT) return;
+
+	// Events are stamped in milliseconds, so work back from how old it is now
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint32 age_ms = SDL_GetTicks() - event_timestamp;
+	Uint64 age = (Uint64) age_ms * SDL_GetPerformanceFrequency() / 1000;
+	Uint64 ts_input = (age < now) ? now - age : 0;
+
+	if (tag->events[kind] == 0 || ts_input < tag->ts_input[kind]) tag->ts_input[kind] = ts_input;
+	tag->events[kind]++;
+}
+
+void latency_merge(Latency_Tag *into, const Latency_Tag *from) {
+	for (int k=0; k<LATENCY_KIND_COUNT; k++) {
+		if (from->events[k] == 0) continue;
+		if (into->events[k] == 0 || from->ts_input[k] < into->ts_input[k]) into->ts_input[k] = from->ts_input[k];
+		into->events[k] += from->events[k];
+	}
+}
+
+void latency_frame_begin(Latency_Tag *tag) {
+	tag->ts_begin = SDL_GetPerformanceCounter();
+	tag->fence = NULL;
+}
+
+void latency_frame_rendered(Latency_Tag *tag) {
+	if (!__has_input(tag) || tag->fence != NULL) return;
+	tag->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void latency_frame_shown(Latency_Tag *tag) {
+	if (!__has_input(tag)) return;
+	Uint64 ts_swapped = SDL_GetPerformanceCounter();
+
+	if (tag->fence == NULL) {
+		__record(tag, ts_swapped, ts_swapped);
+	} else {
+		// Only when the GPU is this far behind is it waited on
+		if (__pending_count == LATENCY_MAX_PENDING) {
+			glClientWaitSync(__pending[__pending_head].tag.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			__close_oldest(SDL_GetPerformanceCounter());
+		}
+		__pending[(__pending_head + __pending_count) % LATENCY_MAX_PENDING] = (Latency_Pending){ *tag, ts_swapped };
+		__pending_count++;
+	}
+
+	SDL_zerop(tag);
+}
+
+void latency_poll() {
+	while (__pending_count > 0) {
+		GLenum status = glClientWaitSync(__pending[__pending_head].tag.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED) return;
+		__close_oldest(SDL_GetPerformanceCounter());
+	}
+}
+
+bool latency_pending() {
+	return __pending_count > 0;
+}
+
+Latency_Stats latency_stats(Latency_Kind kind) {
+	Latency_Stats stats;
+	SDL_zero(stats);
+	if (kind >= LATENCY_KIND_COUNT) return stats;
+	Uint32 len = __ring_len[kind];
+	stats.frames = len;
+	if (len == 0) return stats;
+
+	double sorted[LATENCY_RING_SIZE];
+	Uint64 total_events = 0;
+	for (Uint32 i=0; i<len; i++) {
+		const Latency_Sample *s = &__rings[kind][i];
+		sorted[i] = s->total_ms;
+		stats.queue_ms += s->queue_ms;
+		stats.render_ms += s->render_ms;
+		stats.present_ms += s->present_ms;
+		total_events += s->events;
+		if (s->events > stats.max_events) stats.max_events = s->events;
+	}
+	SDL_qsort(sorted, len, sizeof(double), __cmp_double);
+
+	stats.p50_ms = __percentile(sorted, len, 50.0);
+	stats.p90_ms = __percentile(sorted, len, 90.0);
+	stats.p99_ms = __percentile(sorted, len, 99.0);
+	stats.max_ms = sorted[len - 1];
+	stats.queue_ms /= len;
+	stats.render_ms /= len;
+	stats.present_ms /= len;
+	stats.mean_events = (double) total_events / len;
+
+	return stats;
+}
+
+void latency_dump(FILE *f) {
+	fprintf(f, "---> Input to display latency:\n");
+	fprintf(f, "      %-10s %6s %9s %9s %9s %9s | %9s %9s %9s | %s\n",
+		"Input", "Frames", "p50 ms", "p90 ms", "p99 ms", "max ms", "queue", "render", "present", "Events/frame"
+	);
+
+	for (int k=0; k<LATENCY_KIND_COUNT; k++) {
+		Latency_Stats stats = latency_stats(k);
+		if (stats.frames == 0) {
+			fprintf(f, "      %-10s %6u %9s\n", latency_kind_name(k), 0, "-");
+			continue;
+		}
+		fprintf(f, "      %-10s %6u %9.2lf %9.2lf %9.2lf %9.2lf | %9.2lf %9.2lf %9.2lf | %.2lf (max %u)\n",
+			latency_kind_name(k), stats.frames, stats.p50_ms, stats.p90_ms, stats.p99_ms, stats.max_ms,
+			stats.queue_ms, stats.render_ms, stats.present_ms, stats.mean_events, stats.max_events
+		);
+	}
+	fflush(f);
+}
@@ -0,0 +1,111 @@
+//	
+//	Input-to-display latency telemetry
+//	
+//	What matters for a drag or a scroll is how long it takes to show
+//	up, not the frame rate. Each input that changes the view is
+//	tagged with the time its event arrived, and the tag travels with
+//	the view to the next frame that's started. Once that frame has
+//	been swapped to the screen and finished on the GPU, one latency
+//	sample is kept for each kind of input it reflects, timed from the
+//	oldest event of that kind. The GPU isn't waited on for this: a
+//	fence is put in before the swap and polled on later iterations of
+//	the render loop, so measuring doesn't serialise the CPU and GPU.
+//	
+//	Events that arrive before a frame starts are coalesced into it
+//	by merging their tags, so each sample also records how many
+//	events the frame took in.
+//	Slow frames drawn progressively count as shown once their first
+//	partial frame is on the screen.
+//	
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+
+#define LATENCY_RING_SIZE 256	// Number of recent samples kept for each kind of input
+#define LATENCY_MAX_PENDING 4	// Shown frames waiting on the GPU before the oldest is waited for
+
+
+// Kinds of input that change the view
+typedef enum {
+	LATENCY_PAN,
+	LATENCY_ZOOM,
+	LATENCY_ITERATIONS,
+	LATENCY_KIND_COUNT,
+} Latency_Kind;
+
+// Inputs a frame reflects, carried from the start of the frame until it's shown
+typedef struct {
+	Uint64 ts_input[LATENCY_KIND_COUNT];	// Performance counter time the oldest event of each kind arrived
+	Uint32 events[LATENCY_KIND_COUNT];		// Events of each kind coalesced into the frame, 0 if none
+	Uint64 ts_begin;		// When rendering started
+	GLsync fence;			// Signalled when the GPU finishes the frame
+} Latency_Tag;
+
+typedef struct {
+	Uint32 frames;			// Number of frames the stats were taken over
+	double p50_ms;			// Input to display
+	double p90_ms;
+	double p99_ms;
+	double max_ms;
+	double queue_ms;		// Mean time from the input to the frame starting
+	double render_ms;		// Mean time from the frame starting to the swap returning
+	double present_ms;		// Mean time from the swap returning to the GPU finishing the frame
+	double mean_events;		// Mean events coalesced into a frame
+	Uint32 max_events;
+} Latency_Stats;
+
+
+//	Gets the name of a kind of input, for printing
+//	
+const char *latency_kind_name(Latency_Kind kind);
+
+//	Adds an input event to the tag of the views it changes
+//	
+//	Takes the event's `timestamp` (from `SDL_GetTicks()`), so time
+//	spent queued before the event was handled counts too.
+void latency_input(Latency_Tag *tag, Latency_Kind kind, Uint32 event_timestamp);
+
+//	Adds the inputs of one tag to another, for views that were skipped over
+//	
+void latency_merge(Latency_Tag *into, const Latency_Tag *from);
+
+//	Marks the start of rendering the frame a tag belongs to
+//	
+void latency_frame_begin(Latency_Tag *tag);
+
+//	Puts in a fence after the frame's commands so far, if it reflects any input
+//	
+//	Should be called after the frame is drawn, just before swapping.
+void latency_frame_rendered(Latency_Tag *tag);
+
+//	Notes that a frame has just been swapped to the screen
+//	
+//	Its latency is recorded by `latency_poll()` once its fence has
+//	signalled. Empties the tag, so calling it again for later
+//	presentations of the same frame doesn't record anything.
+void latency_frame_shown(Latency_Tag *tag);
+
+//	Records the latency of any shown frames the GPU has since finished, without waiting
+//	
+//	Should be called every iteration of the render loop.
+void latency_poll();
+
+//	Checks whether any shown frame is still waiting on the GPU
+//	
+bool latency_pending();
+
+//	Works out the stats over the samples currently kept for a kind of input
+//	
+Latency_Stats latency_stats(Latency_Kind kind);
+
+//	Prints the stats for every kind of input to a file (e.g. stdout)
+//	
+void latency_dump(FILE *f);
+
+#endif
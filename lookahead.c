@@ -0,0 +1,183 @@
+#include "lookahead.h"
+
+typedef struct {
+	double screen_x;
+	double screen_y;
+	double zoom;
+	GLuint iterations;
+	Uint64 due_ms;	// When the frame should be shown, relative to playback start
+	GLsync fence;	// Signalled once the GPU has finished rendering the frame
+	gl_frametex ftex;
+} Lookahead_Frame;
+
+static Lookahead_Frame __frames[LOOKAHEAD_DEPTH];
+static bool __have_frametex = false;
+static Uint32 __head = 0;	// Oldest in-flight frame (next to present)
+static Uint32 __count = 0;	// Number of frames in flight
+
+static Demo_Sequence *__seq = NULL;
+static Render_Handle *__renderer = NULL;
+static Render_View __start;	// View the path starts out from
+static Uint64 __duration = 0;
+static Uint64 __next_due = 0;	// Path time of the next frame to queue
+static Uint64 __ts_start = 0;
+
+static Uint32 __presented = 0;
+static Uint32 __late = 0;
+static Uint32 __skipped = 0;	// Frames of the path that were never shown, to keep to its clock
+
+bool lookahead_is_playing = false;
+
+
+static void __create_frametexes(GLuint width, GLuint height) {
+	if (__have_frametex) {
+		if (__frames[0].ftex.w == width && __frames[0].ftex.h == height) return;
+		lookahead_term();
+	}
+	for (int i=0; i<LOOKAHEAD_DEPTH; i++) {
+		__frames[i].ftex = gl_create_frametex(width, height);
+		__frames[i].fence = NULL;
+	}
+	__have_frametex = true;
+}
+
+// Evaluates the next point on the path and queues its render
+static void __queue_frame() {
+	Lookahead_Frame *f = &__frames[(__head + __count) % LOOKAHEAD_DEPTH];
+	f->due_ms = __next_due;
+
+	demo_eval(__seq, f->due_ms, DEMO_VAR_SCREEN_X, &__start.screen_x, DEMO_BIND(f->screen_x));
+	demo_eval(__seq, f->due_ms, DEMO_VAR_SCREEN_Y, &__start.screen_y, DEMO_BIND(f->screen_y));
+	demo_eval(__seq, f->due_ms, DEMO_VAR_ZOOM, &__start.zoom, DEMO_BIND(f->zoom));
+	demo_eval(__seq, f->due_ms, DEMO_VAR_ITERS, &__start.iterations, DEMO_BIND(f->iterations));
+
+	// The GL backend only queues the frame; the others have it done by the time this returns
+	Render_View view = { f->screen_x, f->screen_y, f->zoom, f->iterations, __start.kernel, __start.colour };
+	render_to_frametex(__renderer, &view, f->ftex);
+	f->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	gl_check_err("Failed to queue lookahead frame");
+
+	__count++;
+	__next_due += LOOKAHEAD_FRAME_MS;
+}
+
+// Drops the oldest frame in flight without showing it
+static void __drop_head() {
+	Lookahead_Frame *f = &__frames[__head];
+	glDeleteSync(f->fence);
+	f->fence = NULL;
+	__head = (__head + 1) % LOOKAHEAD_DEPTH;
+	__count--;
+}
+
+
+void lookahead_play(Demo_Sequence *seq, const Render_View *start, Render_Handle *renderer, GLuint width, GLuint height) {
+	if (seq == NULL || renderer == NULL) return;
+	if (lookahead_is_playing) lookahead_stop();
+
+	__create_frametexes(width, height);
+	__seq = seq;
+	__renderer = renderer;
+	__start = *start;
+	__duration = demo_seq_duration(seq);
+	__next_due = 0;
+	__head = 0;
+	__count = 0;
+	__presented = 0;
+	__late = 0;
+	__skipped = 0;
+	__ts_start = SDL_GetTicks64();
+	lookahead_is_playing = true;
+}
+
+void lookahead_stop() {
+	if (!lookahead_is_playing) return;
+
+	// Drop anything still in flight
+	while (__count > 0) __drop_head();
+
+	// Don't let the queued frames show up in the next frame's telemetry
+	kernel_read_iterations();
+
+	Uint64 elapsed = SDL_GetTicks64() - __ts_start;
+	printf("---> Lookahead playback presented %u frames in %llu ms (%u late, %u skipped, %.2lf FPS)\n",
+		__presented, (unsigned long long) elapsed, __late, __skipped,
+		(elapsed > 0) ? (1000.0 * __presented / elapsed) : 0.0
+	);
+	fflush(stdout);
+
+	__seq = NULL;
+	__renderer = NULL;
+	lookahead_is_playing = false;
+}
+
+bool lookahead_tick(SDL_Window *window, Render_View *shown) {
+	if (!lookahead_is_playing) return false;
+
+	// Frames for points of the path that have already gone by would only be skipped, so don't render them
+	Uint64 now = SDL_GetTicks64() - __ts_start;
+	if (__count == 0 && __next_due + LOOKAHEAD_FRAME_MS <= now && __next_due <= __duration) {
+		Uint64 behind = (now - __next_due) / LOOKAHEAD_FRAME_MS;
+		__next_due += behind * LOOKAHEAD_FRAME_MS;
+		__skipped += (Uint32) behind;
+	}
+
+	// Keep the queue full, flushing so the GPU starts on new frames straight away
+	// The other backends render as they're queued, so they only queue one a tick to keep presenting on time
+	Uint32 queue_max = (render_backend(__renderer) == RENDER_BACKEND_GL) ? LOOKAHEAD_DEPTH : 1;
+	Uint32 queued = 0;
+	while (queued < queue_max && __count < LOOKAHEAD_DEPTH && __next_due <= __duration) {
+		__queue_frame();
+		queued++;
+	}
+	if (queued > 0) glFlush();
+
+	if (__count == 0) {
+		puts("---> Reached end of Demo; Stopping...");
+		lookahead_stop();
+		return false;
+	}
+
+	// When the next frame is due as well, this one is too late to be worth showing
+	now = SDL_GetTicks64() - __ts_start;
+	while (__count > 1 && now >= __frames[(__head + 1) % LOOKAHEAD_DEPTH].due_ms) {
+		__drop_head();
+		__skipped++;
+	}
+
+	// Present the oldest frame once its time has come
+	Lookahead_Frame *f = &__frames[__head];
+	if (now < f->due_ms) return false;
+	if (now >= f->due_ms + LOOKAHEAD_FRAME_MS) __late++;
+
+	glClientWaitSync(f->fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(f->fence);
+	f->fence = NULL;
+
+	glClear(GL_COLOR_BUFFER_BIT);
+	gl_draw_frametex(f->ftex);
+	gl_check_err("Failed to present lookahead frame");
+	SDL_GL_SwapWindow(window);
+
+	*shown = (Render_View){ f->screen_x, f->screen_y, f->zoom, f->iterations, __start.kernel, __start.colour };
+
+	__head = (__head + 1) % LOOKAHEAD_DEPTH;
+	__count--;
+	__presented++;
+	return true;
+}
+
+Uint32 lookahead_wait_ms() {
+	if (!lookahead_is_playing || __count == 0) return 0;
+	if (__count < LOOKAHEAD_DEPTH && __next_due <= __duration) return 0;
+	Uint64 now = SDL_GetTicks64() - __ts_start;
+	Uint64 due = __frames[__head].due_ms;
+	return (now < due) ? (Uint32)(due - now) : 0;
+}
+
+void lookahead_term() {
+	if (!__have_frametex) return;
+	lookahead_stop();
+	for (int i=0; i<LOOKAHEAD_DEPTH; i++) gl_destroy_frametex(__frames[i].ftex);
+	__have_frametex = false;
+}
@@ -0,0 +1,67 @@
+//	
+//	Lookahead ("pipelined") demo playback
+//	
+//	Since the whole camera path of a demo is known up front, frames
+//	can be evaluated and queued on the GPU ahead of when they are shown.
+//	Several frames are kept in flight at once, each in its own frametex,
+//	and are presented when their scheduled time comes up, so playback
+//	is limited by render throughput rather than per-frame latency.
+//	
+
+#ifndef LOOKAHEAD_H
+#define LOOKAHEAD_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "demo.h"
+#include "kernel.h"
+#include "colour.h"
+#include "render.h"
+
+#define LOOKAHEAD_DEPTH 4		// Number of frames kept in flight
+#define LOOKAHEAD_FRAME_MS 16	// Time between presented frames of the path
+
+
+extern bool lookahead_is_playing;
+
+
+//	Starts lookahead playback of a demo sequence
+//	
+//	The path starts out from `start`, the view when playback was asked
+//	for, and frames are rendered by `renderer` with its kernel and
+//	colouring into `width`x`height` frametexes. With the GL backend
+//	the frames are queued on the GPU and several are kept in flight.
+//	The CPU and hybrid backends render each frame as it's queued, on
+//	the render thread (spread over their worker pools), so only one
+//	is queued per `lookahead_tick()`; frames rendered ahead while
+//	others are waiting to be shown still build up the queue.
+//	Overrides any previously playing sequence.
+void lookahead_play(Demo_Sequence *seq, const Render_View *start, Render_Handle *renderer, GLuint width, GLuint height);
+
+//	Stops lookahead playback and prints a summary of how it went
+//	
+void lookahead_stop();
+
+//	Queues new frames and presents any that are due
+//	
+//	Should be called every iteration of the render loop in place of
+//	the usual redraw. The view of whichever frame was presented is
+//	written to `shown`, so the rest of the program can be kept in
+//	sync with what's on screen.
+//	Frames that fall behind are skipped rather than shown late, so
+//	playback keeps to the path's clock.
+//	Returns true if a frame was presented.
+bool lookahead_tick(SDL_Window *window, Render_View *shown);
+
+//	Gets how long the render loop can sleep before the next frame is due
+//	
+//	Returns 0 when there's work to do now, or playback isn't running.
+Uint32 lookahead_wait_ms();
+
+//	Frees the frametexes used for lookahead playback
+//	
+void lookahead_term();
+
+#endif
@@ -7,6 +7,24 @@
 
 #include "gl.h"
 #include "demo.h"
+#include "lookahead.h"
+#include "bench.h"
+#include "dist.h"
+#include "expmap.h"
+#include "batch.h"
+#include "buddha.h"
+#include "kernel.h"
+#include "colour.h"
+#include "render.h"
+#include "telemetry.h"
+#include "latency.h"
+#include "progressive.h"
+#include "prefetch.h"
+#include "depth.h"
+#include "publish.h"
+#include "heatmap.h"
+#include "trace.h"
+#include "spsc.h"
 
 
 #define SCREEN_WIDTH 1024
@@ -21,15 +39,98 @@
 #define THRESHOLD 2.0f
 
 #define DEMO_FILENAME "demo_file.bin"
-#define FPS_AVG_RANGE 10 // How many frames to average over for the framerate
+
+#define VIEW_QUEUE_SIZE 16		// Snapshots the event thread can get ahead of the render thread by
+#define FEEDBACK_QUEUE_SIZE 64
+
+// One-shot requests carried in a snapshot
+#define REQUEST_QUIT			0b00000001
+#define REQUEST_DUMP			0b00000010	// Print the telemetry
+#define REQUEST_HEATMAP_SAVE	0b00000100	// Save the next finished frame's heatmap
+#define REQUEST_LOOKAHEAD_STOP	0b00001000
+#define REQUEST_TRACE			0b00010000	// Start tracing, or stop and write the trace
+
+
+// Everything the render thread needs to draw, as of the last input handled
+typedef struct {
+	double screen_x;
+	double screen_y;
+	double zoom;
+	GLuint iterations;
+	bool auto_depth;	// Choose the iterations for every frame from a sample of the view instead
+	Kernel_Id kernel;
+	Colour_Mode colour;
+	Render_Backend backend;
+	Kernel_Formula formula;
+	bool progressive;	// Whether slow frames are drawn progressively
+	bool heatmap;
+	bool demo_playing;
+	bool fast;			// Shift is held, so the wheel takes big steps
+	int focus_x;		// Where progressive frames start from
+	int focus_y;
+	int pan_x;			// Mouse motion of the last drag, which the next one probably repeats
+	int pan_y;
+	bool redraw;		// The view changed since the last snapshot
+	Uint8 requests;		// REQUEST_* flags
+	Demo_Sequence *lookahead;	// Demo to start playing with lookahead, owned by whoever holds the snapshot
+	Latency_Tag latency;	// Inputs since the last snapshot
+} View_Snapshot;
+
+// Changes the render thread makes to the view on its own, sent back to the event thread
+typedef enum {
+	FEEDBACK_DEPTH,				// Auto depth chose the view's iterations
+	FEEDBACK_LOOKAHEAD,			// Lookahead playback presented the view
+	FEEDBACK_LOOKAHEAD_DONE,	// Lookahead playback stopped
+} Feedback_Kind;
+
+typedef struct {
+	Feedback_Kind kind;
+	Render_View view;
+} View_Feedback;
+
+// Shared by the event and render threads
+typedef struct {
+	Spsc_Queue *views;		// From the event thread to the render thread
+	Spsc_Queue *feedback;	// And back
+	SDL_sem *wake;			// Posted with every snapshot, so the render thread can sleep while idle
+	const char *publish_name;
+} Frame_Loop;
 
 
 void err_msg(const char *msg);
+static double __zoom_step(double zoom, bool zoom_in, bool fast);
+static Render_View __make_view(double screen_x, double screen_y, double zoom, GLuint iterations, Kernel_Id kernel, Colour_Mode colour);
+static GLuint __predict_depth(Pool *depth_pool, double screen_x, double screen_y, double zoom, GLuint iterations);
+static void __publish_frame(Publish_Ring *ring, const Render_View *view, gl_frametex ftex, Uint64 ts_begin);
+static void __heatmap_frame(gl_frametex ftex, GLuint iterations, bool save);
+static int __render_thread(void *data);
+static bool __take_snapshot(Spsc_Queue *views, View_Snapshot *snapshot);
 
 static SDL_Window *g_window = NULL;
 
 int main(int argc, char* args[]) {
 
+	// Non-interactive modes
+	if (argc > 1 && SDL_strcmp(args[1], "--bench") == 0) return bench_main(argc - 1, args + 1);
+	if (argc > 1 && SDL_strcmp(args[1], "--coordinator") == 0) return dist_coordinator_main(args[0], argc - 1, args + 1);
+	if (argc > 1 && SDL_strcmp(args[1], "--worker") == 0) return dist_worker_main(argc - 1, args + 1);
+	if (argc > 1 && SDL_strcmp(args[1], "--expmap") == 0) return expmap_main(argc - 1, args + 1);
+	if (argc > 1 && SDL_strcmp(args[1], "--batch") == 0) return batch_main(argc - 1, args + 1);
+	if (argc > 1 && SDL_strcmp(args[1], "--buddha") == 0) return buddha_main(argc - 1, args + 1);
+	if (argc > 1 && SDL_strcmp(args[1], "--heatmap") == 0) return heatmap_main(argc - 1, args + 1);
+
+	// Options for the interactive mode
+	const char *publish_name = NULL;
+	for (int i=1; i<argc; i++) {
+		if (SDL_strcmp(args[i], "--publish") == 0) {
+			publish_name = PUBLISH_DEFAULT_NAME;
+			if (i + 1 < argc && args[i + 1][0] != '-') publish_name = args[++i];
+		} else {
+			printf("[ERROR] Unknown option '%s'\n", args[i]);
+			return 1;
+		}
+	}
+
 	// Initialisation
 	if (SDL_Init(SDL_INIT_VIDEO) < 0) err_msg("Failed to initialise SDL");
 	g_window = SDL_CreateWindow(
@@ -41,24 +142,42 @@ int main(int argc, char* args[]) {
 	);
 	if (g_window == NULL) err_msg("Failed to create Window");
 
-	// Initialise OpenGL version 4.5
+	// Initialise OpenGL version 4.5, then hand the context over to the render thread
 	gl_init(4, 5, g_window);
-
-	// Create Program
-	GLuint program = glCreateProgram();
-	GLuint comp_shader = gl_load_shader(GL_COMPUTE_SHADER, "shaders/mandelbrot_float.comp");
-	glAttachShader(program, comp_shader);
-	gl_link_program(program);
-
-	// Create Framebuffer/Texture
-	gl_frametex frametex = gl_create_frametex(SCREEN_WIDTH, SCREEN_HEIGHT);
-	glBindImageTexture(0, frametex.tex, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
-
-	// Set up view window
+	gl_make_current(NULL);
+
+	Frame_Loop loop = {
+		.views = spsc_create(VIEW_QUEUE_SIZE, sizeof(View_Snapshot)),
+		.feedback = spsc_create(FEEDBACK_QUEUE_SIZE, sizeof(View_Feedback)),
+		.wake = SDL_CreateSemaphore(0),
+		.publish_name = publish_name,
+	};
+	if (loop.views == NULL || loop.feedback == NULL || loop.wake == NULL) err_msg("Failed to create the render thread's queues");
+	SDL_Thread *render_thread = SDL_CreateThread(__render_thread, "render", &loop);
+	if (render_thread == NULL) err_msg("Failed to start the render thread");
+
+	// Set up view window (this thread's copy is the real one, the render thread only gets snapshots)
 	double screen_x = -1.0f;
 	double screen_y = -1.0f;
 	double zoom = 32.0f;
 	GLuint iterations = 200;
+	bool auto_depth = false;	// Choose `iterations` for every frame from a sample of the view
+	Kernel_Id kernel = KERNEL_AUTO;
+	Colour_Mode colour = COLOUR_LINEAR;
+	Render_Backend backend = RENDER_BACKEND_GL;
+	Kernel_Formula formula = kernel_formula();
+
+	// Slow frames are drawn progressively, starting from the focus point
+	bool progressive_enabled = true;
+	int focus_x = SCREEN_WIDTH / 2;
+	int focus_y = SCREEN_HEIGHT / 2;
+
+	// The render thread spends idle time rendering the views likely to be asked for next
+	int pan_x = 0;	// Mouse motion of the last drag, which the next one probably repeats
+	int pan_y = 0;
+
+	// Finished frames can be shaded by what each pixel cost, and the costs saved
+	bool heatmap = false;
 
 	// Set up demo recording/playback
 	demo_bind_var(DEMO_VAR_SCREEN_X, DEMO_FLOAT, DEMO_BIND(screen_x));
@@ -66,23 +185,23 @@ int main(int argc, char* args[]) {
 	demo_bind_var(DEMO_VAR_ZOOM, DEMO_FLOAT, DEMO_BIND(zoom));
 	demo_bind_var(DEMO_VAR_ITERS, DEMO_INTEGER, DEMO_BIND(iterations));
 	Demo_Sequence *rec_demo = NULL;
+	bool lookahead_playing = false;	// The render thread is playing a copy of `rec_demo` with lookahead
 
-	// Main Loop
+	// Main Loop, which only handles input and never waits on a frame
 	bool isRunning = true;
 	bool redraw = true;
+	bool changed = true;	// Something the render thread needs to know about changed, without the view itself changing
+	Uint8 requests = 0;		// REQUEST_* flags for the next snapshot
+	Demo_Sequence *lookahead_seq = NULL;	// Demo to start playing with lookahead, handed over with the next snapshot
+	Latency_Tag latency_tag = { 0 };	// Inputs the next snapshot reflects
 	SDL_Event curr_event;
 	Uint8 input_mask = 0b00000000;
-	double avg_fps = 0.0f;
 
 	while (isRunning) {
 
-		// Handle events
-		int scode = SDL_WaitEventTimeout(&curr_event, 10);
-
-		// Clock the demo system
-		redraw |= demo_tick();
-
-		if (scode != 0) {
+		// Handle every event that's come in (waiting a little if there are none), so motion never piles up behind a slow frame
+		TRACE_BEGIN("events");
+		for (int scode = SDL_WaitEventTimeout(&curr_event, 10); scode != 0; scode = SDL_PollEvent(&curr_event)) {
 			switch (curr_event.type) {
 				case SDL_QUIT:
 					isRunning = false;
@@ -94,13 +213,21 @@ int main(int argc, char* args[]) {
 						case SDLK_LSHIFT:
 						case SDLK_RSHIFT: input_mask |= INPUT_SHIFT; break;
 						case SDLK_KP_PLUS: {
+							auto_depth = false;
 							if (iterations < 1024) iterations++;
+							latency_input(&latency_tag, LATENCY_ITERATIONS, curr_event.key.timestamp);
 							printf("Nr. of Iterations: %i\n", iterations);
 						} break;
 						case SDLK_KP_MINUS: {
+							auto_depth = false;
 							if (iterations > 0) iterations--;
+							latency_input(&latency_tag, LATENCY_ITERATIONS, curr_event.key.timestamp);
 							printf("Nr. of Iterations: %i\n", iterations);
 						} break;
+						case SDLK_KP_MULTIPLY: {
+							auto_depth = !auto_depth;
+							printf("---> Automatic iteration depth %s\n", auto_depth ? "on" : "off");
+						} break;
 						default: break;
 					}
 					fflush(stdout);
@@ -113,7 +240,58 @@ int main(int argc, char* args[]) {
 						case SDLK_ESCAPE: isRunning = false; continue;
 						case SDLK_LSHIFT:
 						case SDLK_RSHIFT: input_mask &= ~INPUT_SHIFT; break;
-						case SDLK_F5: printf("---> Average FPS over last %i frames: %4.4lf\n", FPS_AVG_RANGE, avg_fps); break;
+						case SDLK_F4: {
+							progressive_enabled = !progressive_enabled;
+							printf("---> Progressive display %s\n", progressive_enabled ? "on" : "off");
+						} break;
+						case SDLK_F5: requests |= REQUEST_DUMP; break;
+						case SDLK_F7: {
+							// Cycle through auto, then each kernel
+							if (kernel == KERNEL_AUTO) kernel = 0;
+							else if (kernel + 1 >= KERNEL_COUNT) kernel = KERNEL_AUTO;
+							else kernel++;
+							printf("---> Kernel: %s\n", kernel_name(kernel));
+						} break;
+						case SDLK_F8: {
+							colour = (colour + 1) % COLOUR_COUNT;
+							printf("---> Colouring: %s\n", colour_mode_name(colour));
+						} break;
+						case SDLK_F6: {
+							backend = (backend + 1) % RENDER_BACKEND_COUNT;
+							printf("---> Switched to the %s renderer\n", render_backend_name(backend));
+						} break;
+						case SDLK_h: {
+							if (input_mask & INPUT_SHIFT) {
+								requests |= REQUEST_HEATMAP_SAVE;
+								break;
+							}
+							heatmap = !heatmap;
+							printf("---> Cost heatmap %s\n", heatmap ? "on" : "off");
+						} break;
+						case SDLK_j:
+						case SDLK_p: {
+							// J swaps to the Julia set of the point under the mouse and back, P raises the power
+							Kernel_Formula next = formula;
+							if (kc == SDLK_j && next.fractal == KERNEL_JULIA) {
+								next.fractal = KERNEL_MANDELBROT;
+							} else if (kc == SDLK_j) {
+								next.fractal = KERNEL_JULIA;
+								next.julia_x = (focus_x - SCREEN_WIDTH / 2.0) / zoom + screen_x;
+								next.julia_y = -(focus_y - SCREEN_HEIGHT / 2.0) / zoom + screen_y;
+							} else if (input_mask & INPUT_SHIFT) {
+								next.power = (next.power > 2) ? next.power - 1 : KERNEL_MAX_POWER;
+							} else {
+								next.power = (next.power < KERNEL_MAX_POWER) ? next.power + 1 : 2;
+							}
+							if (!kernel_formula_valid(next)) {
+								printf("[WARN ] c = %.6lf%+.6lfi is too far out for a Julia set\n", next.julia_x, next.julia_y);
+								break;
+							}
+							formula = next;
+							if (formula.fractal == KERNEL_JULIA) printf("---> Formula: z^%u + c, Julia set of c = %.6lf%+.6lfi\n", formula.power, formula.julia_x, formula.julia_y);
+							else printf("---> Formula: z^%u + c, %s\n", formula.power, kernel_fractal_name(formula.fractal));
+						} break;
+						case SDLK_F3: requests |= REQUEST_TRACE; break;
 
 						// Start recording demo (deletes previous if present)
 						case SDLK_F9: {
@@ -145,9 +323,19 @@ int main(int argc, char* args[]) {
 								puts("---> No current recorded demo to play back!");
 								break;
 							}
-							if (demo_is_playing) {
+							if (demo_is_playing || lookahead_playing) {
 								puts("---> Stopped demo playback");
 								demo_stop();
+								requests |= REQUEST_LOOKAHEAD_STOP;
+								lookahead_playing = false;
+								if (lookahead_seq != NULL) demo_destroy_seq(lookahead_seq);
+								lookahead_seq = NULL;
+							} else if (input_mask & INPUT_SHIFT) {
+								// The render thread plays its own copy, so this one can still be edited
+								puts("---> Playing Demo with lookahead...");
+								if (lookahead_seq != NULL) demo_destroy_seq(lookahead_seq);
+								lookahead_seq = demo_copy_seq(rec_demo);
+								lookahead_playing = true;
 							} else {
 								puts("---> Playing Demo...");
 								demo_play(rec_demo);
@@ -161,6 +349,8 @@ int main(int argc, char* args[]) {
 						case SDLK_F1: {
 							if (rec_demo != NULL) {
 								if (demo_is_playing) demo_stop();
+								requests |= REQUEST_LOOKAHEAD_STOP;
+								lookahead_playing = false;
 								demo_destroy_seq(rec_demo);
 							}
 							printf("---> Read Demo from '%s'\n", DEMO_FILENAME);
@@ -179,82 +369,499 @@ int main(int argc, char* args[]) {
 				} break;
 
 				case SDL_MOUSEBUTTONDOWN: input_mask |= INPUT_MOUSE; break;
-				case SDL_MOUSEBUTTONUP: input_mask &= ~INPUT_MOUSE; break;
+				case SDL_MOUSEBUTTONUP: {
+					input_mask &= ~INPUT_MOUSE;
+					pan_x = 0;
+					pan_y = 0;
+					changed = true;
+				} break;
 
 				case SDL_MOUSEMOTION: {
+					focus_x = curr_event.motion.x;
+					focus_y = curr_event.motion.y;
+					changed = true;
 					if ((input_mask & INPUT_MOUSE) == 0) break;
 
 					double rel_x = (1/zoom) * curr_event.motion.xrel;
 					double rel_y = -(1/zoom) * curr_event.motion.yrel;
 					screen_x -= rel_x;
 					screen_y -= rel_y;
+					pan_x = curr_event.motion.xrel;
+					pan_y = curr_event.motion.yrel;
+					latency_input(&latency_tag, LATENCY_PAN, curr_event.motion.timestamp);
 					redraw = true;
 				} break;
 
 				case SDL_MOUSEWHEEL: {
-					double factor = ZOOM_FACTOR;
-					if (input_mask & INPUT_SHIFT) factor = ZOOM_FACTOR_FAST;
+					zoom = __zoom_step(zoom, curr_event.wheel.y >= 0, input_mask & INPUT_SHIFT);
 
-					if (curr_event.wheel.y < 0) {
-						zoom *= 1/factor;
-					} else {
-						zoom *= factor;
-					}
-
-					if (zoom < 1) zoom = 1;
+					// Zooming is about the centre, so that's where the detail changes most
+					focus_x = SCREEN_WIDTH / 2;
+					focus_y = SCREEN_HEIGHT / 2;
+					latency_input(&latency_tag, LATENCY_ZOOM, curr_event.wheel.timestamp);
 					redraw = true;
 				} break;
 			}
 		}
+		TRACE_END();
+
+		// Clock the demo system
+		TRACE_BEGIN("demo_tick");
+		redraw |= demo_tick();
+		TRACE_END();
+
+		// Keep up with the changes the render thread made to the view itself
+		View_Feedback feedback;
+		while (spsc_pop(loop.feedback, &feedback)) {
+			if (feedback.kind == FEEDBACK_DEPTH && auto_depth) {
+				iterations = feedback.view.iterations;
+			} else if (feedback.kind == FEEDBACK_LOOKAHEAD) {
+				screen_x = feedback.view.screen_x;
+				screen_y = feedback.view.screen_y;
+				zoom = feedback.view.zoom;
+				iterations = feedback.view.iterations;
+			} else if (feedback.kind == FEEDBACK_LOOKAHEAD_DONE) {
+				lookahead_playing = false;
+			}
+		}
+
+		// Hand the newest view over; if the render thread is still busy, it's tried again with everything since folded in
+		if (isRunning && (redraw || changed || requests != 0 || lookahead_seq != NULL)) {
+			View_Snapshot snapshot = {
+				.screen_x = screen_x,
+				.screen_y = screen_y,
+				.zoom = zoom,
+				.iterations = iterations,
+				.auto_depth = auto_depth,
+				.kernel = kernel,
+				.colour = colour,
+				.backend = backend,
+				.formula = formula,
+				.progressive = progressive_enabled,
+				.heatmap = heatmap,
+				.demo_playing = demo_is_playing,
+				.fast = input_mask & INPUT_SHIFT,
+				.focus_x = focus_x,
+				.focus_y = focus_y,
+				.pan_x = pan_x,
+				.pan_y = pan_y,
+				.redraw = redraw,
+				.requests = requests,
+				.lookahead = lookahead_seq,
+				.latency = latency_tag,
+			};
+			if (spsc_push(loop.views, &snapshot)) {
+				SDL_SemPost(loop.wake);
+				redraw = false;
+				changed = false;
+				requests = 0;
+				lookahead_seq = NULL;
+				SDL_zero(latency_tag);
+			}
+		}
+	}
+
+	// Quitting has to get through, so wait for room if the render thread is behind
+	View_Snapshot quit = { .requests = REQUEST_QUIT };
+	while (!spsc_push(loop.views, &quit)) SDL_Delay(1);
+	SDL_SemPost(loop.wake);
+	SDL_WaitThread(render_thread, NULL);
+
+	// Termination
+	if (lookahead_seq != NULL) demo_destroy_seq(lookahead_seq);
+	if (rec_demo != NULL) demo_destroy_seq(rec_demo);
+	spsc_destroy(loop.views);
+	spsc_destroy(loop.feedback);
+	SDL_DestroySemaphore(loop.wake);
+	trace_term();
+	gl_term();
+	SDL_DestroyWindow(g_window);
+	SDL_Quit();
+	return 0;
+}
+
+// Owns the GL context and draws whatever view the event thread last sent
+static int __render_thread(void *data) {
+	Frame_Loop *loop = (Frame_Loop *) data;
+	gl_make_current(g_window);
+
+	// Create Renderers (the CPU one is only started when it's first used)
+	Kernel_Id active_kernel = KERNEL_COUNT;
+	kernel_load_all();
+	bool compiling = true;	// Variants for other formulas are still being built in idle time
+	Render_Handle *renderers[RENDER_BACKEND_COUNT] = { NULL };
+	renderers[RENDER_BACKEND_GL] = render_create(RENDER_BACKEND_GL);
+
+	// Create Framebuffer/Texture
+	gl_frametex frametex = gl_create_frametex(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	// Slow frames are drawn progressively, starting from the focus point
+	Progressive *progressive = progressive_create(SCREEN_WIDTH, SCREEN_HEIGHT);
+	double last_frame_ms = 0.0;
+
+	// Idle time is spent rendering the views likely to be asked for next
+	Prefetch *prefetch = prefetch_create(SCREEN_WIDTH, SCREEN_HEIGHT);
+	bool predicted = false;	// Whether the views after the current one have been suggested yet
+
+	// Finished frames can be published for other processes to read
+	Publish_Ring *ring = NULL;
+	if (loop->publish_name != NULL) {
+		ring = publish_create(loop->publish_name, SCREEN_WIDTH, SCREEN_HEIGHT);
+		if (ring != NULL) printf("---> Publishing frames to shared memory '%s'\n", loop->publish_name);
+	}
+	Render_View shown_view = { 0 };	// The view of the frame being drawn, for publishing once it's finished
+
+	Pool *depth_pool = NULL;	// Only started when auto depth is first turned on
+	bool heatmap_save = false;	// Save the next finished frame's heatmap
+	Demo_Sequence *lookahead_seq = NULL;	// Demo being played with lookahead
+	Latency_Tag pending_latency = { 0 };	// Inputs reflected by the next frame to be started
+	Latency_Tag latency_tag = { 0 };	// Inputs the frame being drawn reflects, until it's first shown
+
+	// Nothing is drawn until the first view comes in
+	View_Snapshot state;
+	while (!__take_snapshot(loop->views, &state)) SDL_SemWaitTimeout(loop->wake, 10);
+	bool running = (state.requests & REQUEST_QUIT) == 0;
+	bool redraw = true;
+	bool fresh = true;	// `state` was just taken
+
+	while (running) {
+		TRACE_BEGIN("loop");
+		telemetry_tick();
+
+		// Act on everything asked for since the last view
+		if (fresh) {
+			latency_merge(&pending_latency, &state.latency);
+			redraw |= state.redraw;
+
+			Kernel_Formula formula = kernel_formula();
+			if (formula.fractal != state.formula.fractal || formula.power != state.formula.power
+				|| formula.julia_x != state.formula.julia_x || formula.julia_y != state.formula.julia_y) {
+				kernel_set_formula(state.formula);
+				prefetch_invalidate(prefetch);
+			}
+			if (renderers[state.backend] == NULL) renderers[state.backend] = render_create(state.backend);
+			if (state.auto_depth && depth_pool == NULL) depth_pool = pool_create(0);
+
+			if (state.requests & REQUEST_DUMP) {
+				telemetry_dump(stdout);
+				latency_dump(stdout);
+				progressive_dump(progressive, stdout);
+				prefetch_dump(prefetch, stdout);
+				if (state.backend == RENDER_BACKEND_HYBRID) render_dump_split(renderers[state.backend], stdout);
+				if (state.backend != RENDER_BACKEND_GL) render_dump_partition(renderers[state.backend], stdout);
+			}
+			if (state.requests & REQUEST_HEATMAP_SAVE) heatmap_save = true;
+			if (state.requests & REQUEST_TRACE) {
+				// Only ever started and stopped on this thread
+				if (!SDL_AtomicGet(&trace_enabled)) {
+					trace_start();
+					puts("---> Started tracing");
+				} else if (trace_stop(TRACE_FILENAME) == 0) {
+					printf("---> Wrote trace to '%s'\n", TRACE_FILENAME);
+				}
+				fflush(stdout);
+			}
+			if (state.requests & REQUEST_LOOKAHEAD_STOP) {
+				// The event thread already knows, so only playback ending on its own is fed back
+				lookahead_stop();
+				if (lookahead_seq != NULL) demo_destroy_seq(lookahead_seq);
+				lookahead_seq = NULL;
+			}
+			if (state.lookahead != NULL) {
+				// Starts from the view as of the snapshot, not the event thread's live one
+				Render_View start = { state.screen_x, state.screen_y, state.zoom, state.iterations, state.kernel, state.colour };
+				lookahead_play(state.lookahead, &start, renderers[state.backend], SCREEN_WIDTH, SCREEN_HEIGHT);
+				if (lookahead_seq != NULL) demo_destroy_seq(lookahead_seq);
+				lookahead_seq = state.lookahead;
+			}
+		}
+
+		// Demo playback with lookahead takes over the screen
+		if (lookahead_is_playing) {
+			progressive_cancel(progressive);
+			SDL_zero(pending_latency);
+			TRACE_BEGIN("lookahead_tick");
+			View_Feedback feedback = { .kind = FEEDBACK_LOOKAHEAD };
+			if (lookahead_tick(g_window, &feedback.view)) spsc_push(loop->feedback, &feedback);
+			TRACE_END();
+		}
+		if (lookahead_seq != NULL && !lookahead_is_playing) {
+			View_Feedback feedback = { .kind = FEEDBACK_LOOKAHEAD_DONE };
+			spsc_push(loop->feedback, &feedback);
+			demo_destroy_seq(lookahead_seq);
+			lookahead_seq = NULL;
+		}
+
+		Render_Backend backend = state.backend;
+		if (redraw && !lookahead_is_playing) {
+			TRACE_BEGIN("frame");
 
-		if (redraw) {
 			// Clear Screen
 			glClear(GL_COLOR_BUFFER_BIT);
 			gl_check_err("Failed to clear colour buffer");
 
-			// Start rendering
-			Uint64 start = SDL_GetTicks64();
-			glUseProgram(program);
+			// Start rendering, taking the inputs this frame reflects with it
+			Uint64 ts_frame = telemetry_frame_begin();
+			latency_tag = pending_latency;
+			SDL_zero(pending_latency);
+			latency_frame_begin(&latency_tag);
+			GLuint iterations = state.iterations;
+			if (state.auto_depth) {
+				TRACE_BEGIN("depth");
+				Depth_Result depth = depth_choose(depth_pool, state.screen_x, state.screen_y, state.zoom, SCREEN_WIDTH, SCREEN_HEIGHT);
+				iterations = depth.iterations;
+				depth_print(&depth, stdout);
+				fflush(stdout);
+				View_Feedback feedback = { .kind = FEEDBACK_DEPTH };
+				feedback.view.iterations = iterations;
+				spsc_push(loop->feedback, &feedback);
+				TRACE_END();
+			}
+			// Pick the precision tier here, so changes can be reported
+			Render_View view = __make_view(state.screen_x, state.screen_y, state.zoom, iterations, state.kernel, state.colour);
+			if (view.kernel != active_kernel && backend != RENDER_BACKEND_CPU) {
+				printf("---> Rendering with the %s kernel\n", kernel_name(view.kernel));
+				fflush(stdout);
+			}
+			active_kernel = view.kernel;
+			shown_view = view;
+
+			// Frames rendered ahead of time don't count towards the throughput or the progressive threshold
+			bool cached = prefetch_take(prefetch, &view, frametex);
+			if (!cached && state.progressive && last_frame_ms > PROGRESSIVE_THRESHOLD_MS) {
+				// Restarts from the preview, dropping any tiles left from the last frame
+				progressive_begin(progressive, renderers[backend], &view, frametex, state.focus_x, state.focus_y);
+			} else {
+				progressive_cancel(progressive);
+				Uint64 pixel_iters = 0;
+				if (!cached) {
+					render_to_frametex(renderers[backend], &view, frametex);
+					pixel_iters = render_last_iterations(renderers[backend]);
+				}
+				if (state.heatmap || heatmap_save) {
+					__heatmap_frame(frametex, view.iterations, heatmap_save);
+					heatmap_save = false;
+				}
+
+				TRACE_BEGIN("blit");
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, frametex.tex);
+				gl_draw_frametex(frametex);
+				gl_check_err("Failed to call compute shader");
+				TRACE_END();
+
+				// Done
+				TRACE_BEGIN("swap");
+				latency_frame_rendered(&latency_tag);
+				glUseProgram(NULL_PROGRAM);
+				SDL_GL_SwapWindow(g_window);
+				latency_frame_shown(&latency_tag);
+				TRACE_END();
+				telemetry_frame_end(ts_frame, pixel_iters);
+				if (ring != NULL) __publish_frame(ring, &view, frametex, ts_frame);
+				if (!cached) last_frame_ms = (SDL_GetPerformanceCounter() - ts_frame) * 1000.0 / SDL_GetPerformanceFrequency();
+			}
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, frametex.tex);
-			gl_check_err("Failed draw setup");
+			redraw = false;
+			predicted = false;
+			TRACE_END();
+		}
 
-			glUniform3f(0, (float) screen_x, (float) screen_y, (float) zoom);
-			glUniform1ui(1, iterations);
-			gl_check_err("Failed uniform");
-			glDispatchCompute(SCREEN_WIDTH, SCREEN_HEIGHT, 1);
-			glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		// Present whatever the progressive frame has got to
+		if (progressive_active(progressive)) {
+			TRACE_BEGIN("progressive");
+			bool done = progressive_step(progressive);
+			if (done && (state.heatmap || heatmap_save)) {
+				__heatmap_frame(frametex, shown_view.iterations, heatmap_save);
+				heatmap_save = false;
+			}
 
+			TRACE_BEGIN("blit");
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, frametex.tex);
 			gl_draw_frametex(frametex);
-			gl_check_err("Failed to call compute shader");
+			gl_check_err("Failed to draw progressive frame");
+			TRACE_END();
 
-			// Done
+			// The first partial frame is the first sight of the input
+			TRACE_BEGIN("swap");
+			latency_frame_rendered(&latency_tag);
 			glUseProgram(NULL_PROGRAM);
 			SDL_GL_SwapWindow(g_window);
-			
-			// Get Render time and add to running average
-			Uint64 end = SDL_GetTicks64();
-			if (end > start) {
-				double time = end - start;
-				double fps = 1000.0f / time;
-				avg_fps -= avg_fps / FPS_AVG_RANGE;
-				avg_fps += fps / FPS_AVG_RANGE;
+			latency_frame_shown(&latency_tag);
+			TRACE_END();
+			progressive_presented(progressive);
+
+			// The whole frame counts as one for the telemetry
+			if (done) {
+				Progressive_Stats stats = progressive_stats(progressive);
+				telemetry_frame_end(stats.ts_begin, stats.pixel_iters);
+				last_frame_ms = stats.frame_ms;
+				if (ring != NULL) __publish_frame(ring, &shown_view, frametex, stats.ts_begin);
 			}
+			TRACE_END();
+		}
 
-			redraw = false;
+		// Nothing else to do, so render ahead: a pan in progress probably carries on, else the wheel turns
+		else if (!fresh && !redraw && !lookahead_is_playing && !state.demo_playing) {
+			if (!predicted) {
+				Pool *pool = state.auto_depth ? depth_pool : NULL;
+				Prefetch_Candidate candidates[PREFETCH_MAX_CANDIDATES];
+				Uint32 count = 0;
+				if (state.pan_x != 0 || state.pan_y != 0) {
+					double next_x = state.screen_x - (1/state.zoom) * state.pan_x;
+					double next_y = state.screen_y + (1/state.zoom) * state.pan_y;
+					GLuint next_iters = __predict_depth(pool, next_x, next_y, state.zoom, state.iterations);
+					candidates[count++] = (Prefetch_Candidate){ __make_view(next_x, next_y, state.zoom, next_iters, state.kernel, state.colour), PREFETCH_PAN };
+				}
+				double zoom_in = __zoom_step(state.zoom, true, state.fast);
+				double zoom_out = __zoom_step(state.zoom, false, state.fast);
+				GLuint in_iters = __predict_depth(pool, state.screen_x, state.screen_y, zoom_in, state.iterations);
+				GLuint out_iters = __predict_depth(pool, state.screen_x, state.screen_y, zoom_out, state.iterations);
+				candidates[count++] = (Prefetch_Candidate){ __make_view(state.screen_x, state.screen_y, zoom_in, in_iters, state.kernel, state.colour), PREFETCH_ZOOM_IN };
+				candidates[count++] = (Prefetch_Candidate){ __make_view(state.screen_x, state.screen_y, zoom_out, out_iters, state.kernel, state.colour), PREFETCH_ZOOM_OUT };
+				prefetch_suggest(prefetch, candidates, count);
+				predicted = true;
+			}
+
+			if (prefetch_pending(prefetch)) {
+				TRACE_BEGIN("prefetch");
+				prefetch_step(prefetch, renderers[backend]);
+				TRACE_END();
+			} else if (compiling) {
+				// The other formulas' kernels, so J and P don't stall on a compile later
+				TRACE_BEGIN("compile");
+				compiling = kernel_load_next();
+				TRACE_END();
+			}
 		}
 
+		TRACE_END();
+
+		// Shown frames still on the GPU are checked on often, so their latency is measured closely
+		latency_poll();
+
+		// Take the newest view, sleeping until one comes in if there's nothing left to do
+		bool busy = redraw || progressive_active(progressive) || (!predicted && !state.demo_playing) || prefetch_pending(prefetch) || (compiling && !lookahead_is_playing && !state.demo_playing);
+		if (lookahead_is_playing) {
+			// Frames in flight are left to the GPU until the next one is due
+			Uint32 wait = lookahead_wait_ms();
+			if (wait > 0) SDL_SemWaitTimeout(loop->wake, wait);
+		}
+		else if (!busy) SDL_SemWaitTimeout(loop->wake, latency_pending() ? 1 : 10);
+		View_Snapshot next;
+		fresh = __take_snapshot(loop->views, &next);
+		if (fresh) {
+			running = (next.requests & REQUEST_QUIT) == 0;
+			if (next.pan_x != state.pan_x || next.pan_y != state.pan_y) predicted = false;
+			state = next;
+		}
 	}
 
 	// Termination
-	gl_term();
-	SDL_DestroyWindow(g_window);
-	SDL_Quit();
+	if (SDL_AtomicGet(&trace_enabled)) trace_stop(TRACE_FILENAME);
+	lookahead_stop();
+	if (lookahead_seq != NULL) demo_destroy_seq(lookahead_seq);
+	if (state.lookahead != NULL) demo_destroy_seq(state.lookahead);
+	lookahead_term();
+	progressive_destroy(progressive);
+	prefetch_destroy(prefetch);
+	pool_destroy(depth_pool);
+	publish_close(ring);
+	for (int i=0; i<RENDER_BACKEND_COUNT; i++) render_destroy(renderers[i]);
+	colour_term();
+	heatmap_term();
+	kernel_term();
+	gl_make_current(NULL);
 	return 0;
 }
 
+// Takes the newest snapshot off the queue, folding the one-shot requests and inputs of any older ones into it
+static bool __take_snapshot(Spsc_Queue *views, View_Snapshot *snapshot) {
+	View_Snapshot next;
+	if (!spsc_pop(views, snapshot)) return false;
+
+	while (spsc_pop(views, &next)) {
+		// A demo that was never started is dropped if it's been replaced or stopped since. Within one
+		// snapshot a demo is always queued after the stop, so only the newer snapshot's own stop counts
+		if (next.lookahead == NULL && (next.requests & REQUEST_LOOKAHEAD_STOP) == 0) next.lookahead = snapshot->lookahead;
+		else if (snapshot->lookahead != NULL) demo_destroy_seq(snapshot->lookahead);
+
+		next.redraw |= snapshot->redraw;
+		next.requests |= snapshot->requests;
+		latency_merge(&next.latency, &snapshot->latency);
+		*snapshot = next;
+	}
+	return true;
+}
+
 void err_msg(const char *msg) {
 	printf("[ERROR] %s: %s\n", msg, SDL_GetError());
 	exit(1);
 }
+
+// Zooms in or out one step of the mouse wheel, about the centre of the view
+static double __zoom_step(double zoom, bool zoom_in, bool fast) {
+	double factor = ZOOM_FACTOR;
+	if (fast) factor = ZOOM_FACTOR_FAST;
+
+	if (zoom_in) {
+		zoom *= factor;
+	} else {
+		zoom *= 1/factor;
+	}
+
+	if (zoom < 1) zoom = 1;
+	return zoom;
+}
+
+// Fills in a view to render, choosing the kernel if it's left to KERNEL_AUTO
+static Render_View __make_view(double screen_x, double screen_y, double zoom, GLuint iterations, Kernel_Id kernel, Colour_Mode colour) {
+	if (kernel == KERNEL_AUTO) kernel = kernel_choose(screen_x, screen_y, zoom, SCREEN_WIDTH, SCREEN_HEIGHT);
+	return (Render_View){ screen_x, screen_y, zoom, iterations, kernel, colour };
+}
+
+// Gets the iteration depth a view will be rendered with: chosen from a sample if auto depth is on (`depth_pool` isn't NULL)
+static GLuint __predict_depth(Pool *depth_pool, double screen_x, double screen_y, double zoom, GLuint iterations) {
+	if (depth_pool == NULL) return iterations;
+	return depth_choose(depth_pool, screen_x, screen_y, zoom, SCREEN_WIDTH, SCREEN_HEIGHT).iterations;
+}
+
+// Reads a finished frame back straight into the next slot of the shared memory ring
+static void __publish_frame(Publish_Ring *ring, const Render_View *view, gl_frametex ftex, Uint64 ts_begin) {
+	TRACE_BEGIN("publish");
+	Publish_Slot *slot = publish_begin(ring);
+	slot->ts_begin = ts_begin;
+	slot->screen_x = view->screen_x;
+	slot->screen_y = view->screen_y;
+	slot->zoom = view->zoom;
+	slot->iterations = view->iterations;
+	slot->kernel = view->kernel;
+	slot->colour = view->colour;
+
+	GLsizei bytes = ftex.w * ftex.h * 4;
+	glGetTextureImage(ftex.tex, 0, GL_RGBA, GL_UNSIGNED_BYTE, bytes, publish_colour(ring, slot));
+	glGetTextureImage(ftex.escape, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, bytes, publish_escape(ring, slot));
+	gl_check_err("Failed to read back published frame");
+	publish_end(ring, slot);
+	TRACE_END();
+}
+
+// Shades a finished frame by what each pixel cost, printing the imbalance and saving the heatmap if asked
+static void __heatmap_frame(gl_frametex ftex, GLuint iterations, bool save) {
+	Heatmap_Stats stats;
+	if (heatmap_read(ftex, iterations, KERNEL_TILE_SIZE, &stats) != 0) {
+		puts("[ERROR] Failed to analyse frame costs");
+		return;
+	}
+	heatmap_print(&stats, stdout);
+	heatmap_apply(ftex, &stats);
+
+	if (save) {
+		if (heatmap_save_image(ftex, HEATMAP_IMAGE_FILENAME) != 0) printf("[ERROR] Failed to write '%s'\n", HEATMAP_IMAGE_FILENAME);
+		else if (heatmap_save_tiles(&stats, HEATMAP_TILES_FILENAME) != 0) printf("[ERROR] Failed to write '%s'\n", HEATMAP_TILES_FILENAME);
+		else printf("---> Wrote heatmap to '%s' and tile costs to '%s'\n", HEATMAP_IMAGE_FILENAME, HEATMAP_TILES_FILENAME);
+	}
+	fflush(stdout);
+	heatmap_free(&stats);
+}
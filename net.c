@@ -0,0 +1,230 @@
+#include "net.h"
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0	// Only Linux has it; elsewhere SIGPIPE is ignored in net_init()
+#endif
+
+#define NET_MAX_HOST 256
+#define NET_BACKLOG 64
+
+// Splits "host:port" (or just "port") into its parts
+static void __split_address(const char *address, char *host, const char **port) {
+	const char *colon = SDL_strrchr(address, ':');
+	if (colon == NULL) {
+		host[0] = '\0';
+		*port = address;
+		return;
+	}
+
+	size_t len = SDL_min((size_t)(colon - address), NET_MAX_HOST - 1);
+	SDL_memcpy(host, address, len);
+	host[len] = '\0';
+	*port = colon + 1;
+}
+
+#ifndef _WIN32
+// Fills in a Unix socket address, returning false if the path is too long
+static bool __unix_address(const char *address, struct sockaddr_un *addr) {
+	const char *path = address + SDL_strlen(NET_UNIX_PREFIX);
+	if (SDL_strlen(path) >= sizeof(addr->sun_path)) return false;
+
+	SDL_zerop(addr);
+	addr->sun_family = AF_UNIX;
+	SDL_strlcpy(addr->sun_path, path, sizeof(addr->sun_path));
+	return true;
+}
+#endif
+
+static bool __is_unix(const char *address) {
+	return SDL_strncmp(address, NET_UNIX_PREFIX, SDL_strlen(NET_UNIX_PREFIX)) == 0;
+}
+
+// Opens a TCP socket for an address, either binding or connecting it
+static Net_Socket __open_tcp(const char *address, bool listening) {
+	char host[NET_MAX_HOST];
+	const char *port;
+	__split_address(address, host, &port);
+
+	struct addrinfo hints, *info = NULL;
+	SDL_zero(hints);
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (listening) hints.ai_flags = AI_PASSIVE;
+	if (getaddrinfo(host[0] != '\0' ? host : NULL, port, &hints, &info) != 0) {
+		printf("[ERROR] Couldn't resolve address '%s'\n", address);
+		return NET_INVALID;
+	}
+
+	Net_Socket s = NET_INVALID;
+	for (struct addrinfo *ai = info; ai != NULL; ai = ai->ai_next) {
+		s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (s == NET_INVALID) continue;
+
+		int yes = 1;
+		if (listening) {
+			setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char *) &yes, sizeof(yes));
+			if (bind(s, ai->ai_addr, ai->ai_addrlen) == 0 && listen(s, NET_BACKLOG) == 0) break;
+		} else {
+			// Jobs and results are single messages, so don't hold them back
+			setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *) &yes, sizeof(yes));
+			if (connect(s, ai->ai_addr, ai->ai_addrlen) == 0) break;
+		}
+		net_close(s);
+		s = NET_INVALID;
+	}
+
+	freeaddrinfo(info);
+	return s;
+}
+
+// Opens a Unix domain socket, either binding or connecting it
+static Net_Socket __open_unix(const char *address, bool listening) {
+#ifdef _WIN32
+	printf("[ERROR] Unix sockets aren't supported on this platform ('%s')\n", address);
+	return NET_INVALID;
+#else
+	struct sockaddr_un addr;
+	if (!__unix_address(address, &addr)) {
+		printf("[ERROR] Socket path too long ('%s')\n", address);
+		return NET_INVALID;
+	}
+
+	Net_Socket s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s == NET_INVALID) return NET_INVALID;
+
+	int result;
+	if (listening) {
+		unlink(addr.sun_path);	// Left over from a previous run
+		result = bind(s, (struct sockaddr *) &addr, sizeof(addr));
+		if (result == 0) result = listen(s, NET_BACKLOG);
+	} else {
+		result = connect(s, (struct sockaddr *) &addr, sizeof(addr));
+	}
+
+	if (result != 0) {
+		net_close(s);
+		return NET_INVALID;
+	}
+	return s;
+#endif
+}
+
+
+int net_init() {
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+		puts("[ERROR] Failed to start Winsock");
+		return 1;
+	}
+#else
+	// A worker dying mid-send shouldn't take the coordinator down with it
+	signal(SIGPIPE, SIG_IGN);
+#endif
+	return 0;
+}
+
+void net_term() {
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+Net_Socket net_listen(const char *address) {
+	if (__is_unix(address)) return __open_unix(address, true);
+	return __open_tcp(address, true);
+}
+
+Net_Socket net_accept(Net_Socket listener) {
+	Net_Socket s = accept(listener, NULL, NULL);
+	if (s == NET_INVALID) return NET_INVALID;
+
+	int yes = 1;
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char *) &yes, sizeof(yes));	// Fails harmlessly on Unix sockets
+	return s;
+}
+
+Net_Socket net_connect(const char *address) {
+	if (__is_unix(address)) return __open_unix(address, false);
+	return __open_tcp(address, false);
+}
+
+int net_send_all(Net_Socket s, const void *data, size_t size) {
+	const char *p = (const char *) data;
+	while (size > 0) {
+		int chunk = (int) SDL_min(size, (size_t) SDL_MAX_SINT32);
+		int sent = send(s, p, chunk, MSG_NOSIGNAL);
+		if (sent <= 0) return 1;
+		p += sent;
+		size -= sent;
+	}
+	return 0;
+}
+
+int net_recv_all(Net_Socket s, void *data, size_t size) {
+	char *p = (char *) data;
+	while (size > 0) {
+		int chunk = (int) SDL_min(size, (size_t) SDL_MAX_SINT32);
+		int got = recv(s, p, chunk, 0);
+		if (got <= 0) return 1;
+		p += got;
+		size -= got;
+	}
+	return 0;
+}
+
+void net_set_timeout(Net_Socket s, Uint32 timeout_ms) {
+#ifdef _WIN32
+	DWORD tv = timeout_ms;
+#else
+	struct timeval tv;
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *) &tv, sizeof(tv));
+}
+
+int net_wait(const Net_Socket *sockets, int count, Uint32 timeout_ms, bool *readable) {
+	fd_set set;
+	FD_ZERO(&set);
+	Net_Socket highest = 0;
+	for (int i=0; i<count; i++) {
+		readable[i] = false;
+		if (sockets[i] == NET_INVALID) continue;
+		FD_SET(sockets[i], &set);
+		if (sockets[i] > highest) highest = sockets[i];
+	}
+
+	struct timeval tv;
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = (timeout_ms % 1000) * 1000;
+	int ready = select((int) highest + 1, &set, NULL, NULL, &tv);
+	if (ready <= 0) return ready;
+
+	for (int i=0; i<count; i++) {
+		if (sockets[i] != NET_INVALID && FD_ISSET(sockets[i], &set)) readable[i] = true;
+	}
+	return ready;
+}
+
+void net_close(Net_Socket s) {
+	if (s == NET_INVALID) return;
+#ifdef _WIN32
+	closesocket(s);
+#else
+	close(s);
+#endif
+}
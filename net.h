@@ -0,0 +1,80 @@
+//	
+//	Minimal socket layer for the distributed renderer
+//	
+//	Wraps BSD sockets and Winsock just enough for blocking streams
+//	over TCP ("host:port", or just "port" to listen on every
+//	interface) or, on POSIX systems, Unix domain sockets
+//	("unix:/path/to/socket").
+//	
+
+#ifndef NET_H
+#define NET_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#define NET_UNIX_PREFIX "unix:"
+
+#ifdef _WIN32
+typedef SOCKET Net_Socket;
+#define NET_INVALID INVALID_SOCKET
+#else
+typedef int Net_Socket;
+#define NET_INVALID (-1)
+#endif
+
+
+//	Starts up the socket library (only does anything on Windows)
+//	
+//	Returns 0 on success, 1 otherwise.
+int net_init();
+
+//	Shuts down the socket library
+//	
+void net_term();
+
+//	Opens a socket listening for connections on an address
+//	
+//	Returns NET_INVALID on error.
+Net_Socket net_listen(const char *address);
+
+//	Accepts a pending connection on a listening socket
+//	
+//	Returns NET_INVALID on error.
+Net_Socket net_accept(Net_Socket listener);
+
+//	Connects to a listening address
+//	
+//	Returns NET_INVALID on error.
+Net_Socket net_connect(const char *address);
+
+//	Sends all of a buffer, blocking until it's gone
+//	
+//	Returns 0 on success, 1 if the connection failed.
+int net_send_all(Net_Socket s, const void *data, size_t size);
+
+//	Receives exactly `size` bytes, blocking until they arrive
+//	
+//	Returns 0 on success, 1 if the connection closed, failed or timed out.
+int net_recv_all(Net_Socket s, void *data, size_t size);
+
+//	Sets how long a receive may block before failing (0 for forever)
+//	
+void net_set_timeout(Net_Socket s, Uint32 timeout_ms);
+
+//	Waits for any of a set of sockets to become readable
+//	
+//	`readable` is filled in for each socket.
+//	Returns the number of readable sockets, 0 on timeout or -1 on error.
+int net_wait(const Net_Socket *sockets, int count, Uint32 timeout_ms, bool *readable);
+
+//	Closes a socket
+//	
+void net_close(Net_Socket s);
+
+#endif
@@ -0,0 +1,209 @@
+#include "partition.h"
+
+// Iterations a pixel costs, from its escape value
+static double __cost(Uint32 escape, Uint32 iterations) {
+	if (escape == RENDER_INTERIOR) return iterations;
+	return SDL_min(escape, iterations);
+}
+
+// Nearest pixel of the last frame to a point, clamped to its edges, and whether it was in it
+static Uint32 __old_pixel(double pos, Uint32 size, bool *inside) {
+	double p = SDL_floor(pos + 0.5);
+	*inside = (p >= 0.0 && p < size);
+	if (p < 0.0) return 0;
+	if (p >= size) return size - 1;
+	return (Uint32) p;
+}
+
+// Sums a band's cost from an estimate's prefix sums
+static double __predicted(const Partition_Estimate *e, Uint32 y_start, Uint32 y_end) {
+	if (e == NULL) return 0.0;
+	return e->prefix[y_end] - e->prefix[y_start];
+}
+
+
+Uint32 *partition_map_buffer(Partition_Map *m, const Render_View *view, Uint32 width, Uint32 height) {
+	Uint32 pixels = width * height;
+	if (pixels > m->capacity) {
+		Uint32 *escapes = SDL_realloc(m->escapes, (size_t) pixels * sizeof(Uint32));
+		if (escapes == NULL) {
+			m->valid = false;
+			return NULL;
+		}
+		m->escapes = escapes;
+		m->capacity = pixels;
+	}
+
+	m->width = width;
+	m->height = height;
+	m->view = *view;
+	m->formula = kernel_formula();
+	m->valid = true;
+	return m->escapes;
+}
+
+void partition_record(Partition_Map *m, const Render_View *view, const Render_Target *escape) {
+	Uint32 *escapes = partition_map_buffer(m, view, escape->width, escape->height);
+	if (escapes == NULL) return;
+
+	for (Uint32 y=0; y<escape->height; y++) {
+		const Uint8 *row = (const Uint8 *) escape->pixels + (size_t) y * escape->stride;
+		SDL_memcpy(escapes + (size_t) y * escape->width, row, escape->width * sizeof(Uint32));
+	}
+}
+
+void partition_map_clear(Partition_Map *m) {
+	m->valid = false;
+}
+
+void partition_map_free(Partition_Map *m) {
+	SDL_free(m->escapes);
+	SDL_zerop(m);
+}
+
+bool partition_estimate(const Partition_Map *m, const Render_View *view, Uint32 width, Uint32 height, Partition_Estimate *e) {
+	SDL_zerop(e);
+	if (!m->valid || height == 0 || width == 0) return false;
+	Kernel_Formula formula = kernel_formula();
+	if (formula.fractal != m->formula.fractal || formula.power != m->formula.power) return false;
+	if (formula.julia_x != m->formula.julia_x || formula.julia_y != m->formula.julia_y) return false;
+
+	e->height = height;
+	e->prefix = SDL_calloc(height + 1, sizeof(double));
+	if (e->prefix == NULL) return false;
+
+	// Pixels that weren't in the last frame are guessed at the cost of the nearest
+	// pixel on its edge, as the set doesn't change much just past it
+	const Render_View *old = &m->view;
+	Uint64 known = 0;
+	for (Uint32 y=0; y<height; y++) {
+		// Same mapping as the renderers, then back into the last frame's pixels
+		bool y_inside;
+		double py = -(y - height / 2.0) / view->zoom + view->screen_y;
+		Uint32 old_y = __old_pixel(m->height / 2.0 - (py - old->screen_y) * old->zoom, m->height, &y_inside);
+		const Uint32 *old_row = m->escapes + (size_t) old_y * m->width;
+
+		double row_cost = 0.0;
+		for (Uint32 x=0; x<width; x+=PARTITION_SAMPLE_STEP) {
+			bool x_inside;
+			Uint32 covers = SDL_min(PARTITION_SAMPLE_STEP, width - x);
+			double px = (x - width / 2.0) / view->zoom + view->screen_x;
+			Uint32 old_x = __old_pixel((px - old->screen_x) * old->zoom + m->width / 2.0, m->width, &x_inside);
+			row_cost += __cost(old_row[old_x], view->iterations) * covers;
+			if (x_inside && y_inside) known += covers;
+		}
+		e->prefix[y + 1] = e->prefix[y] + row_cost;
+	}
+
+	e->coverage = (double) known / ((double) width * height);
+	if (e->coverage < PARTITION_MIN_COVERAGE) {
+		partition_estimate_free(e);
+		return false;
+	}
+	return true;
+}
+
+void partition_estimate_free(Partition_Estimate *e) {
+	SDL_free(e->prefix);
+	SDL_zerop(e);
+}
+
+Uint32 partition_row_at(const Partition_Estimate *e, double fraction) {
+	double target = fraction * e->prefix[e->height];
+
+	// Prefix sums never go down, so binary search for the first row past the target
+	Uint32 lo = 0;
+	Uint32 hi = e->height;
+	while (lo < hi) {
+		Uint32 mid = lo + (hi - lo) / 2;
+		if (e->prefix[mid] < target) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+void partition_cut(const Partition_Estimate *e, Uint32 y_start, Uint32 regions, Partition *p) {
+	Uint32 row_start[PARTITION_MAX_REGIONS + 1];
+	y_start = SDL_min(y_start, e->height - 1);
+	regions = SDL_min(SDL_min(regions, PARTITION_MAX_REGIONS), e->height - y_start);
+	if (regions == 0) regions = 1;
+
+	// Each cut is at least a row past the last, and leaves a row for each band after it
+	double total = e->prefix[e->height];
+	double before = e->prefix[y_start];
+	row_start[0] = y_start;
+	for (Uint32 i=1; i<regions; i++) {
+		Uint32 row = 0;
+		if (total > 0.0) row = partition_row_at(e, (before + (total - before) * i / regions) / total);
+		row = SDL_max(row, row_start[i - 1] + 1);
+		row_start[i] = SDL_min(row, e->height - (regions - i));
+	}
+	row_start[regions] = e->height;
+
+	partition_bands(e, row_start, regions, p);
+}
+
+void partition_bands(const Partition_Estimate *e, const Uint32 *row_start, Uint32 regions, Partition *p) {
+	regions = SDL_min(regions, PARTITION_MAX_REGIONS);
+	p->regions = regions;
+	p->coverage = (e != NULL) ? e->coverage : 0.0;
+	p->measured = false;
+	for (Uint32 i=0; i<=regions; i++) p->row_start[i] = row_start[i];
+	for (Uint32 i=0; i<regions; i++) {
+		p->predicted[i] = __predicted(e, row_start[i], row_start[i + 1]);
+		p->actual[i] = 0;
+	}
+}
+
+void partition_measure(Partition *p, const Render_Target *escape, Uint32 iterations) {
+	for (Uint32 i=0; i<p->regions; i++) {
+		Uint64 actual = 0;
+		Uint32 y_end = SDL_min(p->row_start[i + 1], escape->height);
+		for (Uint32 y=p->row_start[i]; y<y_end; y++) {
+			const Uint32 *row = (const Uint32 *)((const Uint8 *) escape->pixels + (size_t) y * escape->stride);
+			for (Uint32 x=0; x<escape->width; x++) actual += (Uint64) __cost(row[x], iterations);
+		}
+		p->actual[i] = actual;
+	}
+	p->measured = true;
+}
+
+void partition_print(const Partition *p, FILE *f) {
+	if (p->regions == 0 || !p->measured) {
+		fprintf(f, "---> No cost-aware partition yet\n");
+		return;
+	}
+
+	double predicted_total = 0.0;
+	double actual_total = 0.0;
+	for (Uint32 i=0; i<p->regions; i++) {
+		predicted_total += p->predicted[i];
+		actual_total += p->actual[i];
+	}
+	if (predicted_total <= 0.0 || actual_total <= 0.0) {
+		fprintf(f, "---> Cost-aware partition: nothing to compare\n");
+		return;
+	}
+
+	fprintf(f, "---> Cost-aware partition: %u regions, %.0lf%% of the frame estimated from the last one\n", p->regions, p->coverage * 100.0);
+	fprintf(f, "      %6s %11s %10s %10s %8s\n", "Region", "Rows", "Predicted", "Actual", "Error");
+
+	// Shares of the frame rather than iterations, as the guessed pixels throw the total off
+	double error_sum = 0.0;
+	double worst_ratio = 0.0;
+	for (Uint32 i=0; i<p->regions; i++) {
+		double predicted = p->predicted[i] / predicted_total * 100.0;
+		double actual = p->actual[i] / actual_total * 100.0;
+		error_sum += SDL_fabs(actual - predicted);
+		if (predicted > 0.0) worst_ratio = SDL_max(worst_ratio, actual / predicted);
+		fprintf(f, "      %6u %5u-%-5u %9.2lf%% %9.2lf%% %+7.2lf\n",
+			i, p->row_start[i], p->row_start[i + 1] - 1, predicted, actual, actual - predicted
+		);
+	}
+
+	fprintf(f, "      Total %.2lf M predicted against %.2lf M actual iterations; mean error %.2lf%% of the frame per region\n",
+		predicted_total / 1e6, actual_total / 1e6, error_sum / p->regions
+	);
+	fprintf(f, "      Worst region took %.2lfx its predicted share\n", worst_ratio);
+	fflush(f);
+}
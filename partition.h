@@ -0,0 +1,115 @@
+//	
+//	Cost-aware frame partitioning
+//	
+//	Most of a frame's cost is around the edge of the set, so bands of
+//	equal height can take very different times. Between consecutive
+//	frames of a pan, zoom or demo path the edge only moves a little,
+//	so the last frame's escape map says where the next frame's cost
+//	will be. It's reprojected onto the new view (pixels that weren't
+//	in the last frame take the cost of the nearest one on its edge),
+//	summed along each row into a prefix sum over the rows, and the
+//	frame is then cut into bands of rows that are estimated to cost
+//	the same.
+//	
+//	Once the frame is done, the cost each band actually took is
+//	measured from its own escape map, to show how good the estimate
+//	was.
+//	
+
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "kernel.h"
+#include "render.h"
+
+#define PARTITION_MAX_REGIONS 256
+#define PARTITION_SAMPLE_STEP 4			// Every this many pixels along a row are looked up when estimating it
+#define PARTITION_MIN_COVERAGE 0.25		// Fraction of the new frame the last one must cover to be worth using
+
+
+// The escape map of the last frame, kept to estimate the next one from
+typedef struct {
+	Uint32 *escapes;	// Rows packed, from the top down
+	Uint32 width;
+	Uint32 height;
+	Uint32 capacity;	// Pixels `escapes` can hold
+	Render_View view;
+	Kernel_Formula formula;
+	bool valid;
+} Partition_Map;
+
+// Estimated cost of every row of a frame
+typedef struct {
+	Uint32 height;
+	double *prefix;		// Estimated iterations of the rows above each row, `height + 1` of them
+	double coverage;	// Fraction of the frame that was in the last one
+} Partition_Estimate;
+
+typedef struct {
+	Uint32 regions;
+	Uint32 row_start[PARTITION_MAX_REGIONS + 1];	// Region i covers rows row_start[i] up to row_start[i + 1]
+	double predicted[PARTITION_MAX_REGIONS];		// Estimated iterations of each region
+	Uint64 actual[PARTITION_MAX_REGIONS];			// Iterations each region took, once measured
+	double coverage;
+	bool measured;
+} Partition;
+
+
+//	Gets a buffer to store a frame's escape values in, for estimating the next frame from
+//	
+//	The buffer holds `width * height` values, rows packed, and must
+//	be filled in before the map is next used.
+//	Returns NULL if it couldn't be allocated.
+Uint32 *partition_map_buffer(Partition_Map *m, const Render_View *view, Uint32 width, Uint32 height);
+
+//	Keeps a copy of a frame's escape values, for estimating the next frame from
+//	
+void partition_record(Partition_Map *m, const Render_View *view, const Render_Target *escape);
+
+//	Forgets the last frame, e.g. because the next one won't look like it
+//	
+void partition_map_clear(Partition_Map *m);
+
+//	Frees the last frame's escape values
+//	
+void partition_map_free(Partition_Map *m);
+
+//	Estimates the cost of every row of a view from the last frame
+//	
+//	The estimate owns its prefix sums until `partition_estimate_free()`.
+//	Returns false (with nothing to free) if there's no last frame, it
+//	was of a different formula, or it covers too little of the view.
+bool partition_estimate(const Partition_Map *m, const Render_View *view, Uint32 width, Uint32 height, Partition_Estimate *e);
+
+//	Frees the prefix sums of an estimate
+//	
+void partition_estimate_free(Partition_Estimate *e);
+
+//	Finds the first row where the estimated cost of everything above it reaches a fraction of the total
+//	
+Uint32 partition_row_at(const Partition_Estimate *e, double fraction);
+
+//	Cuts the rows of a frame from `y_start` down into bands of equal estimated cost
+//	
+//	There may be fewer than `regions` bands if there are too few rows,
+//	but never more than PARTITION_MAX_REGIONS.
+void partition_cut(const Partition_Estimate *e, Uint32 y_start, Uint32 regions, Partition *p);
+
+//	Fills a partition in with bands chosen some other way, and their estimated costs
+//	
+//	`row_start` has `regions + 1` entries, the last being the height.
+void partition_bands(const Partition_Estimate *e, const Uint32 *row_start, Uint32 regions, Partition *p);
+
+//	Measures how many iterations each band of a partition actually took
+//	
+void partition_measure(Partition *p, const Render_Target *escape, Uint32 iterations);
+
+//	Prints the estimated against the measured cost of each band to a file (e.g. stdout)
+//	
+void partition_print(const Partition *p, FILE *f);
+
+#endif
@@ -0,0 +1,123 @@
+#include "pool.h"
+
+struct Pool {
+	int threads;
+	SDL_Thread *workers[POOL_MAX_THREADS];
+
+	SDL_mutex *lock;
+	SDL_cond *start;		// Signalled when a new batch of jobs is ready
+	SDL_cond *finished;		// Signalled when the last worker leaves a batch
+	Uint32 batch;			// Incremented for every call to pool_run()
+	int busy;				// Workers still inside the current batch
+	bool quit;
+
+	Pool_Job job;
+	void *ctx;
+	Uint32 count;
+	SDL_atomic_t next;		// Next job index to hand out
+};
+
+typedef struct {
+	Pool *pool;
+	int thread;
+} Pool_Worker_Args;
+
+// Takes jobs from the current batch until there are none left
+static void __run_jobs(Pool *pool, int thread) {
+	while (true) {
+		Uint32 index = (Uint32) SDL_AtomicAdd(&pool->next, 1);
+		if (index >= pool->count) return;
+		pool->job(pool->ctx, index, thread);
+	}
+}
+
+static int __worker(void *data) {
+	Pool_Worker_Args args = *(Pool_Worker_Args *) data;
+	SDL_free(data);
+	Pool *pool = args.pool;
+	Uint32 seen_batch = 0;
+
+	SDL_LockMutex(pool->lock);
+	while (true) {
+		while (!pool->quit && pool->batch == seen_batch) SDL_CondWait(pool->start, pool->lock);
+		if (pool->quit) break;
+		seen_batch = pool->batch;
+		SDL_UnlockMutex(pool->lock);
+
+		__run_jobs(pool, args.thread);
+
+		SDL_LockMutex(pool->lock);
+		if (--pool->busy == 0) SDL_CondSignal(pool->finished);
+	}
+	SDL_UnlockMutex(pool->lock);
+	return 0;
+}
+
+
+Pool *pool_create(int threads) {
+	if (threads <= 0) threads = SDL_GetCPUCount();
+	if (threads < 1) threads = 1;
+	if (threads > POOL_MAX_THREADS) threads = POOL_MAX_THREADS;
+
+	Pool *pool = SDL_calloc(1, sizeof(Pool));
+	pool->threads = threads;
+	pool->lock = SDL_CreateMutex();
+	pool->start = SDL_CreateCond();
+	pool->finished = SDL_CreateCond();
+
+	for (int i=1; i<threads; i++) {
+		Pool_Worker_Args *args = SDL_malloc(sizeof(Pool_Worker_Args));
+		args->pool = pool;
+		args->thread = i;
+		pool->workers[i] = SDL_CreateThread(__worker, "pool_worker", args);
+	}
+
+	return pool;
+}
+
+void pool_destroy(Pool *pool) {
+	if (pool == NULL) return;
+
+	SDL_LockMutex(pool->lock);
+	pool->quit = true;
+	SDL_CondBroadcast(pool->start);
+	SDL_UnlockMutex(pool->lock);
+
+	for (int i=1; i<pool->threads; i++) SDL_WaitThread(pool->workers[i], NULL);
+
+	SDL_DestroyCond(pool->finished);
+	SDL_DestroyCond(pool->start);
+	SDL_DestroyMutex(pool->lock);
+	SDL_free(pool);
+}
+
+int pool_threads(Pool *pool) {
+	return pool->threads;
+}
+
+void pool_run(Pool *pool, Uint32 count, Pool_Job job, void *ctx) {
+	if (count == 0) return;
+
+	// Not worth waking anyone for
+	if (pool->threads == 1 || count == 1) {
+		for (Uint32 i=0; i<count; i++) job(ctx, i, 0);
+		return;
+	}
+
+	SDL_LockMutex(pool->lock);
+	pool->job = job;
+	pool->ctx = ctx;
+	pool->count = count;
+	SDL_AtomicSet(&pool->next, 0);
+	pool->busy = pool->threads - 1;
+	pool->batch++;
+	SDL_CondBroadcast(pool->start);
+	SDL_UnlockMutex(pool->lock);
+
+	__run_jobs(pool, 0);
+
+	// Wait for the workers to finish their last jobs
+	SDL_LockMutex(pool->lock);
+	while (pool->busy > 0) SDL_CondWait(pool->finished, pool->lock);
+	SDL_UnlockMutex(pool->lock);
+}
@@ -0,0 +1,46 @@
+//	
+//	Simple worker thread pool for parallel loops
+//	
+//	Jobs are numbered 0..count-1 and handed out to the workers (and
+//	the calling thread) through an atomic counter, so uneven jobs
+//	balance themselves out.
+//	
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#define POOL_MAX_THREADS 256
+
+
+typedef void (*Pool_Job)(void *ctx, Uint32 index, int thread);
+
+typedef struct Pool Pool;
+
+
+//	Creates a thread pool
+//	
+//	The calling thread of `pool_run()` counts as one of the threads, so
+//	`threads - 1` workers are started. If `threads` is 0 or less, one
+//	thread is used per CPU core.
+//	Should be cleaned up with `pool_destroy()`
+Pool *pool_create(int threads);
+
+//	Stops the workers and frees the pool
+//	
+void pool_destroy(Pool *pool);
+
+//	Gets the number of threads that run jobs, including the caller
+//	
+int pool_threads(Pool *pool);
+
+//	Runs `job(ctx, index, thread)` for every index in 0..count-1 and waits for them all
+//	
+//	`thread` is in 0..pool_threads()-1 and identifies the thread running
+//	the job, so jobs can use per-thread scratch data without locking.
+//	Only one thread may be running jobs on a pool at a time.
+void pool_run(Pool *pool, Uint32 count, Pool_Job job, void *ctx);
+
+#endif
@@ -0,0 +1,197 @@
+#include "prefetch.h"
+
+typedef enum {
+	SLOT_EMPTY,
+	SLOT_RENDERING,	// Some bands are done
+	SLOT_READY,
+} Prefetch_Slot_State;
+
+typedef struct {
+	gl_frametex ftex;
+	Render_View view;
+	Prefetch_Kind kind;
+	Prefetch_Slot_State state;
+	Uint32 next_row;
+	Uint64 last_used;	// When it was last suggested or taken, for evicting the least recently used
+	int priority;		// Position in the current suggestions, or -1 if it isn't one
+} Prefetch_Slot;
+
+struct Prefetch {
+	Uint32 width;
+	Uint32 height;
+	gl_frametex band;	// Rendered into, then copied into the slot
+	GLsync fence;		// Signalled once the last band queued is done, or NULL
+	Prefetch_Slot slots[PREFETCH_SLOTS];
+	Uint64 clock;		// Counts suggestions and takes
+	Prefetch_Stats stats;
+};
+
+
+static bool __same_view(const Render_View *a, const Render_View *b) {
+	return a->screen_x == b->screen_x && a->screen_y == b->screen_y && a->zoom == b->zoom
+		&& a->iterations == b->iterations && a->kernel == b->kernel && a->colour == b->colour;
+}
+
+static Prefetch_Slot *__find(Prefetch *p, const Render_View *view) {
+	for (int i=0; i<PREFETCH_SLOTS; i++) {
+		Prefetch_Slot *s = &p->slots[i];
+		if (s->state != SLOT_EMPTY && __same_view(&s->view, view)) return s;
+	}
+	return NULL;
+}
+
+// Empties a slot, counting the work lost if it wasn't finished
+static void __evict(Prefetch *p, Prefetch_Slot *s) {
+	if (s->state == SLOT_RENDERING) p->stats.abandoned++;
+	s->state = SLOT_EMPTY;
+	s->priority = -1;
+}
+
+// Picks the slot for a new suggestion: an empty one, or else the least recently used that isn't suggested
+static Prefetch_Slot *__claim(Prefetch *p) {
+	Prefetch_Slot *best = NULL;
+	for (int i=0; i<PREFETCH_SLOTS; i++) {
+		Prefetch_Slot *s = &p->slots[i];
+		if (s->state == SLOT_EMPTY) return s;
+		if (s->priority >= 0) continue;
+		if (best == NULL || s->last_used < best->last_used) best = s;
+	}
+	if (best != NULL) __evict(p, best);
+	return best;
+}
+
+// Finds the most likely suggestion that isn't finished yet
+static Prefetch_Slot *__next_job(Prefetch *p) {
+	Prefetch_Slot *best = NULL;
+	for (int i=0; i<PREFETCH_SLOTS; i++) {
+		Prefetch_Slot *s = &p->slots[i];
+		if (s->state != SLOT_RENDERING || s->priority < 0) continue;
+		if (best == NULL || s->priority < best->priority) best = s;
+	}
+	return best;
+}
+
+Prefetch *prefetch_create(Uint32 width, Uint32 height) {
+	Prefetch *p = SDL_malloc(sizeof(Prefetch));
+	if (p == NULL) return NULL;
+	*p = (Prefetch){ .width = width, .height = height };
+
+	p->band = gl_create_frametex(width, PREFETCH_BAND_ROWS);
+	for (int i=0; i<PREFETCH_SLOTS; i++) {
+		p->slots[i].ftex = gl_create_frametex(width, height);
+		p->slots[i].priority = -1;
+	}
+	return p;
+}
+
+void prefetch_destroy(Prefetch *p) {
+	if (p == NULL) return;
+	if (p->fence != NULL) glDeleteSync(p->fence);
+	gl_destroy_frametex(p->band);
+	for (int i=0; i<PREFETCH_SLOTS; i++) gl_destroy_frametex(p->slots[i].ftex);
+	SDL_free(p);
+}
+
+void prefetch_suggest(Prefetch *p, const Prefetch_Candidate *candidates, Uint32 count) {
+	for (int i=0; i<PREFETCH_SLOTS; i++) p->slots[i].priority = -1;
+	p->clock++;
+
+	count = SDL_min(count, PREFETCH_MAX_CANDIDATES);
+	for (Uint32 c=0; c<count; c++) {
+		Prefetch_Slot *s = __find(p, &candidates[c].view);
+		if (s == NULL) {
+			s = __claim(p);
+			if (s == NULL) break;
+			s->view = candidates[c].view;
+			s->kind = candidates[c].kind;
+			s->state = SLOT_RENDERING;
+			s->next_row = 0;
+		}
+		s->priority = c;
+		s->last_used = p->clock;
+	}
+}
+
+bool prefetch_pending(Prefetch *p) {
+	return __next_job(p) != NULL;
+}
+
+void prefetch_step(Prefetch *p, Render_Handle *h) {
+	Prefetch_Slot *s = __next_job(p);
+	if (s == NULL) return;
+
+	// Only one band is ever queued on the GPU, so a real frame never waits behind more
+	if (p->fence != NULL) {
+		GLenum waited = glClientWaitSync(p->fence, GL_SYNC_FLUSH_COMMANDS_BIT, PREFETCH_WAIT_NS);
+		if (waited == GL_TIMEOUT_EXPIRED) return;
+		glDeleteSync(p->fence);
+		p->fence = NULL;
+	}
+
+	TRACE_BEGIN("prefetch_band");
+	const Render_View *v = &s->view;
+	Render_View band = *v;
+	band.screen_y = v->screen_y - (s->next_row + PREFETCH_BAND_ROWS / 2.0 - p->height / 2.0) / v->zoom;
+	band.colour = COLOUR_LINEAR;
+	render_to_frametex(h, &band, p->band);
+
+	Uint32 rows = SDL_min(PREFETCH_BAND_ROWS, p->height - s->next_row);
+	glCopyImageSubData(p->band.tex, GL_TEXTURE_2D, 0, 0, 0, 0, s->ftex.tex, GL_TEXTURE_2D, 0, 0, s->next_row, 0, p->width, rows, 1);
+	glCopyImageSubData(p->band.escape, GL_TEXTURE_2D, 0, 0, 0, 0, s->ftex.escape, GL_TEXTURE_2D, 0, 0, s->next_row, 0, p->width, rows, 1);
+	gl_check_err("Failed to copy prefetched band");
+	s->next_row += rows;
+
+	// Histogram colouring needs every pixel's escape value
+	if (s->next_row >= p->height) {
+		colour_apply(v->colour, s->ftex, v->iterations);
+		s->state = SLOT_READY;
+		p->stats.rendered_by_kind[s->kind]++;
+	}
+
+	p->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	TRACE_END();
+}
+
+bool prefetch_take(Prefetch *p, const Render_View *view, gl_frametex ftex) {
+	p->stats.requests++;
+	Prefetch_Slot *s = __find(p, view);
+	if (s == NULL || s->state != SLOT_READY) return false;
+
+	glCopyImageSubData(s->ftex.tex, GL_TEXTURE_2D, 0, 0, 0, 0, ftex.tex, GL_TEXTURE_2D, 0, 0, 0, 0, p->width, p->height, 1);
+	glCopyImageSubData(s->ftex.escape, GL_TEXTURE_2D, 0, 0, 0, 0, ftex.escape, GL_TEXTURE_2D, 0, 0, 0, 0, p->width, p->height, 1);
+	gl_check_err("Failed to copy prefetched frame");
+	s->last_used = ++p->clock;
+	p->stats.hits++;
+	p->stats.hits_by_kind[s->kind]++;
+	return true;
+}
+
+void prefetch_invalidate(Prefetch *p) {
+	for (int i=0; i<PREFETCH_SLOTS; i++) __evict(p, &p->slots[i]);
+}
+
+Prefetch_Stats prefetch_stats(Prefetch *p) {
+	return p->stats;
+}
+
+void prefetch_dump(Prefetch *p, FILE *f) {
+	static const char *kind_names[PREFETCH_KIND_COUNT] = {
+		[PREFETCH_ZOOM_IN] = "zoom in",
+		[PREFETCH_ZOOM_OUT] = "zoom out",
+		[PREFETCH_PAN] = "pan",
+	};
+
+	const Prefetch_Stats *s = &p->stats;
+	if (s->requests == 0) {
+		fprintf(f, "---> No frames looked up in the prefetch cache yet\n");
+		return;
+	}
+	fprintf(f, "---> Prefetch: %u of %u frames from the cache (%.1lf%%), %u speculative frames abandoned\n",
+		s->hits, s->requests, 100.0 * s->hits / s->requests, s->abandoned);
+	for (int k=0; k<PREFETCH_KIND_COUNT; k++) {
+		Uint32 rendered = s->rendered_by_kind[k];
+		fprintf(f, "      %-8s %5u rendered, %5u used (%.1lf%%)\n",
+			kind_names[k], rendered, s->hits_by_kind[k], (rendered > 0) ? 100.0 * s->hits_by_kind[k] / rendered : 0.0);
+	}
+}
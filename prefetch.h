@@ -0,0 +1,103 @@
+//	
+//	Speculative rendering of likely next views while idle
+//	
+//	Between input events the renderer would otherwise sit idle, so the
+//	views the user is most likely to ask for next (the next zoom step
+//	in and out, and the next step of a pan) are rendered ahead of time
+//	into a small cache of frametexes. When a frame is asked for that's
+//	already in the cache, it's copied into place instead of rendered.
+//	
+//	Speculative frames are rendered a band of PREFETCH_BAND_ROWS at a
+//	time, and a band isn't queued until the GPU has finished the one
+//	before, so if input arrives the real frame waits on one band at most.
+//	As with progressive frames, bands use linear colouring, and
+//	histogram colouring is applied once the last band is in.
+//	
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "render.h"
+#include "trace.h"
+
+#define PREFETCH_SLOTS 6			// Frames kept in the cache, finished or not
+#define PREFETCH_BAND_ROWS 64		// Rows rendered per step
+#define PREFETCH_MAX_CANDIDATES 4
+#define PREFETCH_WAIT_NS 1000000	// Longest a step waits on the last band before giving up for now
+
+
+typedef enum {
+	PREFETCH_ZOOM_IN,
+	PREFETCH_ZOOM_OUT,
+	PREFETCH_PAN,
+	PREFETCH_KIND_COUNT,
+} Prefetch_Kind;
+
+// A view that might be asked for next
+typedef struct {
+	Render_View view;		// With the kernel already chosen, as it will be when it's asked for
+	Prefetch_Kind kind;
+} Prefetch_Candidate;
+
+typedef struct {
+	Uint32 requests;	// Frames looked up with `prefetch_take()`
+	Uint32 hits;
+	Uint32 hits_by_kind[PREFETCH_KIND_COUNT];
+	Uint32 rendered_by_kind[PREFETCH_KIND_COUNT];	// Speculative frames finished
+	Uint32 abandoned;	// Speculative frames dropped before they were finished
+} Prefetch_Stats;
+
+typedef struct Prefetch Prefetch;
+
+
+//	Creates a cache of speculatively rendered frames of a given size
+//	
+//	Needs a current GL context, for the frametexes.
+Prefetch *prefetch_create(Uint32 width, Uint32 height);
+
+//	Frees everything created by `prefetch_create()`
+//	
+void prefetch_destroy(Prefetch *p);
+
+//	Sets the views to render ahead of time, most likely first
+//	
+//	Frames already cached for these views are kept. Others are only
+//	dropped when their slot is needed, least recently used first.
+void prefetch_suggest(Prefetch *p, const Prefetch_Candidate *candidates, Uint32 count);
+
+//	Checks whether any suggested view still has to be rendered
+//	
+bool prefetch_pending(Prefetch *p);
+
+//	Renders the next band of the most likely view not yet cached
+//	
+//	Should only be called when there's nothing else to do, with input
+//	checked for between calls. Does nothing if the GPU is still busy
+//	with the last band after PREFETCH_WAIT_NS.
+void prefetch_step(Prefetch *p, Render_Handle *h);
+
+//	Copies a cached frame of a view into a frametex, if there is one
+//	
+//	The view must match one suggested earlier exactly. The frametex
+//	must be the size given to `prefetch_create()`.
+//	Returns true if the frame was cached.
+bool prefetch_take(Prefetch *p, const Render_View *view, gl_frametex ftex);
+
+//	Drops every cached frame (e.g. when the renderer changes)
+//	
+void prefetch_invalidate(Prefetch *p);
+
+//	Gets how often frames have been found in the cache
+//	
+Prefetch_Stats prefetch_stats(Prefetch *p);
+
+//	Prints the hit rates to a file (e.g. stdout)
+//	
+void prefetch_dump(Prefetch *p, FILE *f);
+
+#endif
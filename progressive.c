@@ -0,0 +1,212 @@
+#include "progressive.h"
+
+#include <math.h>
+
+typedef struct {
+	Uint32 x;		// Top left corner in the frame
+	Uint32 y;
+	Uint32 ring;	// Chebyshev distance from the focus tile
+	float angle;	// Around the focus tile, so each ring is walked in order
+} Progressive_Tile;
+
+struct Progressive {
+	Uint32 width;
+	Uint32 height;
+	gl_frametex preview;	// Frame at 1/PROGRESSIVE_PREVIEW_SCALE resolution
+	gl_frametex tile;		// Rendered into, then copied into the frame
+
+	Progressive_Tile *tiles;	// In the order they're rendered
+	Uint32 tile_count;
+	Uint32 next_tile;
+
+	bool active;
+	bool previewed;		// The first step (rendering the preview) has happened
+	Render_Handle *handle;
+	Render_View view;
+	gl_frametex ftex;
+
+	Progressive_Stats current;
+	Progressive_Stats last;
+};
+
+
+static double __ms_since(Uint64 ts) {
+	return (SDL_GetPerformanceCounter() - ts) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+static int __compare_tiles(const void *a, const void *b) {
+	const Progressive_Tile *ta = a;
+	const Progressive_Tile *tb = b;
+	if (ta->ring != tb->ring) return (ta->ring < tb->ring) ? -1 : 1;
+	if (ta->angle != tb->angle) return (ta->angle < tb->angle) ? -1 : 1;
+	return 0;
+}
+
+// Orders the tiles in a spiral, ring by ring out from the one holding the focus point
+static void __order_tiles(Progressive *p, int focus_x, int focus_y) {
+	Uint32 tiles_x = (p->width + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+	int focus_tx = SDL_min(SDL_max(focus_x, 0), (int)p->width - 1) / PROGRESSIVE_TILE_SIZE;
+	int focus_ty = SDL_min(SDL_max(focus_y, 0), (int)p->height - 1) / PROGRESSIVE_TILE_SIZE;
+
+	for (Uint32 i=0; i<p->tile_count; i++) {
+		int tx = i % tiles_x;
+		int ty = i / tiles_x;
+		int dx = tx - focus_tx;
+		int dy = ty - focus_ty;
+		p->tiles[i] = (Progressive_Tile){
+			.x = tx * PROGRESSIVE_TILE_SIZE,
+			.y = ty * PROGRESSIVE_TILE_SIZE,
+			.ring = SDL_max(SDL_abs(dx), SDL_abs(dy)),
+			.angle = atan2f(dy, dx),
+		};
+	}
+	SDL_qsort(p->tiles, p->tile_count, sizeof(Progressive_Tile), __compare_tiles);
+}
+
+// Renders the preview and stretches it over the whole frame
+static void __render_preview(Progressive *p) {
+	const Render_View *v = &p->view;
+	const double scale = PROGRESSIVE_PREVIEW_SCALE;
+	Uint32 cover_w = p->preview.w * PROGRESSIVE_PREVIEW_SCALE;
+	Uint32 cover_h = p->preview.h * PROGRESSIVE_PREVIEW_SCALE;
+
+	// Each preview pixel shows the middle of the block of frame pixels it's stretched over
+	Render_View preview = *v;
+	preview.screen_x = v->screen_x + ((scale - 1.0) / 2.0 + cover_w / 2.0 - p->width / 2.0) / v->zoom;
+	preview.screen_y = v->screen_y - ((scale - 1.0) / 2.0 + cover_h / 2.0 - p->height / 2.0) / v->zoom;
+	preview.zoom = v->zoom / scale;
+	preview.colour = COLOUR_LINEAR;
+
+	render_to_frametex(p->handle, &preview, p->preview);
+	p->current.pixel_iters += render_last_iterations(p->handle);
+
+	// Blits are clipped to the frame, so a cover slightly bigger than it keeps the scale exact
+	glBlitNamedFramebuffer(
+		p->preview.fb, p->ftex.fb,
+		0, 0, p->preview.w, p->preview.h,
+		0, 0, cover_w, cover_h,
+		GL_COLOR_BUFFER_BIT, GL_LINEAR
+	);
+	gl_check_err("Failed to draw progressive preview");
+}
+
+// Renders a tile and copies the part of it inside the frame into place
+static void __render_tile(Progressive *p, const Progressive_Tile *t) {
+	const Render_View *v = &p->view;
+	Render_View tile = *v;
+	tile.screen_x = v->screen_x + (t->x + PROGRESSIVE_TILE_SIZE / 2.0 - p->width / 2.0) / v->zoom;
+	tile.screen_y = v->screen_y - (t->y + PROGRESSIVE_TILE_SIZE / 2.0 - p->height / 2.0) / v->zoom;
+	tile.colour = COLOUR_LINEAR;
+
+	render_to_frametex(p->handle, &tile, p->tile);
+	p->current.pixel_iters += render_last_iterations(p->handle);
+
+	Uint32 w = SDL_min(PROGRESSIVE_TILE_SIZE, p->width - t->x);
+	Uint32 h = SDL_min(PROGRESSIVE_TILE_SIZE, p->height - t->y);
+	glCopyImageSubData(p->tile.tex, GL_TEXTURE_2D, 0, 0, 0, 0, p->ftex.tex, GL_TEXTURE_2D, 0, t->x, t->y, 0, w, h, 1);
+	glCopyImageSubData(p->tile.escape, GL_TEXTURE_2D, 0, 0, 0, 0, p->ftex.escape, GL_TEXTURE_2D, 0, t->x, t->y, 0, w, h, 1);
+	gl_check_err("Failed to copy progressive tile");
+	p->current.tiles++;
+}
+
+Progressive *progressive_create(Uint32 width, Uint32 height) {
+	Progressive *p = SDL_malloc(sizeof(Progressive));
+	if (p == NULL) return NULL;
+	*p = (Progressive){ .width = width, .height = height };
+
+	Uint32 tiles_x = (width + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+	Uint32 tiles_y = (height + PROGRESSIVE_TILE_SIZE - 1) / PROGRESSIVE_TILE_SIZE;
+	p->tile_count = tiles_x * tiles_y;
+	p->tiles = SDL_malloc(p->tile_count * sizeof(Progressive_Tile));
+	if (p->tiles == NULL) {
+		SDL_free(p);
+		return NULL;
+	}
+
+	p->preview = gl_create_frametex(
+		(width + PROGRESSIVE_PREVIEW_SCALE - 1) / PROGRESSIVE_PREVIEW_SCALE,
+		(height + PROGRESSIVE_PREVIEW_SCALE - 1) / PROGRESSIVE_PREVIEW_SCALE
+	);
+	p->tile = gl_create_frametex(PROGRESSIVE_TILE_SIZE, PROGRESSIVE_TILE_SIZE);
+	return p;
+}
+
+void progressive_destroy(Progressive *p) {
+	if (p == NULL) return;
+	gl_destroy_frametex(p->preview);
+	gl_destroy_frametex(p->tile);
+	SDL_free(p->tiles);
+	SDL_free(p);
+}
+
+void progressive_begin(Progressive *p, Render_Handle *h, const Render_View *view, gl_frametex ftex, int focus_x, int focus_y) {
+	p->handle = h;
+	p->view = *view;
+	p->ftex = ftex;
+	p->next_tile = 0;
+	p->previewed = false;
+	p->active = true;
+	p->current = (Progressive_Stats){ .ts_begin = telemetry_frame_begin() };
+	__order_tiles(p, focus_x, focus_y);
+}
+
+bool progressive_step(Progressive *p) {
+	if (!p->active) return true;
+
+	// The preview gets a step of its own so it's on screen as soon as possible
+	if (!p->previewed) {
+		TRACE_BEGIN("preview");
+		__render_preview(p);
+		p->previewed = true;
+		TRACE_END();
+		return false;
+	}
+
+	// Always do at least one tile, so progress is made however slow they are
+	Uint64 ts_step = SDL_GetPerformanceCounter();
+	TRACE_BEGIN("tiles");
+	do {
+		__render_tile(p, &p->tiles[p->next_tile++]);
+	} while (p->next_tile < p->tile_count && __ms_since(ts_step) < PROGRESSIVE_PRESENT_MS);
+	TRACE_END();
+
+	if (p->next_tile < p->tile_count) return false;
+
+	// Histogram colouring needs every pixel's escape value
+	colour_apply(p->view.colour, p->ftex, p->view.iterations);
+	p->active = false;
+	return true;
+}
+
+void progressive_presented(Progressive *p) {
+	double ms = __ms_since(p->current.ts_begin);
+	if (p->current.preview_ms == 0.0) p->current.preview_ms = ms;
+	else if (p->current.first_tile_ms == 0.0) p->current.first_tile_ms = ms;
+
+	if (!p->active && p->current.frame_ms == 0.0) {
+		p->current.frame_ms = ms;
+		p->last = p->current;
+	}
+}
+
+bool progressive_active(Progressive *p) {
+	return p->active;
+}
+
+void progressive_cancel(Progressive *p) {
+	p->active = false;
+}
+
+Progressive_Stats progressive_stats(Progressive *p) {
+	return p->last;
+}
+
+void progressive_dump(Progressive *p, FILE *f) {
+	const Progressive_Stats *s = &p->last;
+	if (s->tiles == 0) {
+		fprintf(f, "---> No progressive frames yet\n");
+		return;
+	}
+	fprintf(f, "---> Last progressive frame: preview after %.1lf ms, first tile after %.1lf ms, all %u tiles after %.1lf ms\n",
+		s->preview_ms, s->first_tile_ms, s->tiles, s->frame_ms);
+}
@@ -0,0 +1,92 @@
+//	
+//	Progressive presentation of slow frames
+//	
+//	Instead of a slow frame appearing all at once when it's done, a
+//	low resolution preview of it is shown straight away, then the
+//	frame is rendered in tiles spiralling out from a focus point
+//	(usually the mouse), presenting what's been done so far every
+//	PROGRESSIVE_PRESENT_MS. Tiles that aren't done yet show the
+//	upscaled preview, so the area being looked at sharpens first.
+//	
+//	Tiles are rendered with linear colouring; histogram colouring
+//	needs the whole frame, so it's applied once the last tile is in.
+//	
+
+#ifndef PROGRESSIVE_H
+#define PROGRESSIVE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "render.h"
+#include "telemetry.h"
+#include "trace.h"
+
+#define PROGRESSIVE_TILE_SIZE 64		// Width and height of a tile in pixels
+#define PROGRESSIVE_PREVIEW_SCALE 8		// The preview is this many times smaller on each axis
+#define PROGRESSIVE_PRESENT_MS 16.0		// Time between presenting partial frames
+#define PROGRESSIVE_THRESHOLD_MS 50.0	// Frames slower than this are worth drawing progressively
+
+
+typedef struct Progressive Progressive;
+
+typedef struct {
+	Uint64 ts_begin;		// Timestamp from `telemetry_frame_begin()` when the frame was started
+	double preview_ms;		// Until the preview was presented
+	double first_tile_ms;	// Until the first full resolution tile was presented
+	double frame_ms;		// Until the whole frame was presented
+	Uint64 pixel_iters;		// Over the preview and every tile
+	Uint32 tiles;
+} Progressive_Stats;
+
+
+//	Creates the state for progressively rendering frames of a given size
+//	
+//	Needs a current GL context, for the preview and tile frametexes.
+Progressive *progressive_create(Uint32 width, Uint32 height);
+
+//	Frees everything created by `progressive_create()`
+//	
+void progressive_destroy(Progressive *p);
+
+//	Starts progressively rendering a view into a frametex
+//	
+//	Cancels any frame that was still in progress. `focus_x`/`focus_y`
+//	is the pixel the spiral of tiles starts from. The frametex must be
+//	the size given to `progressive_create()` and stay alive until the
+//	frame is complete or cancelled.
+void progressive_begin(Progressive *p, Render_Handle *h, const Render_View *view, gl_frametex ftex, int focus_x, int focus_y);
+
+//	Renders the next part of the frame into the frametex
+//	
+//	The first step renders only the preview. Later ones render tiles
+//	until PROGRESSIVE_PRESENT_MS has passed. The frametex should be
+//	presented after each step, then `progressive_presented()` called.
+//	Returns true once the frame is complete.
+bool progressive_step(Progressive *p);
+
+//	Records that the results of the last step are now on screen
+//	
+//	Used for the preview, first tile and frame times in the stats.
+void progressive_presented(Progressive *p);
+
+//	Checks whether a frame is in progress
+//	
+bool progressive_active(Progressive *p);
+
+//	Abandons the frame in progress, if there is one
+//	
+void progressive_cancel(Progressive *p);
+
+//	Gets the stats of the last completed frame
+//	
+//	Everything is 0 if no frame has completed yet.
+Progressive_Stats progressive_stats(Progressive *p);
+
+//	Prints the stats of the last completed frame to a file (e.g. stdout)
+//	
+void progressive_dump(Progressive *p, FILE *f);
+
+#endif
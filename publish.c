@@ -0,0 +1,175 @@
+#include "publish.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define PUBLISH_MAX_NAME 128
+
+struct Publish_Ring {
+	Publish_Header *header;
+	size_t bytes;
+	bool owner;		// Created the block, rather than opened it
+	char name[PUBLISH_MAX_NAME];
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+};
+
+
+static size_t __slot_bytes(Uint32 width, Uint32 height) {
+	size_t bytes = sizeof(Publish_Slot) + (size_t) width * height * (4 + sizeof(Uint32));
+	return (bytes + PUBLISH_ALIGN - 1) / PUBLISH_ALIGN * PUBLISH_ALIGN;
+}
+
+static size_t __header_bytes() {
+	return (sizeof(Publish_Header) + PUBLISH_ALIGN - 1) / PUBLISH_ALIGN * PUBLISH_ALIGN;
+}
+
+// Maps a named block, creating it with the given size if `create` is set
+static void *__map(Publish_Ring *r, size_t bytes, bool create) {
+#ifdef _WIN32
+	char name[PUBLISH_MAX_NAME + 8];
+	SDL_snprintf(name, sizeof(name), "Local\\%s", r->name);
+	if (create) {
+		r->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((Uint64) bytes >> 32), (DWORD) bytes, name);
+	} else {
+		r->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	}
+	if (r->mapping == NULL) return NULL;
+	return MapViewOfFile(r->mapping, create ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, bytes);
+#else
+	char name[PUBLISH_MAX_NAME + 1];
+	SDL_snprintf(name, sizeof(name), "/%s", r->name);
+	int fd;
+	if (create) {
+		shm_unlink(name);
+		fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd >= 0 && ftruncate(fd, bytes) != 0) {
+			close(fd);
+			shm_unlink(name);
+			return NULL;
+		}
+	} else {
+		fd = shm_open(name, O_RDONLY, 0);
+		struct stat st;
+		if (fd >= 0 && bytes == 0 && fstat(fd, &st) == 0) bytes = st.st_size;
+	}
+	if (fd < 0) return NULL;
+
+	void *mem = mmap(NULL, bytes, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);	// The mapping keeps the block alive
+	if (mem == MAP_FAILED) return NULL;
+	r->bytes = bytes;
+	return mem;
+#endif
+}
+
+static void __unmap(Publish_Ring *r) {
+#ifdef _WIN32
+	UnmapViewOfFile(r->header);
+	CloseHandle(r->mapping);
+#else
+	munmap(r->header, r->bytes);
+	if (r->owner) {
+		char name[PUBLISH_MAX_NAME + 1];
+		SDL_snprintf(name, sizeof(name), "/%s", r->name);
+		shm_unlink(name);
+	}
+#endif
+}
+
+Publish_Ring *publish_create(const char *name, Uint32 width, Uint32 height) {
+	Publish_Ring *r = SDL_malloc(sizeof(Publish_Ring));
+	if (r == NULL) return NULL;
+	*r = (Publish_Ring){ .owner = true };
+	SDL_strlcpy(r->name, name, PUBLISH_MAX_NAME);
+
+	r->bytes = __header_bytes() + PUBLISH_SLOTS * __slot_bytes(width, height);
+	r->header = __map(r, r->bytes, true);
+	if (r->header == NULL) {
+		printf("[ERROR] Failed to create shared memory '%s'\n", name);
+		SDL_free(r);
+		return NULL;
+	}
+
+	// The block starts zeroed, so every slot's sequence is already 0 (no frame)
+	*r->header = (Publish_Header){
+		.magic = PUBLISH_MAGIC,
+		.version = PUBLISH_VERSION,
+		.width = width,
+		.height = height,
+		.slots = PUBLISH_SLOTS,
+		.slot_bytes = (Uint32) __slot_bytes(width, height),
+		.frequency = SDL_GetPerformanceFrequency(),
+	};
+	SDL_MemoryBarrierRelease();
+	return r;
+}
+
+Publish_Ring *publish_open(const char *name) {
+	Publish_Ring *r = SDL_malloc(sizeof(Publish_Ring));
+	if (r == NULL) return NULL;
+	*r = (Publish_Ring){ .owner = false };
+	SDL_strlcpy(r->name, name, PUBLISH_MAX_NAME);
+
+	// The whole block is mapped at once, so its size has to be known up front
+	r->header = __map(r, 0, false);
+	if (r->header == NULL) {
+		SDL_free(r);
+		return NULL;
+	}
+	if (r->header->magic != PUBLISH_MAGIC || r->header->version != PUBLISH_VERSION) {
+		printf("[ERROR] '%s' isn't a frame ring this version can read\n", name);
+		__unmap(r);
+		SDL_free(r);
+		return NULL;
+	}
+	return r;
+}
+
+void publish_close(Publish_Ring *r) {
+	if (r == NULL) return;
+	if (r->owner) SDL_AtomicSet(&r->header->closed, 1);
+	__unmap(r);
+	SDL_free(r);
+}
+
+Publish_Header *publish_header(Publish_Ring *r) {
+	return r->header;
+}
+
+Publish_Slot *publish_slot(Publish_Ring *r, Uint64 frame) {
+	Uint8 *slots = (Uint8 *) r->header + __header_bytes();
+	return (Publish_Slot *)(slots + (frame % r->header->slots) * r->header->slot_bytes);
+}
+
+Uint8 *publish_colour(Publish_Ring *r, Publish_Slot *slot) {
+	return (Uint8 *) slot + sizeof(Publish_Slot);
+}
+
+Uint32 *publish_escape(Publish_Ring *r, Publish_Slot *slot) {
+	return (Uint32 *)(publish_colour(r, slot) + (size_t) r->header->width * r->header->height * 4);
+}
+
+Publish_Slot *publish_begin(Publish_Ring *r) {
+	Uint64 frame = (Uint32) SDL_AtomicGet(&r->header->published);
+	Publish_Slot *slot = publish_slot(r, frame);
+
+	// Readers still using the frame that was here will see this and drop it
+	SDL_AtomicSet(&slot->sequence, PUBLISH_SEQUENCE(frame) - 1);
+	slot->frame = frame;
+	return slot;
+}
+
+void publish_end(Publish_Ring *r, Publish_Slot *slot) {
+	slot->ts_published = SDL_GetPerformanceCounter();
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&slot->sequence, PUBLISH_SEQUENCE(slot->frame));
+	SDL_AtomicSet(&r->header->published, (int)(Uint32)(slot->frame + 1));
+}
@@ -0,0 +1,109 @@
+//	
+//	Publishing finished frames to other processes through shared memory
+//	
+//	The publisher creates a named shared memory block holding a ring
+//	of PUBLISH_SLOTS frame slots. Each slot has the view the frame was
+//	rendered with, timestamps, the colour image and the escape image.
+//	Consumers map the same block read-only and use frames in place,
+//	with no copies, sockets or locks.
+//	
+//	Each slot is guarded by a sequence counter (a seqlock). While a
+//	frame is written into it the counter is odd, and afterwards it's
+//	PUBLISH_SEQUENCE(frame). A reader checks the counter is right for
+//	the frame it wants, uses the frame, then checks the counter hasn't
+//	changed. If it has, the publisher lapped the reader and overwrote
+//	the slot, and the frame counts as dropped.
+//	
+//	Timestamps are SDL performance counter values, which come from the
+//	same monotonic clock in every process on a machine.
+//	
+
+#ifndef PUBLISH_H
+#define PUBLISH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#define PUBLISH_DEFAULT_NAME "mandelbrot_frames"
+#define PUBLISH_MAGIC 0x4D424652		// "MBFR"
+#define PUBLISH_VERSION 1
+#define PUBLISH_SLOTS 4
+#define PUBLISH_ALIGN 64				// Slots start on cache lines
+#define PUBLISH_SEQUENCE(frame) ((int)(Uint32)(2 * (frame) + 2))
+
+
+// Start of the shared memory block
+typedef struct {
+	Uint32 magic;
+	Uint32 version;
+	Uint32 width;
+	Uint32 height;
+	Uint32 slots;
+	Uint32 slot_bytes;		// From the start of one slot to the next
+	Uint64 frequency;		// Of the timestamps, in ticks per second
+	SDL_atomic_t published;	// Frames published so far; frame n goes in slot n % slots
+	SDL_atomic_t closed;	// Set when the publisher exits
+} Publish_Header;
+
+// Start of each slot, followed by the colour image (RGBA8) and the escape image (one Uint32 per pixel), both with rows from the top down
+typedef struct {
+	SDL_atomic_t sequence;	// Odd while being written, else PUBLISH_SEQUENCE() of the frame in the slot
+	Uint32 iterations;
+	Uint64 frame;
+	Uint64 ts_begin;		// When the frame was started
+	Uint64 ts_published;	// When it was finished being written
+	double screen_x;		// View the frame shows, as in `Render_View`
+	double screen_y;
+	double zoom;
+	Uint32 kernel;
+	Uint32 colour;
+} Publish_Slot;
+
+typedef struct Publish_Ring Publish_Ring;
+
+
+//	Creates the shared memory ring for frames of a given size
+//	
+//	Replaces any old block of the same name. The block is removed
+//	again by `publish_close()`.
+//	Returns NULL on failure.
+Publish_Ring *publish_create(const char *name, Uint32 width, Uint32 height);
+
+//	Maps an existing ring for reading
+//	
+//	Returns NULL if there's no ring of that name, or it's not one this
+//	build understands.
+Publish_Ring *publish_open(const char *name);
+
+//	Unmaps the ring, marking it closed first if this process created it
+//	
+void publish_close(Publish_Ring *r);
+
+//	Gets the shared header of the ring
+//	
+Publish_Header *publish_header(Publish_Ring *r);
+
+//	Starts writing the next frame
+//	
+//	The returned slot's sequence is already odd and its `frame` set;
+//	the rest should be filled in, then `publish_end()` called.
+Publish_Slot *publish_begin(Publish_Ring *r);
+
+//	Finishes writing a frame, making it visible to readers
+//	
+void publish_end(Publish_Ring *r, Publish_Slot *slot);
+
+//	Gets the slot a frame goes in
+//	
+Publish_Slot *publish_slot(Publish_Ring *r, Uint64 frame);
+
+//	Gets the colour image of a slot
+//	
+Uint8 *publish_colour(Publish_Ring *r, Publish_Slot *slot);
+
+//	Gets the escape image of a slot
+//	
+Uint32 *publish_escape(Publish_Ring *r, Publish_Slot *slot);
+
+#endif
@@ -0,0 +1,499 @@
+#include "render.h"
+#include "cpu.h"
+#include "partition.h"
+#include "trace.h"
+
+struct Render_Handle {
+	Render_Backend backend;
+	Uint64 last_iters;
+
+	// GL backend
+	SDL_Window *window;		// Hidden window, if the handle made its own context
+	gl_frametex ftex;		// Scratch frametex for rendering into buffers
+	bool have_ftex;
+
+	// CPU backend
+	Pool *pool;
+	Uint8 *staging_colour;	// Only used to upload to frametexes
+	Uint32 *staging_escape;
+	Uint32 staging_pixels;
+
+	// Hybrid backend
+	gl_frametex gpu_ftex;	// The GPU's share of the frame, copied into place once done
+	bool have_gpu_ftex;
+	GLuint gpu_query;		// Times the GPU's share
+	Uint32 next_gpu_rows;	// Split to use for the next frame, or 0 to start from half
+	double gpu_rate;		// Smoothed pixel-iterations per ms
+	double cpu_rate;
+	Render_Split_Stats split;
+
+	// CPU and hybrid backends
+	Partition_Map history;	// Escape values of the last frame, to estimate the next one's cost from
+	Partition partition;	// How the last frame was cut up, or no regions if there was nothing to estimate from
+};
+
+static const char *__backend_names[RENDER_BACKEND_COUNT] = {
+	[RENDER_BACKEND_GL] = "gl",
+	[RENDER_BACKEND_CPU] = "cpu",
+	[RENDER_BACKEND_HYBRID] = "hybrid",
+};
+
+static bool __valid_target(const Render_Target *target) {
+	if (target == NULL || target->pixels == NULL) return false;
+	if (target->width == 0 || target->height == 0) return false;
+	if (target->stride % 4 != 0 || target->stride < target->width * 4) return false;
+	return true;
+}
+
+// Sets up the GL context, making a hidden one if nothing is current
+static bool __gl_setup(Render_Handle *h) {
+	if (SDL_GL_GetCurrentContext() != NULL) return true;
+
+	if (SDL_InitSubSystem(SDL_INIT_VIDEO) < 0) return false;
+	h->window = SDL_CreateWindow(
+		"Mandelbrot Renderer",
+		SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+		1, 1,
+		SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN
+	);
+	if (h->window == NULL) return false;
+
+	gl_init(4, 5, h->window);
+	return true;
+}
+
+// Makes sure the scratch frametex matches a target's size
+static void __gl_ensure_frametex(Render_Handle *h, Uint32 width, Uint32 height) {
+	if (h->have_ftex) {
+		if (h->ftex.w == width && h->ftex.h == height) return;
+		gl_destroy_frametex(h->ftex);
+	}
+	h->ftex = gl_create_frametex(width, height);
+	h->have_ftex = true;
+}
+
+// Resolves KERNEL_AUTO to the kernel that will actually run
+static Kernel_Id __gl_kernel(const Render_View *view, Uint32 width, Uint32 height) {
+	if (view->kernel != KERNEL_AUTO) return view->kernel;
+	return kernel_choose(view->screen_x, view->screen_y, view->zoom, width, height);
+}
+
+// Reads the scratch frametex back straight into the caller's rows
+static void __gl_read_back(Render_Handle *h, const Render_Target *target) {
+	GLuint tex = h->ftex.tex;
+	GLenum format = GL_RGBA;
+	GLenum type = GL_UNSIGNED_BYTE;
+	if (target->format == RENDER_FORMAT_ESCAPE) {
+		tex = h->ftex.escape;
+		format = GL_RED_INTEGER;
+		type = GL_UNSIGNED_INT;
+	}
+	GLsizei size = target->stride * (target->height - 1) + target->width * 4;
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glPixelStorei(GL_PACK_ROW_LENGTH, target->stride / 4);
+	glGetTextureImage(tex, 0, format, type, size, target->pixels);
+	glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+	gl_check_err("Failed to read back frame");
+}
+
+static int __gl_render_frame(Render_Handle *h, const Render_View *view, const Render_Target *target) {
+	Kernel_Id kernel = __gl_kernel(view, target->width, target->height);
+	if (!kernel_available(kernel)) return 1;
+	__gl_ensure_frametex(h, target->width, target->height);
+
+	kernel_read_iterations();
+	kernel_dispatch(kernel, h->ftex, view->screen_x, view->screen_y, view->zoom, view->iterations);
+	if (target->format == RENDER_FORMAT_RGBA8) colour_apply(view->colour, h->ftex, view->iterations);
+	h->last_iters = kernel_read_iterations();
+
+	__gl_read_back(h, target);
+	return 0;
+}
+
+// Makes sure the CPU staging buffers can hold a frame
+static void __cpu_ensure_staging(Render_Handle *h, Uint32 pixels) {
+	if (h->staging_pixels == pixels) return;
+	h->staging_colour = SDL_realloc(h->staging_colour, pixels * 4);
+	h->staging_escape = SDL_realloc(h->staging_escape, pixels * sizeof(Uint32));
+	h->staging_pixels = pixels;
+}
+
+// Whether a frame should replace the last one as what the next frame is estimated from.
+// Smaller frames that could be estimated from it (prefetch bands, progressive tiles)
+// would cover too little of the next one
+static bool __partition_keep(Render_Handle *h, bool estimated, Uint32 width, Uint32 height) {
+	return !estimated || (Uint64) width * height >= (Uint64) h->history.width * h->history.height;
+}
+
+// Renders on the CPU in bands of equal estimated cost, then keeps the escape values for the next frame
+static Uint64 __cpu_render_partitioned(Render_Handle *h, const Render_View *view, const Render_Target *colour, const Render_Target *escape) {
+	Partition_Estimate estimate;
+	Partition partition;
+	Uint64 iters;
+	bool estimated = partition_estimate(&h->history, view, escape->width, escape->height, &estimate);
+	if (estimated) {
+		partition_cut(&estimate, 0, pool_threads(h->pool) * RENDER_REGIONS_PER_THREAD, &partition);
+		partition_estimate_free(&estimate);
+		iters = cpu_render_bands(h->pool, view, colour, escape, partition.row_start, partition.regions);
+	} else {
+		iters = cpu_render(h->pool, view, colour, escape);
+	}
+
+	if (__partition_keep(h, estimated, escape->width, escape->height)) {
+		h->partition.regions = 0;
+		if (estimated) {
+			partition_measure(&partition, escape, view->iterations);
+			h->partition = partition;
+		}
+		partition_record(&h->history, view, escape);
+	}
+	return iters;
+}
+
+static int __cpu_render_frame(Render_Handle *h, const Render_View *view, const Render_Target *target) {
+	if (target->format == RENDER_FORMAT_ESCAPE) {
+		h->last_iters = __cpu_render_partitioned(h, view, NULL, target);
+		return 0;
+	}
+	if (view->colour == COLOUR_LINEAR) {
+		h->last_iters = cpu_render(h->pool, view, target, NULL);
+		return 0;
+	}
+
+	// Other colourings need the escape values of the whole frame first
+	__cpu_ensure_staging(h, target->width * target->height);
+	Render_Target escape = { h->staging_escape, target->width, target->height, target->width * 4, RENDER_FORMAT_ESCAPE };
+	h->last_iters = __cpu_render_partitioned(h, view, NULL, &escape);
+	cpu_colour_histogram(h->pool, &escape, target, view->iterations);
+	return 0;
+}
+
+static int __cpu_to_frametex(Render_Handle *h, const Render_View *view, gl_frametex ftex) {
+	__cpu_ensure_staging(h, ftex.w * ftex.h);
+
+	Render_Target colour = { h->staging_colour, ftex.w, ftex.h, ftex.w * 4, RENDER_FORMAT_RGBA8 };
+	Render_Target escape = { h->staging_escape, ftex.w, ftex.h, ftex.w * 4, RENDER_FORMAT_ESCAPE };
+	TRACE_BEGIN("cpu_render");
+	h->last_iters = __cpu_render_partitioned(h, view, &colour, &escape);
+	TRACE_END();
+
+	if (view->colour == COLOUR_HISTOGRAM) {
+		TRACE_BEGIN("cpu_histogram");
+		cpu_colour_histogram(h->pool, &escape, &colour, view->iterations);
+		TRACE_END();
+	}
+
+	TRACE_BEGIN("upload");
+	glTextureSubImage2D(ftex.tex, 0, 0, 0, ftex.w, ftex.h, GL_RGBA, GL_UNSIGNED_BYTE, h->staging_colour);
+	glTextureSubImage2D(ftex.escape, 0, 0, 0, ftex.w, ftex.h, GL_RED_INTEGER, GL_UNSIGNED_INT, h->staging_escape);
+	gl_check_err("Failed to upload CPU frame");
+	TRACE_END();
+
+	return 0;
+}
+
+// Picks how many rows from the top the GPU renders this frame
+static Uint32 __hybrid_gpu_rows(Render_Handle *h, Uint32 height, const Partition_Estimate *estimate) {
+	// Too small to be worth splitting
+	if (height < 2 * RENDER_HYBRID_ROW_STEP) return height;
+
+	// Knowing where this frame's cost is, split it in proportion to each side's throughput
+	Uint32 rows = h->next_gpu_rows;
+	if (estimate != NULL && h->gpu_rate > 0.0) rows = partition_row_at(estimate, h->gpu_rate / (h->gpu_rate + h->cpu_rate));
+	else if (rows == 0 || h->split.rows != height) rows = height / 2;
+	rows = (rows + RENDER_HYBRID_ROW_STEP / 2) / RENDER_HYBRID_ROW_STEP * RENDER_HYBRID_ROW_STEP;
+	return SDL_max(RENDER_HYBRID_ROW_STEP, SDL_min(rows, height - RENDER_HYBRID_ROW_STEP));
+}
+
+// Moves the split so each side's share of the work is in proportion to its throughput,
+// taking each side's rows to cost next frame what they averaged this frame
+static void __hybrid_adapt(Render_Handle *h, Uint64 gpu_iters, double gpu_ms, Uint64 cpu_iters, double cpu_ms) {
+	Render_Split_Stats *s = &h->split;
+	Uint32 cpu_rows = s->rows - s->gpu_rows;
+	if (s->gpu_rows == 0 || cpu_rows == 0 || gpu_ms <= 0.0 || cpu_ms <= 0.0) return;
+
+	double gpu_rate = SDL_max(gpu_iters, 1) / gpu_ms;
+	double cpu_rate = SDL_max(cpu_iters, 1) / cpu_ms;
+	if (h->gpu_rate == 0.0) {
+		h->gpu_rate = gpu_rate;
+		h->cpu_rate = cpu_rate;
+	} else {
+		h->gpu_rate += RENDER_HYBRID_SMOOTHING * (gpu_rate - h->gpu_rate);
+		h->cpu_rate += RENDER_HYBRID_SMOOTHING * (cpu_rate - h->cpu_rate);
+	}
+	s->gpu_giters_per_s = h->gpu_rate / 1.0e6;
+	s->cpu_giters_per_s = h->cpu_rate / 1.0e6;
+
+	double gpu_density = (double) SDL_max(gpu_iters, 1) / s->gpu_rows;
+	double cpu_density = (double) SDL_max(cpu_iters, 1) / cpu_rows;
+	double total = gpu_density * s->gpu_rows + cpu_density * cpu_rows;
+	double gpu_work = total * h->gpu_rate / (h->gpu_rate + h->cpu_rate);
+
+	double rows;
+	if (gpu_work <= gpu_density * s->gpu_rows) rows = gpu_work / gpu_density;
+	else rows = s->gpu_rows + (gpu_work - gpu_density * s->gpu_rows) / cpu_density;
+	h->next_gpu_rows = (Uint32) SDL_max(rows, 1.0);
+}
+
+// Renders the top of the frame on the GPU while the CPU renders the rest
+static int __hybrid_to_frametex(Render_Handle *h, const Render_View *view, gl_frametex ftex) {
+	Kernel_Id kernel = __gl_kernel(view, ftex.w, ftex.h);
+	if (!kernel_available(kernel)) return 1;
+
+	Partition_Estimate estimate;
+	bool estimated = partition_estimate(&h->history, view, ftex.w, ftex.h, &estimate);
+	Uint32 gpu_rows = __hybrid_gpu_rows(h, ftex.h, estimated ? &estimate : NULL);
+	Uint32 cpu_rows = ftex.h - gpu_rows;
+
+	// The GPU's rows are the first region, then the CPU's share is cut into bands of equal estimated cost
+	Partition partition;
+	Uint32 cpu_bands[PARTITION_MAX_REGIONS + 1];
+	Uint32 cpu_band_count = 0;
+	if (estimated) {
+		Uint32 row_start[PARTITION_MAX_REGIONS + 1] = { 0, ftex.h };
+		Uint32 regions = 1;
+		if (cpu_rows > 0) {
+			Uint32 bands = SDL_min(pool_threads(h->pool) * RENDER_REGIONS_PER_THREAD, PARTITION_MAX_REGIONS - 1);
+			partition_cut(&estimate, gpu_rows, bands, &partition);
+			cpu_band_count = partition.regions;
+			for (Uint32 i=0; i<=cpu_band_count; i++) {
+				row_start[i + 1] = partition.row_start[i];
+				cpu_bands[i] = partition.row_start[i] - gpu_rows;
+			}
+			regions += cpu_band_count;
+		}
+		partition_bands(&estimate, row_start, regions, &partition);
+		partition_estimate_free(&estimate);
+	}
+	double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+	Uint64 start = SDL_GetPerformanceCounter();
+
+	// Start the GPU's share first, so it runs while the CPU works
+	if (!h->have_gpu_ftex || h->gpu_ftex.w != ftex.w || h->gpu_ftex.h != gpu_rows) {
+		if (h->have_gpu_ftex) gl_destroy_frametex(h->gpu_ftex);
+		h->gpu_ftex = gl_create_frametex(ftex.w, gpu_rows);
+		h->have_gpu_ftex = true;
+	}
+	double gpu_y = view->screen_y - (gpu_rows / 2.0 - ftex.h / 2.0) / view->zoom;
+	TRACE_BEGIN("gpu_share");
+	glBeginQuery(GL_TIME_ELAPSED, h->gpu_query);
+	kernel_dispatch(kernel, h->gpu_ftex, view->screen_x, gpu_y, view->zoom, view->iterations);
+	glEndQuery(GL_TIME_ELAPSED);
+	GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+	TRACE_END();
+
+	// Then the CPU's, straight into the staging buffers. Software GL drivers
+	// can do the GPU's work inside the flush, so the CPU's time starts here
+	Uint64 cpu_start = SDL_GetPerformanceCounter();
+	double submit_ms = (cpu_start - start) / ticks_per_ms;
+	Uint64 cpu_iters = 0;
+	double cpu_ms = 0.0;
+	if (cpu_rows > 0) {
+		__cpu_ensure_staging(h, ftex.w * cpu_rows);
+		Render_View cpu_view = *view;
+		cpu_view.screen_y = view->screen_y - (gpu_rows + cpu_rows / 2.0 - ftex.h / 2.0) / view->zoom;
+		Render_Target colour = { h->staging_colour, ftex.w, cpu_rows, ftex.w * 4, RENDER_FORMAT_RGBA8 };
+		Render_Target escape = { h->staging_escape, ftex.w, cpu_rows, ftex.w * 4, RENDER_FORMAT_ESCAPE };
+
+		TRACE_BEGIN("cpu_share");
+		cpu_iters = cpu_render_bands(h->pool, &cpu_view, &colour, &escape, (cpu_band_count > 0) ? cpu_bands : NULL, cpu_band_count);
+		cpu_ms = (SDL_GetPerformanceCounter() - cpu_start) / ticks_per_ms;
+		TRACE_END();
+
+		TRACE_BEGIN("upload");
+		glTextureSubImage2D(ftex.tex, 0, 0, gpu_rows, ftex.w, cpu_rows, GL_RGBA, GL_UNSIGNED_BYTE, h->staging_colour);
+		glTextureSubImage2D(ftex.escape, 0, 0, gpu_rows, ftex.w, cpu_rows, GL_RED_INTEGER, GL_UNSIGNED_INT, h->staging_escape);
+		TRACE_END();
+	}
+
+	TRACE_BEGIN("wait_gpu");
+	bool gpu_was_busy = glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED;
+	glDeleteSync(fence);
+	Uint64 gpu_iters = kernel_read_iterations();
+	double frame_ms = (SDL_GetPerformanceCounter() - start) / ticks_per_ms;
+	TRACE_END();
+
+	// If the GPU outlasted the CPU, it was busy the whole frame. Otherwise the wall clock
+	// can't say when it finished, so trust the timer query as far as it's believable
+	// (timer queries aren't reliable on every driver)
+	double gpu_ms = frame_ms;
+	if (!gpu_was_busy) {
+		GLuint64 gpu_ns = 0;
+		glGetQueryObjectui64v(h->gpu_query, GL_QUERY_RESULT, &gpu_ns);
+		gpu_ms = SDL_max(gpu_ns / 1.0e6, submit_ms);
+		if (gpu_ms <= 0.0 || gpu_ms > frame_ms) gpu_ms = frame_ms;
+	}
+
+	glCopyImageSubData(h->gpu_ftex.tex, GL_TEXTURE_2D, 0, 0, 0, 0, ftex.tex, GL_TEXTURE_2D, 0, 0, 0, 0, ftex.w, gpu_rows, 1);
+	glCopyImageSubData(h->gpu_ftex.escape, GL_TEXTURE_2D, 0, 0, 0, 0, ftex.escape, GL_TEXTURE_2D, 0, 0, 0, 0, ftex.w, gpu_rows, 1);
+	colour_apply(view->colour, ftex, view->iterations);
+	gl_check_err("Failed to merge hybrid frame");
+
+	// Keep the whole frame's escape values for the next frame, reading back the GPU's share
+	if (__partition_keep(h, estimated, ftex.w, ftex.h)) {
+		TRACE_BEGIN("partition");
+		h->partition.regions = 0;
+		Uint32 *escapes = partition_map_buffer(&h->history, view, ftex.w, ftex.h);
+		if (escapes != NULL) {
+			glGetTextureImage(h->gpu_ftex.escape, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, ftex.w * gpu_rows * sizeof(Uint32), escapes);
+			if (cpu_rows > 0) SDL_memcpy(escapes + (size_t) ftex.w * gpu_rows, h->staging_escape, (size_t) ftex.w * cpu_rows * sizeof(Uint32));
+			Render_Target frame = { escapes, ftex.w, ftex.h, ftex.w * 4, RENDER_FORMAT_ESCAPE };
+			if (estimated) {
+				partition_measure(&partition, &frame, view->iterations);
+				h->partition = partition;
+			}
+		}
+		TRACE_END();
+	}
+
+	h->last_iters = gpu_iters + cpu_iters;
+	h->split.gpu_rows = gpu_rows;
+	h->split.rows = ftex.h;
+	h->split.gpu_ms = gpu_ms;
+	h->split.cpu_ms = cpu_ms;
+	h->split.gpu_idle_ms = frame_ms - gpu_ms;
+	h->split.cpu_idle_ms = (cpu_rows > 0) ? frame_ms - cpu_ms : 0.0;
+	__hybrid_adapt(h, gpu_iters, gpu_ms, cpu_iters, cpu_ms);
+	return 0;
+}
+
+
+Render_Handle *render_create(Render_Backend backend) {
+	Render_Handle *h = SDL_calloc(1, sizeof(Render_Handle));
+	h->backend = backend;
+
+	switch (backend) {
+		case RENDER_BACKEND_GL: {
+			if (!__gl_setup(h)) {
+				printf("[ERROR] Failed to set up GL renderer: %s\n", SDL_GetError());
+				render_destroy(h);
+				return NULL;
+			}
+			kernel_load_all();
+		} break;
+
+		case RENDER_BACKEND_CPU: {
+			h->pool = pool_create(0);
+		} break;
+
+		case RENDER_BACKEND_HYBRID: {
+			if (!__gl_setup(h)) {
+				printf("[ERROR] Failed to set up GL renderer: %s\n", SDL_GetError());
+				render_destroy(h);
+				return NULL;
+			}
+			kernel_load_all();
+			glCreateQueries(GL_TIME_ELAPSED, 1, &h->gpu_query);
+			h->pool = pool_create(0);
+		} break;
+
+		default: {
+			SDL_free(h);
+			return NULL;
+		}
+	}
+
+	return h;
+}
+
+void render_destroy(Render_Handle *h) {
+	if (h == NULL) return;
+
+	if (h->have_ftex) gl_destroy_frametex(h->ftex);
+	if (h->have_gpu_ftex) gl_destroy_frametex(h->gpu_ftex);
+	if (h->gpu_query != 0) glDeleteQueries(1, &h->gpu_query);
+	if (h->window != NULL) {
+		colour_term();
+		kernel_term();
+		gl_term();
+		SDL_DestroyWindow(h->window);
+		SDL_QuitSubSystem(SDL_INIT_VIDEO);
+	}
+
+	pool_destroy(h->pool);
+	partition_map_free(&h->history);
+	SDL_free(h->staging_colour);
+	SDL_free(h->staging_escape);
+	SDL_free(h);
+}
+
+void render_set_threads(Render_Handle *h, int threads) {
+	if (h == NULL || h->pool == NULL) return;
+	pool_destroy(h->pool);
+	h->pool = pool_create(threads);
+}
+
+Render_Backend render_backend(Render_Handle *h) {
+	return h->backend;
+}
+
+const char *render_backend_name(Render_Backend backend) {
+	if (backend >= RENDER_BACKEND_COUNT) return "(none)";
+	return __backend_names[backend];
+}
+
+int render_frame(Render_Handle *h, const Render_View *view, const Render_Target *target) {
+	if (h == NULL || view == NULL || !__valid_target(target)) return 1;
+
+	switch (h->backend) {
+		case RENDER_BACKEND_GL: return __gl_render_frame(h, view, target);
+
+		case RENDER_BACKEND_CPU: return __cpu_render_frame(h, view, target);
+
+		case RENDER_BACKEND_HYBRID: {
+			__gl_ensure_frametex(h, target->width, target->height);
+			Render_View hybrid_view = *view;
+			if (target->format == RENDER_FORMAT_ESCAPE) hybrid_view.colour = COLOUR_LINEAR;
+			if (__hybrid_to_frametex(h, &hybrid_view, h->ftex) != 0) return 1;
+			__gl_read_back(h, target);
+			return 0;
+		}
+
+		default: return 1;
+	}
+}
+
+int render_to_frametex(Render_Handle *h, const Render_View *view, gl_frametex ftex) {
+	if (h == NULL || view == NULL) return 1;
+
+	switch (h->backend) {
+		case RENDER_BACKEND_GL: {
+			Kernel_Id kernel = __gl_kernel(view, ftex.w, ftex.h);
+			if (!kernel_available(kernel)) return 1;
+			kernel_dispatch(kernel, ftex, view->screen_x, view->screen_y, view->zoom, view->iterations);
+			colour_apply(view->colour, ftex, view->iterations);
+			h->last_iters = kernel_poll_iterations();
+			return 0;
+		}
+
+		case RENDER_BACKEND_CPU: return __cpu_to_frametex(h, view, ftex);
+
+		case RENDER_BACKEND_HYBRID: return __hybrid_to_frametex(h, view, ftex);
+
+		default: return 1;
+	}
+}
+
+Uint64 render_last_iterations(Render_Handle *h) {
+	return h->last_iters;
+}
+
+Render_Split_Stats render_split_stats(Render_Handle *h) {
+	return h->split;
+}
+
+void render_dump_split(Render_Handle *h, FILE *f) {
+	const Render_Split_Stats *s = &h->split;
+	if (s->rows == 0) {
+		fprintf(f, "---> No hybrid frames yet\n");
+		return;
+	}
+	fprintf(f, "---> Hybrid split: GPU %u rows (%.1lf%%), CPU %u rows\n", s->gpu_rows, 100.0 * s->gpu_rows / s->rows, s->rows - s->gpu_rows);
+	fprintf(f, "      GPU %.2lf ms busy, %.2lf ms idle, %.3lf Giter/s\n", s->gpu_ms, s->gpu_idle_ms, s->gpu_giters_per_s);
+	fprintf(f, "      CPU %.2lf ms busy, %.2lf ms idle, %.3lf Giter/s\n", s->cpu_ms, s->cpu_idle_ms, s->cpu_giters_per_s);
+}
+
+void render_dump_partition(Render_Handle *h, FILE *f) {
+	partition_print(&h->partition, f);
+}
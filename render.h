@@ -0,0 +1,145 @@
+//	
+//	Embeddable renderer
+//	
+//	Renders views of the mandelbrot set into caller-owned buffers,
+//	so batch tools and servers can use the renderer without the
+//	interactive app. The backend (GL compute, CPU threads or both) is
+//	picked once when the handle is created, and the handle keeps its
+//	GL context, compiled kernels or worker threads warm between calls.
+//	
+//	The hybrid backend splits each frame between the two: the GPU
+//	renders the top rows while the CPU threads render the rest. After
+//	every frame, each side's pixel-iterations/s is measured, and the
+//	split for the next frame is moved so that each side gets work in
+//	proportion to its throughput, and both finish at about the same time.
+//	
+//	The CPU and hybrid backends keep each frame's escape values, and
+//	cut the next frame up by the cost they predict for it (see
+//	partition.h): the CPU renders bands of equal estimated cost, and
+//	the hybrid split is put where the estimated cost divides in
+//	proportion to each side's throughput.
+//	
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#include "gl.h"
+#include "kernel.h"
+#include "colour.h"
+
+#define RENDER_INTERIOR 0	// Escape value of points that never escaped
+#define RENDER_HYBRID_ROW_STEP 16		// The hybrid split moves in steps of this many rows, and leaves each side at least this many
+#define RENDER_HYBRID_SMOOTHING 0.5		// Weight of the newest frame in the measured throughputs
+#define RENDER_REGIONS_PER_THREAD 4		// Bands of equal estimated cost the CPU renders per thread, to absorb misestimates
+
+
+typedef enum {
+	RENDER_BACKEND_GL,
+	RENDER_BACKEND_CPU,
+	RENDER_BACKEND_HYBRID,	// GL and CPU together, splitting each frame between them
+	RENDER_BACKEND_COUNT,
+} Render_Backend;
+
+typedef enum {
+	RENDER_FORMAT_RGBA8,	// 4 bytes per pixel: red, green, blue, alpha
+	RENDER_FORMAT_ESCAPE,	// One Uint32 per pixel: iteration it escaped at (from 1), or RENDER_INTERIOR
+} Render_Format;
+
+typedef struct {
+	double screen_x;	// Centre of the view on the complex plane
+	double screen_y;
+	double zoom;		// Pixels per unit on the complex plane
+	Uint32 iterations;
+	Kernel_Id kernel;	// Number format used by the GL backend (or KERNEL_AUTO); the CPU uses doubles unless it's KERNEL_DFLOAT
+	Colour_Mode colour;
+} Render_View;
+
+typedef struct {
+	void *pixels;		// Row 0 is the top of the view
+	Uint32 width;
+	Uint32 height;
+	Uint32 stride;		// Bytes from one row to the next; must be a multiple of 4
+	Render_Format format;
+} Render_Target;
+
+// How the hybrid backend split its last frame
+typedef struct {
+	Uint32 gpu_rows;		// Rows from the top rendered on the GPU; the rest were rendered on the CPU
+	Uint32 rows;
+	double gpu_ms;			// Time each side spent rendering its part
+	double cpu_ms;
+	double gpu_idle_ms;		// Time each side spent waiting for the other to finish
+	double cpu_idle_ms;
+	double gpu_giters_per_s;	// Smoothed throughputs the next split is based on
+	double cpu_giters_per_s;
+} Render_Split_Stats;
+
+typedef struct Render_Handle Render_Handle;
+
+
+//	Creates a renderer with the given backend
+//	
+//	The GL backend uses the GL context that is current on the calling
+//	thread if there is one, otherwise it creates its own hidden one.
+//	All kernels are compiled up front.
+//	Returns NULL if the backend couldn't be set up.
+//	Should be cleaned up with `render_destroy()`
+Render_Handle *render_create(Render_Backend backend);
+
+//	Frees a renderer along with any context or threads it created
+//	
+void render_destroy(Render_Handle *h);
+
+//	Sets how many threads the CPU (or hybrid) backend renders with
+//	
+//	0 or less means one per CPU core (the default). Does nothing for
+//	the GL backend.
+void render_set_threads(Render_Handle *h, int threads);
+
+//	Gets the backend a renderer was created with
+//	
+Render_Backend render_backend(Render_Handle *h);
+
+//	Gets the short name of a backend (e.g. "gl")
+//	
+const char *render_backend_name(Render_Backend backend);
+
+//	Renders a view straight into a caller-owned buffer
+//	
+//	The target's size decides the size of the frame.
+//	Returns 0 on success, 1 otherwise.
+int render_frame(Render_Handle *h, const Render_View *view, const Render_Target *target);
+
+//	Renders a view into both images of a frametex, for display
+//	
+//	Needs the GL context that owns the frametex to be current, even
+//	for the CPU backend, whose results are uploaded to it. The GL
+//	backend only queues the frame, without waiting for the GPU.
+//	Returns 0 on success, 1 otherwise.
+int render_to_frametex(Render_Handle *h, const Render_View *view, gl_frametex ftex);
+
+//	Gets the number of pixel-iterations the last render performed
+//	
+//	After the GL backend's `render_to_frametex()` this is the count of
+//	earlier frames the GPU has finished since, so it lags a frame behind.
+Uint64 render_last_iterations(Render_Handle *h);
+
+//	Gets how the hybrid backend split its last frame
+//	
+//	Everything is 0 for other backends, or before the first frame.
+Render_Split_Stats render_split_stats(Render_Handle *h);
+
+//	Prints how the hybrid backend split its last frame to a file (e.g. stdout)
+//	
+void render_dump_split(Render_Handle *h, FILE *f);
+
+//	Prints the estimated against the measured cost of each region of the last frame to a file (e.g. stdout)
+//	
+//	Only the CPU and hybrid backends partition their frames by cost.
+void render_dump_partition(Render_Handle *h, FILE *f);
+
+#endif
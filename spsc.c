@@ -0,0 +1,63 @@
+#include "spsc.h"
+
+#define CACHE_LINE 64
+
+struct Spsc_Queue {
+	// Counts of items ever pushed and popped, kept on their own cache lines so the two threads don't fight over them
+	SDL_atomic_t head;
+	Uint8 pad_head[CACHE_LINE - sizeof(SDL_atomic_t)];
+	SDL_atomic_t tail;
+	Uint8 pad_tail[CACHE_LINE - sizeof(SDL_atomic_t)];
+
+	Uint32 mask;		// Capacity - 1
+	size_t item_size;
+	Uint8 *items;
+};
+
+
+Spsc_Queue *spsc_create(Uint32 capacity, size_t item_size) {
+	if (capacity == 0 || capacity > (1u << 30) || item_size == 0) return NULL;
+	Uint32 size = 1;
+	while (size < capacity) size <<= 1;
+
+	Spsc_Queue *q = SDL_calloc(1, sizeof(Spsc_Queue));
+	if (q == NULL) return NULL;
+	q->items = SDL_malloc(size * item_size);
+	if (q->items == NULL) {
+		SDL_free(q);
+		return NULL;
+	}
+	q->mask = size - 1;
+	q->item_size = item_size;
+	SDL_AtomicSet(&q->head, 0);
+	SDL_AtomicSet(&q->tail, 0);
+	return q;
+}
+
+void spsc_destroy(Spsc_Queue *q) {
+	if (q == NULL) return;
+	SDL_free(q->items);
+	SDL_free(q);
+}
+
+bool spsc_push(Spsc_Queue *q, const void *item) {
+	Uint32 head = (Uint32) SDL_AtomicGet(&q->head);
+	Uint32 tail = (Uint32) SDL_AtomicGet(&q->tail);
+	if (head - tail > q->mask) return false;
+
+	// The item has to be written before the consumer can see the new head
+	SDL_memcpy(q->items + (head & q->mask) * q->item_size, item, q->item_size);
+	SDL_AtomicSet(&q->head, (int)(head + 1));
+	return true;
+}
+
+bool spsc_pop(Spsc_Queue *q, void *item) {
+	Uint32 tail = (Uint32) SDL_AtomicGet(&q->tail);
+	Uint32 head = (Uint32) SDL_AtomicGet(&q->head);
+	if (head == tail) return false;
+
+	// Likewise, the slot is only handed back to the producer once it's been read
+	SDL_memcpy(item, q->items + (tail & q->mask) * q->item_size, q->item_size);
+	SDL_AtomicSet(&q->tail, (int)(tail + 1));
+	return true;
+}
@@ -0,0 +1,42 @@
+//	
+//	Lock-free single-producer/single-consumer queue
+//	
+//	A fixed ring of equally sized items, for handing data from one
+//	thread to exactly one other. Each side only ever writes its own
+//	index and reads the other's atomically, so there are no locks and
+//	neither side waits on the other: pushing to a full queue or
+//	popping from an empty one just fails.
+//	
+
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+
+typedef struct Spsc_Queue Spsc_Queue;
+
+
+//	Creates a queue holding up to `capacity` items of `item_size` bytes
+//	
+//	`capacity` is rounded up to a power of two.
+//	Returns NULL on error.
+//	Should be cleaned up with `spsc_destroy()`
+Spsc_Queue *spsc_create(Uint32 capacity, size_t item_size);
+
+//	Frees a queue and any items still in it
+//	
+void spsc_destroy(Spsc_Queue *q);
+
+//	Copies an item onto the back of the queue (producer thread only)
+//	
+//	Returns false if the queue is full.
+bool spsc_push(Spsc_Queue *q, const void *item);
+
+//	Copies the item at the front of the queue out and removes it (consumer thread only)
+//	
+//	Returns false if the queue is empty.
+bool spsc_pop(Spsc_Queue *q, void *item);
+
+#endif
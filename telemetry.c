@@ -0,0 +1,119 @@
+#include "telemetry.h"
+
+static Telemetry_Frame __ring[TELEMETRY_RING_SIZE];
+static Uint32 __ring_next = 0;
+static Uint32 __ring_len = 0;
+static Uint32 __frames_since_log = 0;
+
+static int __cmp_double(const void *a, const void *b) {
+	double da = *(const double *) a;
+	double db = *(const double *) b;
+	return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of an already sorted array
+static double __percentile(double *sorted, Uint32 len, double pct) {
+	if (len == 0) return 0.0;
+	int index = (int) SDL_ceil(pct / 100.0 * len) - 1;
+	if (index < 0) index = 0;
+	return sorted[index];
+}
+
+
+Uint64 telemetry_frame_begin() {
+	return SDL_GetPerformanceCounter();
+}
+
+void telemetry_frame_end(Uint64 ts_begin, Uint64 pixel_iters) {
+	Uint64 ts_end = SDL_GetPerformanceCounter();
+	double ms = (ts_end - ts_begin) * 1000.0 / SDL_GetPerformanceFrequency();
+
+	__ring[__ring_next] = (Telemetry_Frame){
+		.frame_ms = ms,
+		.pixel_iters = pixel_iters,
+	};
+	__ring_next = (__ring_next + 1) % TELEMETRY_RING_SIZE;
+	if (__ring_len < TELEMETRY_RING_SIZE) __ring_len++;
+	__frames_since_log++;
+}
+
+Telemetry_Stats telemetry_stats() {
+	Telemetry_Stats stats;
+	SDL_zero(stats);
+	stats.frames = __ring_len;
+	if (__ring_len == 0) return stats;
+
+	double sorted[TELEMETRY_RING_SIZE];
+	double total_ms = 0.0;
+	double total_iters = 0.0;
+	for (Uint32 i=0; i<__ring_len; i++) {
+		double ms = __ring[i].frame_ms;
+		sorted[i] = ms;
+		total_ms += ms;
+		total_iters += (double) __ring[i].pixel_iters;
+
+		// Bucket b holds frames from 2^(b-1) to 2^b ms, the last one everything slower
+		int bucket = 0;
+		while (bucket < TELEMETRY_HIST_BUCKETS - 1 && ms >= (double)(1 << bucket)) bucket++;
+		stats.histogram[bucket]++;
+	}
+	SDL_qsort(sorted, __ring_len, sizeof(double), __cmp_double);
+
+	stats.p50_ms = __percentile(sorted, __ring_len, 50.0);
+	stats.p90_ms = __percentile(sorted, __ring_len, 90.0);
+	stats.p99_ms = __percentile(sorted, __ring_len, 99.0);
+	stats.max_ms = sorted[__ring_len - 1];
+	stats.mean_ms = total_ms / __ring_len;
+	stats.iters_per_frame = total_iters / __ring_len;
+	if (total_ms > 0.0) stats.giters_per_s = total_iters / (total_ms / 1000.0) / 1.0e9;
+
+	return stats;
+}
+
+void telemetry_dump(FILE *f) {
+	Telemetry_Stats stats = telemetry_stats();
+	fprintf(f, "---> Frame times over last %u frames:\n", stats.frames);
+	if (stats.frames == 0) {
+		fflush(f);
+		return;
+	}
+
+	fprintf(f, "      p50 %.3lf ms | p90 %.3lf ms | p99 %.3lf ms | max %.3lf ms | mean %.3lf ms\n",
+		stats.p50_ms, stats.p90_ms, stats.p99_ms, stats.max_ms, stats.mean_ms
+	);
+	fprintf(f, "      %.0lf pixel-iterations/frame, %.4lf Giter/s\n", stats.iters_per_frame, stats.giters_per_s);
+
+	// Histogram with bars scaled to the fullest bucket
+	Uint32 most = 1;
+	for (int b=0; b<TELEMETRY_HIST_BUCKETS; b++) if (stats.histogram[b] > most) most = stats.histogram[b];
+	for (int b=0; b<TELEMETRY_HIST_BUCKETS; b++) {
+		if (b == TELEMETRY_HIST_BUCKETS - 1) {
+			fprintf(f, "      %6i+    ms: ", 1 << (b - 1));
+		} else {
+			fprintf(f, "      %6g-%-4i ms: ", (b == 0) ? 0.0 : (double)(1 << (b - 1)), 1 << b);
+		}
+		int bar = (int)(40.0 * stats.histogram[b] / most);
+		for (int i=0; i<bar; i++) fputc('#', f);
+		fprintf(f, " %u\n", stats.histogram[b]);
+	}
+	fflush(f);
+}
+
+void telemetry_tick() {
+	static Uint64 ts_last_log = 0;
+
+	Uint64 now = SDL_GetTicks64();
+	if (ts_last_log == 0) ts_last_log = now;
+	if (now - ts_last_log < TELEMETRY_LOG_INTERVAL) return;
+	ts_last_log = now;
+
+	// Nothing new to report
+	if (__frames_since_log == 0) return;
+	__frames_since_log = 0;
+
+	FILE *f = fopen(TELEMETRY_LOG_FILENAME, "a");
+	if (f == NULL) return;
+	fprintf(f, "=== %llu ms ===\n", (unsigned long long) now);
+	telemetry_dump(f);
+	fclose(f);
+}
@@ -0,0 +1,63 @@
+//	
+//	Frame-time and iteration-throughput telemetry
+//	
+//	Keeps a ring buffer of high-resolution per-frame timings and
+//	pixel-iteration counts, from which frame time percentiles, a
+//	frame time histogram and the Giga-iterations/s rate are worked out.
+//	
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#define TELEMETRY_RING_SIZE 1024			// Number of recent frames kept
+#define TELEMETRY_HIST_BUCKETS 10			// Frame time histogram buckets, doubling from 1 ms
+#define TELEMETRY_LOG_FILENAME "telemetry.log"
+#define TELEMETRY_LOG_INTERVAL 10000		// ms between periodic dumps to the log file
+
+
+typedef struct {
+	double frame_ms;
+	Uint64 pixel_iters;
+} Telemetry_Frame;
+
+typedef struct {
+	Uint32 frames;			// Number of frames the stats were taken over
+	double p50_ms;
+	double p90_ms;
+	double p99_ms;
+	double max_ms;
+	double mean_ms;
+	double iters_per_frame;	// Mean pixel-iterations per frame
+	double giters_per_s;	// Total pixel-iterations over total frame time
+	Uint32 histogram[TELEMETRY_HIST_BUCKETS];
+} Telemetry_Stats;
+
+
+//	Gets a high-resolution timestamp for the start of a frame
+//	
+Uint64 telemetry_frame_begin();
+
+//	Records a finished frame
+//	
+//	Takes the timestamp from `telemetry_frame_begin()` and the
+//	number of pixel-iterations the kernels performed for the frame.
+void telemetry_frame_end(Uint64 ts_begin, Uint64 pixel_iters);
+
+//	Works out the stats over the frames currently in the ring buffer
+//	
+Telemetry_Stats telemetry_stats();
+
+//	Prints the current stats and histogram to a file (e.g. stdout)
+//	
+void telemetry_dump(FILE *f);
+
+//	Appends the stats to the log file if the log interval has passed
+//	
+//	Should be called once per main loop iteration.
+void telemetry_tick();
+
+#endif
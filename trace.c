@@ -0,0 +1,191 @@
+#include "trace.h"
+
+typedef struct {
+	const char *name;
+	Uint64 ts_begin;
+	Uint64 ts_end;
+} Trace_Span;
+
+typedef struct Trace_Buffer {
+	struct Trace_Buffer *next;	// Next buffer in the global list
+	SDL_atomic_t owned;			// Cleared when the owning thread exits, so another can take the buffer over
+	Uint32 tid;
+	SDL_atomic_t count;			// Published with release order by the owning thread
+	SDL_atomic_t generation;	// Trace the buffer's contents belong to
+	SDL_atomic_t dropped;
+	Uint32 depth;
+	Uint64 open[TRACE_MAX_DEPTH];
+	const char *open_names[TRACE_MAX_DEPTH];
+	Trace_Span spans[TRACE_SPANS_PER_THREAD];
+} Trace_Buffer;
+
+static void *__buffers = NULL;	// Lock-free list of every thread's buffer
+static SDL_atomic_t __next_tid = { 1 };
+static SDL_atomic_t __generation = { 0 };
+static Uint64 __ts_start = 0;
+static SDL_TLSID __tls_buffer = 0;	// Each thread's buffer, released when the thread exits
+
+// Gives up a buffer when its thread exits, keeping what it recorded for trace_stop()
+static void __release_buffer(void *ptr) {
+	Trace_Buffer *buf = (Trace_Buffer *) ptr;
+	if (buf != NULL) SDL_AtomicSet(&buf->owned, 0);
+}
+
+// Takes over the buffer of a thread that has exited, if one holds nothing the current trace needs
+static Trace_Buffer *__reuse_buffer(Uint32 generation) {
+	for (Trace_Buffer *buf = SDL_AtomicGetPtr(&__buffers); buf != NULL; buf = buf->next) {
+		if (SDL_AtomicGet(&buf->owned)) continue;
+		if ((Uint32) SDL_AtomicGet(&buf->generation) == generation && SDL_AtomicGet(&buf->count) > 0) continue;
+		if (!SDL_AtomicCAS(&buf->owned, 0, 1)) continue;
+
+		// Taken over as if new (the count is reset before the generation, as below)
+		buf->depth = 0;
+		SDL_AtomicSet(&buf->dropped, 0);
+		SDL_AtomicSet(&buf->count, 0);
+		buf->tid = (Uint32) SDL_AtomicAdd(&__next_tid, 1);
+		SDL_AtomicSet(&buf->generation, (int) generation);
+		return buf;
+	}
+	return NULL;
+}
+
+SDL_atomic_t trace_enabled = { 0 };
+
+// Gets the calling thread's buffer, creating and publishing it on first use
+static Trace_Buffer *__thread_buffer() {
+	Trace_Buffer *buf = SDL_TLSGet(__tls_buffer);
+	Uint32 generation = (Uint32) SDL_AtomicGet(&__generation);
+
+	if (buf == NULL) {
+		buf = __reuse_buffer(generation);
+		if (buf == NULL) {
+			buf = SDL_calloc(1, sizeof(Trace_Buffer));
+			if (buf == NULL) return NULL;
+			SDL_AtomicSet(&buf->owned, 1);
+			buf->tid = (Uint32) SDL_AtomicAdd(&__next_tid, 1);
+			SDL_AtomicSet(&buf->generation, (int) generation);
+
+			void *head;
+			do {
+				head = SDL_AtomicGetPtr(&__buffers);
+				buf->next = head;
+			} while (!SDL_AtomicCASPtr(&__buffers, head, buf));
+		}
+		SDL_TLSSet(__tls_buffer, buf, __release_buffer);
+	}
+
+	// A new trace was started since this thread last recorded
+	// (the count is reset before the generation is, so trace_stop() never sees the old spans as new ones)
+	if ((Uint32) SDL_AtomicGet(&buf->generation) != generation) {
+		buf->depth = 0;
+		SDL_AtomicSet(&buf->dropped, 0);
+		SDL_AtomicSet(&buf->count, 0);
+		SDL_AtomicSet(&buf->generation, (int) generation);
+	}
+
+	return buf;
+}
+
+static double __to_us(Uint64 ts) {
+	if (ts < __ts_start) return 0.0;
+	return (ts - __ts_start) * 1.0e6 / SDL_GetPerformanceFrequency();
+}
+
+
+void trace_start() {
+	if (__tls_buffer == 0) __tls_buffer = SDL_TLSCreate();
+	SDL_AtomicAdd(&__generation, 1);
+	__ts_start = SDL_GetPerformanceCounter();
+	SDL_AtomicSet(&trace_enabled, 1);
+}
+
+int trace_stop(const char *filename) {
+	SDL_AtomicSet(&trace_enabled, 0);
+	if (filename == NULL) return 1;
+
+	FILE *f = fopen(filename, "w");
+	if (f == NULL) return 1;
+
+	Uint32 generation = (Uint32) SDL_AtomicGet(&__generation);
+	Uint32 written = 0;
+	Uint32 dropped = 0;
+
+	fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (Trace_Buffer *buf = SDL_AtomicGetPtr(&__buffers); buf != NULL; buf = buf->next) {
+		if ((Uint32) SDL_AtomicGet(&buf->generation) != generation) continue;
+
+		// Only read what the owning thread has published
+		int count = SDL_AtomicGet(&buf->count);
+		SDL_MemoryBarrierAcquire();
+		dropped += (Uint32) SDL_AtomicGet(&buf->dropped);
+
+		fprintf(f, "%s\t{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"thread %u\"}}",
+			(written > 0) ? ",\n" : "", buf->tid, buf->tid
+		);
+		written++;
+
+		for (int i=0; i<count; i++) {
+			Trace_Span *span = &buf->spans[i];
+			double ts = __to_us(span->ts_begin);
+			double dur = __to_us(span->ts_end) - ts;
+			fprintf(f, ",\n\t{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3lf, \"dur\": %.3lf}",
+				span->name, buf->tid, ts, dur
+			);
+		}
+	}
+	fprintf(f, "\n]}\n");
+	fclose(f);
+
+	if (dropped > 0) printf("[WARN ] Trace buffers were full, %u spans were dropped\n", dropped);
+	fflush(stdout);
+	return 0;
+}
+
+void trace_begin(const char *name) {
+	Trace_Buffer *buf = __thread_buffer();
+	if (buf == NULL) return;
+	if (buf->depth >= TRACE_MAX_DEPTH) {
+		buf->depth++;
+		return;
+	}
+
+	buf->open_names[buf->depth] = name;
+	buf->open[buf->depth] = SDL_GetPerformanceCounter();
+	buf->depth++;
+}
+
+void trace_end() {
+	Trace_Buffer *buf = __thread_buffer();
+	if (buf == NULL || buf->depth == 0) return;	// Tracing was started inside this span
+
+	buf->depth--;
+	if (buf->depth >= TRACE_MAX_DEPTH) return;
+
+	int count = SDL_AtomicGet(&buf->count);
+	if (count >= TRACE_SPANS_PER_THREAD) {
+		SDL_AtomicAdd(&buf->dropped, 1);
+		return;
+	}
+
+	buf->spans[count] = (Trace_Span){
+		.name = buf->open_names[buf->depth],
+		.ts_begin = buf->open[buf->depth],
+		.ts_end = SDL_GetPerformanceCounter(),
+	};
+
+	// Publish the span to trace_stop()
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&buf->count, count + 1);
+}
+
+void trace_term() {
+	SDL_AtomicSet(&trace_enabled, 0);
+	Trace_Buffer *buf = SDL_AtomicGetPtr(&__buffers);
+	SDL_AtomicSetPtr(&__buffers, NULL);
+	while (buf != NULL) {
+		Trace_Buffer *next = buf->next;
+		SDL_free(buf);
+		buf = next;
+	}
+	if (__tls_buffer != 0) SDL_TLSSet(__tls_buffer, NULL, NULL);
+}
@@ -0,0 +1,57 @@
+//	
+//	Lightweight span tracing in the Chrome trace-event format
+//	
+//	Spans are recorded into a per-thread buffer with no locking, and
+//	can be flushed to a JSON file that loads into Perfetto or
+//	chrome://tracing. While tracing is off, each span costs one atomic
+//	load and a branch.
+//	
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+#define TRACE_SPANS_PER_THREAD 65536	// Spans each thread can record before dropping
+#define TRACE_MAX_DEPTH 32				// Maximum nesting of spans on one thread
+#define TRACE_FILENAME "trace.json"
+
+//	Marks the start and end of a span
+//	
+//	`name` must be a string literal (or otherwise outlive the trace).
+//	Every TRACE_BEGIN() must be matched by a TRACE_END() on the same thread.
+#define TRACE_BEGIN(name) do { if (SDL_AtomicGet(&trace_enabled)) trace_begin(name); } while (0)
+#define TRACE_END() do { if (SDL_AtomicGet(&trace_enabled)) trace_end(); } while (0)
+
+
+extern SDL_atomic_t trace_enabled;	// Read by every thread, only set by trace_start() and trace_stop()
+
+
+//	Starts recording spans, discarding anything recorded before
+//	
+//	Should only be called from one thread, the same as `trace_stop()`.
+void trace_start();
+
+//	Stops recording and writes everything recorded to a trace file
+//	
+//	Returns 0 on success, 1 otherwise.
+int trace_stop(const char *filename);
+
+//	Opens a span on the calling thread (use TRACE_BEGIN instead)
+//	
+void trace_begin(const char *name);
+
+//	Closes the innermost open span on the calling thread (use TRACE_END instead)
+//	
+void trace_end();
+
+//	Frees every thread's trace buffer
+//	
+//	Buffers are otherwise kept for the life of the program, and those
+//	of exited threads are taken over by new ones. Must only be called
+//	once every other thread that recorded spans has exited.
+void trace_term();
+
+#endif